@@ -0,0 +1,52 @@
+#ifndef ALIGNED_ALLOCATOR_HPP
+#define ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * std::allocator that over-aligns every allocation, so arrays split across threads at multiples of
+ * ALIGNMENT bytes never share a cache line between two of them.
+ */
+template <typename T, size_t ALIGNMENT>
+struct AlignedAllocator
+{
+    static_assert(ALIGNMENT >= alignof(T) && (ALIGNMENT & (ALIGNMENT - 1u)) == 0u, "Alignment must be a power of two of at least alignof(T)");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, ALIGNMENT>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, ALIGNMENT>&) {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ALIGNMENT}));
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        ::operator delete(ptr, std::align_val_t{ALIGNMENT});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, ALIGNMENT>&) const { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, ALIGNMENT>&) const { return false; }
+};
+
+constexpr size_t CACHE_LINE_SIZE = 64u;
+
+template <typename T>
+using CacheAlignedVector = std::vector<T, AlignedAllocator<T, CACHE_LINE_SIZE>>;
+
+#endif // ALIGNED_ALLOCATOR_HPP
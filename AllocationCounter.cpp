@@ -0,0 +1,74 @@
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+
+namespace
+{
+    thread_local uint64_t t_uAllocationCount = 0u;
+
+    void* countedAlloc(std::size_t nbytes)
+    {
+        ++t_uAllocationCount;
+
+        void* ptr = malloc(nbytes == 0u ? 1u : nbytes);
+        if (ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+
+    void* countedAlignedAlloc(std::size_t nbytes, std::align_val_t alignment)
+    {
+        ++t_uAllocationCount;
+
+        const std::size_t align = static_cast<std::size_t>(alignment);
+        void* ptr = aligned_alloc(align, (nbytes + align - 1u) / align * align);
+        if (ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+}
+
+uint64_t AllocationCounter::getThreadCount()
+{
+    return t_uAllocationCount;
+}
+
+void* operator new(std::size_t nbytes) { return countedAlloc(nbytes); }
+void* operator new[](std::size_t nbytes) { return countedAlloc(nbytes); }
+void* operator new(std::size_t nbytes, std::align_val_t alignment) { return countedAlignedAlloc(nbytes, alignment); }
+void* operator new[](std::size_t nbytes, std::align_val_t alignment) { return countedAlignedAlloc(nbytes, alignment); }
+
+void* operator new(std::size_t nbytes, const std::nothrow_t&) noexcept
+{
+    ++t_uAllocationCount;
+    return malloc(nbytes == 0u ? 1u : nbytes);
+}
+
+void* operator new[](std::size_t nbytes, const std::nothrow_t&) noexcept
+{
+    ++t_uAllocationCount;
+    return malloc(nbytes == 0u ? 1u : nbytes);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+#else
+
+uint64_t AllocationCounter::getThreadCount()
+{
+    return 0u;
+}
+
+#endif
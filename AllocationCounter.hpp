@@ -0,0 +1,39 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cassert>
+#include <cstdint>
+
+/**
+ * Debug builds replace the global operator new to count heap allocations per thread, so code that must not
+ * allocate in the steady state (the per-frame render queue) can assert it. Allocations made by the Vulkan
+ * driver or layers through operator new on the same thread are counted too, keep checked scopes free of
+ * Vulkan calls. In release builds the count is always 0 and the checks compile away.
+ */
+namespace AllocationCounter
+{
+    // operator new calls made by the calling thread so far
+    uint64_t getThreadCount();
+
+    class ScopedCheck
+    {
+    private:
+        uint64_t m_uStart;
+        bool m_bEnabled;
+
+    public:
+        explicit ScopedCheck(bool enabled = true)
+            : m_uStart{getThreadCount()}, m_bEnabled{enabled}
+        {
+        }
+
+        ~ScopedCheck()
+        {
+            assert((!m_bEnabled || getThreadCount() == m_uStart) && "Heap allocation in a scope that must not allocate!");
+        }
+
+        uint64_t getAllocations() const { return getThreadCount() - m_uStart; }
+    };
+}
+
+#endif // ALLOCATION_COUNTER_HPP
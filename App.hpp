@@ -8,8 +8,12 @@
 
 #include "Model.hpp"
 #include "VkFrame.hpp"
+#include "ThreadPool.hpp"
 #include "Renderer/RenderManager.hpp"
 #include "Renderer/PipelineManager.hpp"
+#include "Visibility/ClusterCuller.hpp"
+#include "Visibility/OcclusionCuller.hpp"
+#include "Visibility/SceneVisibility.hpp"
 
 class GLFWwindow;
 
@@ -27,6 +31,18 @@ struct SceneResources
     RenderManager renderer;
 
     std::vector<Model> m_vModels;
+
+    // Bounds of m_vModels, static ones in a BVH built after loading, ids are model indices
+    SceneVisibility visibility;
+
+    // Runs on the frustum culling result, occluders are the visible models with an occluder mesh
+    OcclusionCuller occlusionCuller;
+
+    // Meshlets of the models drawn at full detail, immediate render modes only
+    ClusterCuller clusterCuller;
+
+    // Identity until a camera drives it, the frustum is then exactly the clip volume
+    glm::mat4 m_m4ViewProjection { 1.0f };
     std::array<VkPipelineLayout, PIPELINE_COUNT> m_vVkPipelineLayouts;
     std::array<VkPipeline, PIPELINE_COUNT> m_vVkPipelines;
 
@@ -44,6 +60,9 @@ struct AppResources
 
     std::array<VkFrame, 2> m_Frames;
     uint32_t m_uFrameIdx;
+
+    ThreadPool m_ThreadPool;
+    bool m_bParallelRecording;
 };
 
 VkPipelineLayout createDefaultGraphicsPipelineLayout(VkDevice device);
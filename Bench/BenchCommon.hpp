@@ -0,0 +1,71 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace Bench
+{
+    // Keeps the compiler from discarding a value that is computed only for timing
+    template <typename T>
+    inline void doNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    // Runs fn iterations times after one warm-up run and returns the fastest run in milliseconds
+    template <typename F>
+    double measureMs(uint32_t iterations, F&& fn)
+    {
+        fn();
+
+        double best = 1e30;
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        return best;
+    }
+
+    // Small deterministic generator so every run of a benchmark sees the same scene
+    struct Random
+    {
+        uint64_t m_uState;
+
+        explicit Random(uint64_t seed) : m_uState{seed ? seed : 0x9E3779B97F4A7C15ull} {}
+
+        uint32_t next()
+        {
+            m_uState ^= m_uState << 13;
+            m_uState ^= m_uState >> 7;
+            m_uState ^= m_uState << 17;
+            return static_cast<uint32_t>(m_uState >> 32);
+        }
+
+        uint32_t next(uint32_t bound) { return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32); }
+        float nextFloat() { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+    };
+
+    inline void printHeader(const char* name)
+    {
+        printf("== %s\n", name);
+    }
+
+    inline void printResult(const char* label, double ms, uint32_t count)
+    {
+        printf("  %-32s %9.3f ms  %8.2f ns/item\n", label, ms, ms * 1e6 / count);
+    }
+}
+
+#endif // BENCH_COMMON_HPP
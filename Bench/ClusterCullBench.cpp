@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Geometry/MeshletBuilder.hpp"
+#include "../Geometry/MeshOptimizer.hpp"
+#include "../Visibility/ClusterCuller.hpp"
+#include "../Visibility/Frustum.hpp"
+
+/**
+ * Meshlet culling on a field of spheres, split and ordered the way the loader does it. Reports the meshlet
+ * sizes, the triangles left after per-model frustum culling and after culling per meshlet, for a perspective
+ * camera inside the field and an orthographic one above it, and the time per meshlet tested.
+ *
+ * Fails when a meshlet breaks the size limits or when a culled meshlet had a triangle that faces the camera
+ * and is not entirely outside one frustum plane, so it can run as a check on machines without a GPU.
+ */
+namespace
+{
+    constexpr uint32_t ITERATIONS = 20u;
+
+    constexpr uint32_t GRID_SIZE = 24u;
+    constexpr float GRID_SPACING = 6.0f;
+    constexpr float SPHERE_RADIUS = 2.0f;
+    constexpr uint32_t SPHERE_RINGS = 48u;
+    constexpr uint32_t SPHERE_SEGMENTS = 96u;
+
+    // Every few models get a non-uniform scale, which the cone test has to skip
+    constexpr uint32_t NON_UNIFORM_INTERVAL = 8u;
+
+    struct Mesh
+    {
+        std::vector<glm::vec3> m_vPositions;
+        std::vector<uint32_t> m_vIndices;
+        std::vector<Meshlet> m_vMeshlets;
+        float m_fRadius;
+    };
+
+    struct Instance
+    {
+        glm::mat4 m_m4Transform;
+        glm::vec3 m_v3Center;
+        float m_fRadius;
+    };
+
+    Mesh createSphere()
+    {
+        const float pi = 3.14159265358979f;
+
+        Mesh mesh;
+        mesh.m_fRadius = SPHERE_RADIUS;
+
+        for (uint32_t ring = 0; ring <= SPHERE_RINGS; ++ring)
+        {
+            for (uint32_t segment = 0; segment <= SPHERE_SEGMENTS; ++segment)
+            {
+                const float theta = pi * static_cast<float>(ring) / SPHERE_RINGS;
+                const float phi = 2.0f * pi * static_cast<float>(segment % SPHERE_SEGMENTS) / SPHERE_SEGMENTS;
+                mesh.m_vPositions.push_back(SPHERE_RADIUS * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+            }
+        }
+
+        // Counter-clockwise seen from outside, like glTF
+        for (uint32_t ring = 0; ring < SPHERE_RINGS; ++ring)
+        {
+            for (uint32_t segment = 0; segment < SPHERE_SEGMENTS; ++segment)
+            {
+                const uint32_t v0 = ring * (SPHERE_SEGMENTS + 1u) + segment;
+                const uint32_t v1 = v0 + 1u;
+                const uint32_t v2 = v0 + SPHERE_SEGMENTS + 1u;
+                const uint32_t v3 = v2 + 1u;
+
+                if (ring != 0u)
+                    mesh.m_vIndices.insert(mesh.m_vIndices.end(), { v0, v1, v2 });
+                if (ring + 1u != SPHERE_RINGS)
+                    mesh.m_vIndices.insert(mesh.m_vIndices.end(), { v1, v3, v2 });
+            }
+        }
+
+        // Triangle order of the loader
+        const uint32_t indexCount = static_cast<uint32_t>(mesh.m_vIndices.size());
+        const uint32_t vertexCount = static_cast<uint32_t>(mesh.m_vPositions.size());
+        std::vector<uint32_t> cacheOrder(indexCount);
+        MeshOptimizer::optimizeVertexCache(cacheOrder.data(), mesh.m_vIndices.data(), indexCount, vertexCount);
+        MeshOptimizer::optimizeOverdraw(mesh.m_vIndices.data(), cacheOrder.data(), indexCount, &mesh.m_vPositions.data()->x, vertexCount, 3u, 1.05f);
+
+        MeshletBuilder::build(mesh.m_vMeshlets, mesh.m_vIndices.data(), indexCount, &mesh.m_vPositions.data()->x, vertexCount, 3u, false);
+        return mesh;
+    }
+
+    std::vector<Instance> createInstances()
+    {
+        Bench::Random random(GRID_SIZE);
+
+        std::vector<Instance> instances;
+        for (uint32_t z = 0; z < GRID_SIZE; ++z)
+        {
+            for (uint32_t x = 0; x < GRID_SIZE; ++x)
+            {
+                const glm::vec3 position((static_cast<float>(x) - GRID_SIZE * 0.5f) * GRID_SPACING, 0.0f, -static_cast<float>(z) * GRID_SPACING);
+                const glm::vec3 axis = glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat()) + 0.1f;
+
+                glm::vec3 scale(0.5f + random.nextFloat());
+                if (instances.size() % NON_UNIFORM_INTERVAL == 0u)
+                    scale.y *= 1.5f;
+
+                glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+                transform = glm::rotate(transform, random.nextFloat() * 6.28f, axis);
+                transform = glm::scale(transform, scale);
+
+                instances.push_back({ transform, position, SPHERE_RADIUS * std::max(scale.x, std::max(scale.y, scale.z)) });
+            }
+        }
+
+        return instances;
+    }
+
+    bool isOutside(const Frustum& frustum, const glm::vec3& center, float radius)
+    {
+        for (const glm::vec4& plane : frustum.m_vPlanes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return true;
+        }
+        return false;
+    }
+
+    // Brute force over the triangles of a culled meshlet: each has to face away or lie behind one plane
+    bool isCullCorrect(const Mesh& mesh, const Meshlet& meshlet, const glm::mat4& transform, const Frustum& frustum, const glm::vec4& camera)
+    {
+        for (uint32_t i = meshlet.m_uFirstIndex; i < meshlet.m_uFirstIndex + meshlet.m_uIndexCount; i += 3u)
+        {
+            glm::vec3 p[3];
+            for (uint32_t corner = 0; corner < 3u; ++corner)
+                p[corner] = glm::vec3(transform * glm::vec4(mesh.m_vPositions[mesh.m_vIndices[i + corner]], 1.0f));
+
+            bool outside = false;
+            for (const glm::vec4& plane : frustum.m_vPlanes)
+            {
+                bool behind = true;
+                for (uint32_t corner = 0; corner < 3u; ++corner)
+                    behind &= glm::dot(glm::vec3(plane), p[corner]) + plane.w < 0.0f;
+                outside |= behind;
+            }
+
+            const glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const glm::vec3 view = camera.w != 0.0f ? p[0] - glm::vec3(camera) / camera.w : glm::vec3(camera);
+            const bool backfacing = glm::dot(normal, view) >= -1e-4f * glm::length(normal) * glm::length(view);
+
+            if (!outside && !backfacing)
+                return false;
+        }
+        return true;
+    }
+
+    struct Result
+    {
+        uint32_t m_uModels = 0u;
+        uint32_t m_uVisibleModels = 0u;
+        uint32_t m_uTriangles = 0u;
+        uint32_t m_uModelTriangles = 0u; // after per-model frustum culling
+        ClusterCuller::Stats m_Stats;
+        bool m_bCorrect = true;
+    };
+
+    Result run(const Mesh& mesh, const std::vector<Instance>& instances, const glm::mat4& viewProjection, ClusterCuller& culler, std::vector<uint32_t>& visible, bool verify)
+    {
+        const Frustum frustum = Frustum::fromViewProjection(viewProjection);
+        const uint32_t meshletCount = static_cast<uint32_t>(mesh.m_vMeshlets.size());
+        const uint32_t triangleCount = static_cast<uint32_t>(mesh.m_vIndices.size()) / 3u;
+
+        Result result;
+        culler.begin(viewProjection);
+
+        for (const Instance& instance : instances)
+        {
+            ++result.m_uModels;
+            result.m_uTriangles += triangleCount;
+            if (isOutside(frustum, instance.m_v3Center, instance.m_fRadius))
+                continue;
+
+            ++result.m_uVisibleModels;
+            result.m_uModelTriangles += triangleCount;
+
+            const uint32_t visibleCount = culler.cull(mesh.m_vMeshlets.data(), meshletCount, instance.m_m4Transform, visible.data());
+            if (!verify)
+                continue;
+
+            // Visible indices are ascending, everything in between was culled
+            const glm::vec4 camera = glm::inverse(viewProjection) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+            uint32_t next = 0u;
+            for (uint32_t m = 0; m < meshletCount; ++m)
+            {
+                if (next < visibleCount && visible[next] == m)
+                    ++next;
+                else
+                    result.m_bCorrect &= isCullCorrect(mesh, mesh.m_vMeshlets[m], instance.m_m4Transform, frustum, camera);
+            }
+        }
+
+        result.m_Stats = culler.getStats();
+        return result;
+    }
+}
+
+int main()
+{
+    const Mesh mesh = createSphere();
+    const std::vector<Instance> instances = createInstances();
+
+    bool passed = true;
+
+    // Limits, and the meshlets cover the indices in order
+    uint32_t nextIndex = 0u;
+    uint32_t vertexSum = 0u;
+    uint32_t coneCount = 0u;
+    for (const Meshlet& meshlet : mesh.m_vMeshlets)
+    {
+        passed &= meshlet.m_uFirstIndex == nextIndex && meshlet.m_uVertexCount <= MeshletBuilder::MAX_VERTICES && meshlet.m_uIndexCount <= MeshletBuilder::MAX_TRIANGLES * 3u;
+        nextIndex += meshlet.m_uIndexCount;
+        vertexSum += meshlet.m_uVertexCount;
+        coneCount += meshlet.m_fConeCutoff < 1.0f ? 1u : 0u;
+    }
+    passed &= nextIndex == mesh.m_vIndices.size();
+
+    const uint32_t meshletCount = static_cast<uint32_t>(mesh.m_vMeshlets.size());
+    Bench::printHeader("meshlets");
+    printf("  %u triangles in %u meshlets, %.1f triangles and %.1f vertices each, %u with a cone%s\n",
+           static_cast<uint32_t>(mesh.m_vIndices.size()) / 3u, meshletCount, mesh.m_vIndices.size() / 3.0 / meshletCount,
+           static_cast<double>(vertexSum) / meshletCount, coneCount, passed ? "" : " (LIMITS BROKEN)");
+
+    const double buildMs = Bench::measureMs(ITERATIONS, [&]() {
+        std::vector<Meshlet> meshlets;
+        MeshletBuilder::build(meshlets, mesh.m_vIndices.data(), static_cast<uint32_t>(mesh.m_vIndices.size()), &mesh.m_vPositions.data()->x,
+                              static_cast<uint32_t>(mesh.m_vPositions.size()), 3u, false);
+        Bench::doNotOptimize(meshlets.data());
+    });
+    Bench::printResult("build", buildMs, meshletCount);
+
+    struct View
+    {
+        const char* m_pName;
+        glm::mat4 m_m4ViewProjection;
+    };
+
+    const float fieldDepth = GRID_SIZE * GRID_SPACING;
+    const View views[] = {
+        { "perspective, inside the field",
+          glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f) *
+          glm::lookAt(glm::vec3(0.0f, 3.0f, 8.0f), glm::vec3(10.0f, 0.0f, -fieldDepth * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)) },
+        // Looking down, depth 0 to 1 over 100 units
+        { "orthographic, from above",
+          glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / 40.0f, 1.0f / 40.0f, -1.0f / 100.0f)) *
+          glm::lookAt(glm::vec3(0.0f, 50.0f, -fieldDepth * 0.5f), glm::vec3(0.0f, 0.0f, -fieldDepth * 0.5f), glm::vec3(0.0f, 0.0f, -1.0f)) },
+    };
+
+    ClusterCuller culler;
+    std::vector<uint32_t> visible(meshletCount);
+
+    for (const View& view : views)
+    {
+        const Result result = run(mesh, instances, view.m_m4ViewProjection, culler, visible, true);
+        passed &= result.m_bCorrect;
+
+        const ClusterCuller::Stats& stats = result.m_Stats;
+        Bench::printHeader(view.m_pName);
+        printf("  models %u of %u visible\n", result.m_uVisibleModels, result.m_uModels);
+        printf("  triangles: %u total, %u after model culling, %u after meshlet culling (%.1f%% of the model culled ones)%s\n",
+               result.m_uTriangles, result.m_uModelTriangles, stats.m_uVisibleTriangles,
+               result.m_uModelTriangles == 0u ? 0.0 : 100.0 * stats.m_uVisibleTriangles / result.m_uModelTriangles,
+               result.m_bCorrect ? "" : " (VISIBLE TRIANGLES CULLED)");
+        printf("  meshlets: %u tested, %u outside the frustum, %u facing away\n", stats.m_uMeshlets, stats.m_uFrustumCulled, stats.m_uBackfaceCulled);
+
+        const double cullMs = Bench::measureMs(ITERATIONS, [&]() {
+            Bench::doNotOptimize(run(mesh, instances, view.m_m4ViewProjection, culler, visible, false));
+        });
+        Bench::printResult("cull", cullMs, std::max(stats.m_uMeshlets, 1u));
+    }
+
+    return passed ? 0 : 1;
+}
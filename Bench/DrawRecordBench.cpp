@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+#include "BenchCommon.hpp"
+#include "../Renderer/Renderable.hpp"
+#include "../Renderer/GeometryTable.hpp"
+
+/**
+ * Compares the per-frame cost of the old Renderable (two StaticBuffer references, not assignable) with the
+ * handle-based 32 byte record: gathering the frame's draws, ordering them by geometry and walking
+ * them the way the recorder does. Bytes touched per draw are measured by collecting the cache lines each walk
+ * reads, so the pointer chase into the StaticBuffers shows up next to the size of the record itself.
+ */
+namespace
+{
+    constexpr uint32_t PROTOTYPE_COUNT = 512u;
+    constexpr uint32_t PRIMITIVES_PER_PROTOTYPE = 4u;
+    constexpr uint32_t DRAW_COUNT = 200000u;
+    constexpr uint32_t ITERATIONS = 20u;
+    constexpr uintptr_t CACHE_LINE = 64u;
+
+    // Same layout as StaticBuffer, kept here so the benchmark does not need a device
+    struct LegacyBuffer
+    {
+        VkBuffer m_vkBuffer;
+        VkDeviceMemory m_vkBufferMemory;
+        VkMemoryPropertyFlags m_vkBufferMemProps;
+        bool m_bDestroyed;
+        bool m_bCreated;
+    };
+
+    struct LegacyPrototype
+    {
+        LegacyBuffer m_VertexBuffer;
+        LegacyBuffer m_IndexBuffer;
+        std::vector<VkImage> m_VkImages; // keeps the two buffers of different prototypes on separate lines
+    };
+
+    // Renderable before the geometry table
+    struct LegacyRenderable
+    {
+        const LegacyBuffer& m_IndexBuffer;
+        const LegacyBuffer& m_VertexBuffer;
+
+        VkDescriptorSet descriptorSet;
+
+        uint32_t primitive;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+
+        LegacyRenderable(const LegacyBuffer& indexBuffer, const LegacyBuffer& vertexBuffer)
+            : m_IndexBuffer{indexBuffer}, m_VertexBuffer{vertexBuffer}
+        {}
+    };
+
+    struct CacheLineCounter
+    {
+        std::unordered_set<uintptr_t> m_Lines;
+
+        void touch(const void* ptr, size_t nbytes)
+        {
+            const uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) / CACHE_LINE;
+            const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + nbytes - 1u) / CACHE_LINE;
+            for (uintptr_t line = begin; line <= end; ++line)
+                m_Lines.insert(line);
+        }
+
+        double bytesPerDraw(uint32_t drawCount) const { return static_cast<double>(m_Lines.size() * CACHE_LINE) / drawCount; }
+    };
+
+    uint64_t handleBits(VkBuffer buffer)
+    {
+        uint64_t bits = 0u;
+        memcpy(&bits, &buffer, std::min(sizeof(bits), sizeof(buffer)));
+        return bits;
+    }
+
+    VkBuffer fakeHandle(uint64_t value)
+    {
+        VkBuffer buffer {};
+        memcpy(&buffer, &value, std::min(sizeof(value), sizeof(buffer)));
+        return buffer;
+    }
+}
+
+int main()
+{
+    Bench::printHeader("DrawRecordBench");
+    printf("  %u draws over %u prototypes x %u primitives\n", DRAW_COUNT, PROTOTYPE_COUNT, PRIMITIVES_PER_PROTOTYPE);
+    printf("  sizeof legacy Renderable %zu bytes, sizeof Renderable %zu bytes\n\n", sizeof(LegacyRenderable), sizeof(Renderable));
+
+    // Scene setup, each prototype is its own heap allocation like the shared_ptr<ModelPrototype> in the loader
+    std::vector<std::unique_ptr<LegacyPrototype>> prototypes;
+    std::vector<LegacyRenderable> legacyPrimitives;
+    std::vector<Renderable> primitives;
+
+    for (uint32_t p = 0; p < PROTOTYPE_COUNT; ++p)
+    {
+        prototypes.push_back(std::make_unique<LegacyPrototype>());
+        LegacyPrototype& prototype = *prototypes.back();
+        prototype.m_IndexBuffer.m_vkBuffer = fakeHandle(2u * p + 1u);
+        prototype.m_VertexBuffer.m_vkBuffer = fakeHandle(2u * p + 2u);
+
+        const uint32_t geometry = GeometryTable::add(prototype.m_IndexBuffer.m_vkBuffer, prototype.m_VertexBuffer.m_vkBuffer, VK_INDEX_TYPE_UINT32);
+
+        for (uint32_t i = 0; i < PRIMITIVES_PER_PROTOTYPE; ++i)
+        {
+            LegacyRenderable legacy { prototype.m_IndexBuffer, prototype.m_VertexBuffer };
+            legacy.descriptorSet = VK_NULL_HANDLE;
+            legacy.primitive = p * PRIMITIVES_PER_PROTOTYPE + i;
+            legacy.indexCount = 36u * (i + 1u);
+            legacy.firstIndex = 36u * i;
+            legacy.vertexOffset = static_cast<int32_t>(24u * i);
+            legacyPrimitives.push_back(legacy);
+
+            Renderable renderable {};
+            renderable.geometry = geometry;
+            renderable.primitive = legacy.primitive;
+            renderable.indexCount = legacy.indexCount;
+            renderable.firstIndex = legacy.firstIndex;
+            renderable.vertexOffset = legacy.vertexOffset;
+            primitives.push_back(renderable);
+        }
+    }
+
+    Bench::Random random { 42u };
+    std::vector<uint32_t> submissions(DRAW_COUNT);
+    for (uint32_t& submission : submissions)
+        submission = random.next(static_cast<uint32_t>(primitives.size()));
+
+    // Per-frame draw arrays
+    std::vector<LegacyRenderable> legacyDraws;
+    std::vector<uint32_t> legacyOrder(DRAW_COUNT);
+    std::vector<Renderable> draws;
+    legacyDraws.reserve(DRAW_COUNT);
+    draws.reserve(DRAW_COUNT);
+
+    // Gather: the old record can only be copy constructed one at a time
+    const double legacyGatherMs = Bench::measureMs(ITERATIONS, [&]() {
+        legacyDraws.clear();
+        for (uint32_t submission : submissions)
+            legacyDraws.push_back(legacyPrimitives[submission]);
+        Bench::doNotOptimize(legacyDraws.data());
+    });
+
+    const double gatherMs = Bench::measureMs(ITERATIONS, [&]() {
+        draws.resize(DRAW_COUNT);
+        for (uint32_t i = 0; i < DRAW_COUNT; ++i)
+            memcpy(&draws[i], &primitives[submissions[i]], sizeof(Renderable));
+        Bench::doNotOptimize(draws.data());
+    });
+
+    // Order by buffers: non-assignable records are sorted through an index array keyed by a pointer chase
+    const double legacySortMs = Bench::measureMs(ITERATIONS, [&]() {
+        std::iota(legacyOrder.begin(), legacyOrder.end(), 0u);
+        std::sort(legacyOrder.begin(), legacyOrder.end(), [&](uint32_t lhs, uint32_t rhs) {
+            return handleBits(legacyDraws[lhs].m_VertexBuffer.m_vkBuffer) < handleBits(legacyDraws[rhs].m_VertexBuffer.m_vkBuffer);
+        });
+        Bench::doNotOptimize(legacyOrder.data());
+    });
+
+    std::vector<Renderable> unsortedDraws = draws;
+    const double sortMs = Bench::measureMs(ITERATIONS, [&]() {
+        memcpy(draws.data(), unsortedDraws.data(), DRAW_COUNT * sizeof(Renderable));
+        std::sort(draws.begin(), draws.end(), [](const Renderable& lhs, const Renderable& rhs) {
+            return lhs.geometry < rhs.geometry;
+        });
+        Bench::doNotOptimize(draws.data());
+    });
+
+    // Walk: what the recorder reads per draw
+    auto legacyWalk = [&](CacheLineCounter* counter) {
+        uint64_t checksum = 0u;
+        for (const uint32_t& idx : legacyOrder)
+        {
+            const LegacyRenderable& draw = legacyDraws[idx];
+            checksum += handleBits(draw.m_IndexBuffer.m_vkBuffer) + handleBits(draw.m_VertexBuffer.m_vkBuffer);
+            checksum += draw.indexCount + draw.firstIndex + static_cast<uint32_t>(draw.vertexOffset);
+
+            if (counter != nullptr)
+            {
+                counter->touch(&idx, sizeof(idx));
+                counter->touch(&draw, sizeof(draw));
+                counter->touch(&draw.m_IndexBuffer, sizeof(LegacyBuffer));
+                counter->touch(&draw.m_VertexBuffer, sizeof(LegacyBuffer));
+            }
+        }
+        return checksum;
+    };
+
+    auto walk = [&](CacheLineCounter* counter) {
+        uint64_t checksum = 0u;
+        for (const Renderable& draw : draws)
+        {
+            const GeometryTable::Geometry& geometry = GeometryTable::get(draw.geometry);
+            checksum += handleBits(geometry.m_VkIndexBuffer) + handleBits(geometry.m_VkVertexBuffer);
+            checksum += draw.indexCount + draw.firstIndex + static_cast<uint32_t>(draw.vertexOffset);
+
+            if (counter != nullptr)
+            {
+                counter->touch(&draw, sizeof(draw));
+                counter->touch(&geometry, sizeof(geometry));
+            }
+        }
+        return checksum;
+    };
+
+    const double legacyWalkMs = Bench::measureMs(ITERATIONS, [&]() { Bench::doNotOptimize(legacyWalk(nullptr)); });
+    const double walkMs = Bench::measureMs(ITERATIONS, [&]() { Bench::doNotOptimize(walk(nullptr)); });
+
+    CacheLineCounter legacyLines;
+    CacheLineCounter lines;
+    const bool match = legacyWalk(&legacyLines) == walk(&lines);
+
+    printf("  legacy Renderable\n");
+    Bench::printResult("gather", legacyGatherMs, DRAW_COUNT);
+    Bench::printResult("sort by buffers", legacySortMs, DRAW_COUNT);
+    Bench::printResult("walk", legacyWalkMs, DRAW_COUNT);
+    printf("  %-32s %9.1f bytes/draw\n\n", "bytes touched by walk", legacyLines.bytesPerDraw(DRAW_COUNT));
+
+    printf("  Renderable + GeometryTable\n");
+    Bench::printResult("gather", gatherMs, DRAW_COUNT);
+    Bench::printResult("sort by buffers", sortMs, DRAW_COUNT);
+    Bench::printResult("walk", walkMs, DRAW_COUNT);
+    printf("  %-32s %9.1f bytes/draw\n\n", "bytes touched by walk", lines.bytesPerDraw(DRAW_COUNT));
+
+    printf("  walk checksums %s\n", match ? "match" : "DIFFER");
+
+    return match ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Visibility/Frustum.hpp"
+#include "../Visibility/FrustumCuller.hpp"
+#include "../ThreadPool.hpp"
+
+/**
+ * Brute-force frustum culling of 100k to 1M objects scattered through a 1km cube, camera in the middle with
+ * a 60 degree perspective frustum. Every path the CPU supports is timed on the same scene and its visible
+ * list is compared against the scalar reference. The parallel cull is then timed with growing thread counts
+ * on the largest scene, speedup and efficiency are relative to the serial cull on the fastest path.
+ *
+ *   frustum_cull_bench [max thread count, default hardware_concurrency]
+ */
+namespace
+{
+    constexpr uint32_t OBJECT_COUNTS[] = { 100000u, 250000u, 1000000u };
+    constexpr uint32_t ITERATIONS = 50u;
+    constexpr float SCENE_HALF_SIZE = 500.0f;
+
+    constexpr FrustumCuller::Path PATHS[] = { FrustumCuller::Path::SCALAR, FrustumCuller::Path::SSE, FrustumCuller::Path::AVX2 };
+
+    constexpr uint32_t THREAD_COUNTS[] = { 1u, 2u, 4u, 6u, 8u, 12u, 16u, 24u, 32u, 64u };
+    constexpr uint32_t SCALING_OBJECT_COUNT = 1000000u;
+
+    void makeScene(FrustumCuller& culler, uint32_t objectCount)
+    {
+        Bench::Random random(objectCount);
+
+        culler.clear();
+        culler.reserve(objectCount);
+
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            const glm::vec3 center((random.nextFloat() * 2.0f - 1.0f) * SCENE_HALF_SIZE,
+                                   (random.nextFloat() * 2.0f - 1.0f) * SCENE_HALF_SIZE,
+                                   (random.nextFloat() * 2.0f - 1.0f) * SCENE_HALF_SIZE);
+            const glm::vec3 extents(0.5f + random.nextFloat() * 4.5f, 0.5f + random.nextFloat() * 4.5f, 0.5f + random.nextFloat() * 4.5f);
+
+            // Somewhere between the inscribed and the circumscribed sphere, so both volumes decide some objects
+            const float radius = glm::length(extents) * (0.6f + random.nextFloat() * 0.4f);
+
+            culler.add(center, extents, radius);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t maxThreadCount = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : std::max(std::thread::hardware_concurrency(), 1u);
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.3f, 0.1f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = Frustum::fromViewProjection(projection * view);
+
+    FrustumCuller culler;
+    std::vector<uint32_t> reference;
+    std::vector<uint32_t> visible;
+
+    for (uint32_t objectCount : OBJECT_COUNTS)
+    {
+        makeScene(culler, objectCount);
+        reference.resize(objectCount);
+        visible.resize(objectCount);
+
+        const uint32_t referenceCount = culler.cull(frustum, reference.data(), FrustumCuller::Path::SCALAR);
+
+        char header[96];
+        snprintf(header, sizeof(header), "Frustum culling, %u objects, %u visible", objectCount, referenceCount);
+        Bench::printHeader(header);
+
+        for (FrustumCuller::Path path : PATHS)
+        {
+            if (!FrustumCuller::isPathSupported(path))
+            {
+                printf("  %-32s not supported on this CPU\n", FrustumCuller::getPathName(path));
+                continue;
+            }
+
+            uint32_t visibleCount = 0u;
+            const double ms = Bench::measureMs(ITERATIONS, [&]() {
+                visibleCount = culler.cull(frustum, visible.data(), path);
+                Bench::doNotOptimize(visibleCount);
+            });
+
+            // FMA rounding may flip an object that exactly touches a plane, anything more is a bug
+            uint32_t mismatches = visibleCount > referenceCount ? visibleCount - referenceCount : referenceCount - visibleCount;
+            for (uint32_t i = 0; i < std::min(visibleCount, referenceCount); ++i)
+                mismatches += visible[i] != reference[i] ? 1u : 0u;
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s (%u mismatches)", FrustumCuller::getPathName(path), mismatches);
+            Bench::printResult(label, ms, objectCount);
+        }
+    }
+
+    makeScene(culler, SCALING_OBJECT_COUNT);
+    reference.resize(SCALING_OBJECT_COUNT);
+    visible.resize(SCALING_OBJECT_COUNT);
+
+    const FrustumCuller::Path path = FrustumCuller::getBestPath();
+    const uint32_t referenceCount = culler.cull(frustum, reference.data(), path);
+    const double serialMs = Bench::measureMs(ITERATIONS, [&]() { Bench::doNotOptimize(culler.cull(frustum, visible.data(), path)); });
+
+    char header[96];
+    snprintf(header, sizeof(header), "Parallel frustum culling, %u objects, %s, chunks of %u", SCALING_OBJECT_COUNT, FrustumCuller::getPathName(path), FrustumCuller::DEFAULT_CHUNK_SIZE);
+    Bench::printHeader(header);
+    printf("  %-32s %9.3f ms\n", "serial", serialMs);
+
+    FrustumCuller::ParallelScratch scratch;
+
+    for (uint32_t threadCount : THREAD_COUNTS)
+    {
+        if (threadCount > maxThreadCount)
+            break;
+
+        ThreadPool threadPool(threadCount);
+
+        uint32_t visibleCount = 0u;
+        const double ms = Bench::measureMs(ITERATIONS, [&]() {
+            visibleCount = culler.cull(frustum, visible.data(), threadPool, scratch);
+            Bench::doNotOptimize(visibleCount);
+        });
+
+        const bool matches = visibleCount == referenceCount && memcmp(visible.data(), reference.data(), visibleCount * sizeof(uint32_t)) == 0;
+        const double speedup = serialMs / ms;
+
+        printf("  %2u threads %21s %9.3f ms  %5.2fx  %5.1f%% efficiency%s\n", threadCount, "", ms, speedup, 100.0 * speedup / threadCount,
+               matches ? "" : "  MISMATCH");
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "BenchCommon.hpp"
+#include "../Geometry/IndexConversion.hpp"
+
+/**
+ * Index conversions of the loader on 3M indices (a million triangles) below 65536: 16 and 8 bit glTF indices
+ * widened to 32 bits one push_back at a time, as the loader used to, and in bulk, then the narrowing back to
+ * 16 bits for the index buffer. Every bulk result has to match the scalar one.
+ */
+namespace
+{
+    constexpr uint32_t INDEX_COUNT = 3000000u;
+    constexpr uint32_t VERTEX_COUNT = 60000u;
+    constexpr uint32_t ITERATIONS = 20u;
+}
+
+int main()
+{
+    Bench::Random random(INDEX_COUNT);
+
+    std::vector<uint16_t> shortIndices(INDEX_COUNT);
+    std::vector<uint8_t> byteIndices(INDEX_COUNT);
+    for (uint32_t i = 0; i < INDEX_COUNT; ++i)
+    {
+        shortIndices[i] = static_cast<uint16_t>(random.next(VERTEX_COUNT));
+        byteIndices[i] = static_cast<uint8_t>(shortIndices[i]);
+    }
+
+    std::vector<uint32_t> reference(INDEX_COUNT);
+    for (uint32_t i = 0; i < INDEX_COUNT; ++i)
+        reference[i] = shortIndices[i];
+
+    bool passed = true;
+    char label[64];
+
+    Bench::printHeader("Index conversion, 3M indices");
+
+    std::vector<uint32_t> pushed;
+    const double pushBackMs = Bench::measureMs(ITERATIONS, [&]() {
+        pushed.clear();
+        for (uint32_t i = 0; i < INDEX_COUNT; ++i)
+            pushed.push_back(shortIndices[i]);
+        Bench::doNotOptimize(pushed.data());
+    });
+    Bench::printResult("16 -> 32, push_back", pushBackMs, INDEX_COUNT);
+
+    std::vector<uint32_t> widened(INDEX_COUNT);
+    const double widenMs = Bench::measureMs(ITERATIONS, [&]() {
+        IndexConversion::widen(widened.data(), shortIndices.data(), INDEX_COUNT);
+        Bench::doNotOptimize(widened.data());
+    });
+    const bool widenMatches = widened == reference;
+    passed &= widenMatches;
+    snprintf(label, sizeof(label), "16 -> 32, bulk (%.1fx)%s", pushBackMs / widenMs, widenMatches ? "" : " (MISMATCH)");
+    Bench::printResult(label, widenMs, INDEX_COUNT);
+
+    const double bytePushBackMs = Bench::measureMs(ITERATIONS, [&]() {
+        pushed.clear();
+        for (uint32_t i = 0; i < INDEX_COUNT; ++i)
+            pushed.push_back(byteIndices[i]);
+        Bench::doNotOptimize(pushed.data());
+    });
+    Bench::printResult("8 -> 32, push_back", bytePushBackMs, INDEX_COUNT);
+
+    const double byteWidenMs = Bench::measureMs(ITERATIONS, [&]() {
+        IndexConversion::widen(widened.data(), byteIndices.data(), INDEX_COUNT);
+        Bench::doNotOptimize(widened.data());
+    });
+    bool byteWidenMatches = true;
+    for (uint32_t i = 0; i < INDEX_COUNT; ++i)
+        byteWidenMatches &= widened[i] == byteIndices[i];
+    passed &= byteWidenMatches;
+    snprintf(label, sizeof(label), "8 -> 32, bulk (%.1fx)%s", bytePushBackMs / byteWidenMs, byteWidenMatches ? "" : " (MISMATCH)");
+    Bench::printResult(label, byteWidenMs, INDEX_COUNT);
+
+    std::vector<uint16_t> narrowed(INDEX_COUNT);
+    const double narrowMs = Bench::measureMs(ITERATIONS, [&]() {
+        IndexConversion::narrow(narrowed.data(), reference.data(), INDEX_COUNT);
+        Bench::doNotOptimize(narrowed.data());
+    });
+    const bool narrowMatches = narrowed == shortIndices;
+    passed &= narrowMatches;
+    snprintf(label, sizeof(label), "32 -> 16, bulk%s", narrowMatches ? "" : " (MISMATCH)");
+    Bench::printResult(label, narrowMs, INDEX_COUNT);
+
+    // The top of the range, where the biased pack is most likely to go wrong
+    const uint32_t edges[] = { 0u, 1u, 0x7FFFu, 0x8000u, 0x8001u, 0xFFFEu, 0xFFFFu, 0x1234u, 0u, 0xFFFFu, 0x8000u };
+    uint16_t edgesNarrowed[sizeof(edges) / sizeof(edges[0])];
+    IndexConversion::narrow(edgesNarrowed, edges, sizeof(edges) / sizeof(edges[0]));
+    bool edgesMatch = true;
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i)
+        edgesMatch &= edgesNarrowed[i] == edges[i];
+    passed &= edgesMatch;
+
+    printf("  index buffer: %.1f MB as 32 bit, %.1f MB as 16 bit%s\n", INDEX_COUNT * sizeof(uint32_t) / 1e6, INDEX_COUNT * sizeof(uint16_t) / 1e6,
+           edgesMatch ? "" : " (EDGE VALUES MISMATCH)");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Visibility/Bounds.hpp"
+#include "../Visibility/Lod.hpp"
+#include "../Geometry/MeshSimplifier.hpp"
+
+/**
+ * LOD chain of a bumpy sphere built the way the loader does it (half the triangles per level, error limit doubling
+ * from 1% of the radius), reporting triangles, error and simplification time per level. The levels have to stay
+ * free of degenerate triangles and within their error limit.
+ *
+ * Then 10k instances of it spread from 5 to 500 units in front of the camera pick their LOD by screen size,
+ * comparing the triangles drawn with LOD 0 everywhere.
+ */
+namespace
+{
+    constexpr uint32_t RINGS = 192u;
+    constexpr uint32_t SEGMENTS = 384u;
+    constexpr uint32_t LOD_COUNT = 4u;
+    constexpr float BASE_ERROR = 0.01f;
+    constexpr uint32_t ITERATIONS = 3u;
+
+    constexpr uint32_t INSTANCE_COUNT = 10000u;
+    constexpr float MIN_DISTANCE = 5.0f;
+    constexpr float MAX_DISTANCE = 500.0f;
+
+    // Seam and pole vertices are duplicated with identical positions, as exporters write them
+    void makeSphere(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+    {
+        const float pi = 3.14159265358979f;
+
+        for (uint32_t ring = 0; ring <= RINGS; ++ring)
+        {
+            for (uint32_t segment = 0; segment <= SEGMENTS; ++segment)
+            {
+                const float theta = pi * static_cast<float>(ring) / RINGS;
+                const float phi = 2.0f * pi * static_cast<float>(segment % SEGMENTS) / SEGMENTS;
+                const float radius = 1.0f + 0.03f * std::sin(6.0f * theta) * std::cos(8.0f * phi);
+
+                if (ring == 0u || ring == RINGS)
+                    positions.push_back(glm::vec3(0.0f, ring == 0u ? radius : -radius, 0.0f));
+                else
+                    positions.push_back(radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+            }
+        }
+
+        for (uint32_t ring = 0; ring < RINGS; ++ring)
+        {
+            for (uint32_t segment = 0; segment < SEGMENTS; ++segment)
+            {
+                const uint32_t v0 = ring * (SEGMENTS + 1u) + segment;
+                const uint32_t v1 = v0 + 1u;
+                const uint32_t v2 = v0 + SEGMENTS + 1u;
+                const uint32_t v3 = v2 + 1u;
+
+                if (ring != 0u)
+                    indices.insert(indices.end(), { v0, v1, v2 });
+                if (ring + 1u != RINGS)
+                    indices.insert(indices.end(), { v1, v3, v2 });
+            }
+        }
+    }
+
+    bool hasDegenerateTriangles(const std::vector<glm::vec3>& positions, const uint32_t* indices, uint32_t indexCount)
+    {
+        for (uint32_t i = 0; i < indexCount; i += 3u)
+        {
+            const glm::vec3 normal = glm::cross(positions[indices[i + 1u]] - positions[indices[i]], positions[indices[i + 2u]] - positions[indices[i]]);
+            if (glm::dot(normal, normal) == 0.0f)
+                return true;
+        }
+
+        return false;
+    }
+}
+
+int main()
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    makeSphere(positions, indices);
+
+    Aabb aabb;
+    for (const glm::vec3& position : positions)
+        aabb.expand(position);
+    const Bounds bounds = Bounds::fromPositions(aabb, &positions.data()->x, static_cast<uint32_t>(positions.size()), 3u);
+
+    std::vector<std::vector<uint32_t>> lods { indices };
+    std::vector<uint32_t> triangleCounts { static_cast<uint32_t>(indices.size()) / 3u };
+    bool passed = true;
+
+    Bench::printHeader("Mesh LOD chain");
+    printf("  LOD 0: %u triangles\n", triangleCounts[0]);
+
+    for (uint32_t lod = 1u; lod < LOD_COUNT; ++lod)
+    {
+        const std::vector<uint32_t>& previous = lods.back();
+        const uint32_t previousTriangleCount = static_cast<uint32_t>(previous.size()) / 3u;
+        const float maxError = bounds.m_fRadius * BASE_ERROR * static_cast<float>(1u << (lod - 1u));
+
+        std::vector<uint32_t> simplified(previous.size());
+        uint32_t indexCount = 0u;
+        float error = 0.0f;
+
+        const double ms = Bench::measureMs(ITERATIONS, [&]() {
+            indexCount = MeshSimplifier::simplify(simplified.data(), previous.data(), static_cast<uint32_t>(previous.size()), &positions.data()->x,
+                                                  static_cast<uint32_t>(positions.size()), 3u, static_cast<uint32_t>(previous.size()) / 6u * 3u, maxError, &error);
+        });
+
+        const bool valid = indexCount > 0u && error <= maxError && !hasDegenerateTriangles(positions, simplified.data(), indexCount);
+        passed &= valid;
+
+        simplified.resize(indexCount);
+        lods.push_back(std::move(simplified));
+        triangleCounts.push_back(indexCount / 3u);
+
+        char label[64];
+        snprintf(label, sizeof(label), "LOD %u: %u triangles, error %.4f%s", lod, indexCount / 3u, error, valid ? "" : " (INVALID)");
+        Bench::printResult(label, ms, previousTriangleCount);
+    }
+
+    // Distant-heavy scene, most instances are far away
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f)
+                                   * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    Bench::Random random(INSTANCE_COUNT);
+    std::vector<Bounds> instances(INSTANCE_COUNT, bounds);
+    for (Bounds& instance : instances)
+    {
+        const float distance = MIN_DISTANCE + random.nextFloat() * (MAX_DISTANCE - MIN_DISTANCE);
+        instance.m_v3Center = glm::vec3((random.nextFloat() * 2.0f - 1.0f) * 0.5f * distance, (random.nextFloat() * 2.0f - 1.0f) * 0.3f * distance, -distance);
+    }
+
+    std::vector<uint32_t> instanceLods(INSTANCE_COUNT, LOD_COUNT);
+    uint64_t triangles = 0u;
+    const double selectMs = Bench::measureMs(ITERATIONS, [&]() {
+        triangles = 0u;
+        for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+        {
+            instanceLods[i] = Lod::select(Lod::getScreenSize(viewProjection, instances[i]), instanceLods[i], LOD_COUNT);
+            triangles += triangleCounts[instanceLods[i]];
+        }
+        Bench::doNotOptimize(triangles);
+    });
+
+    // Nudging every instance by less than the hysteresis must not switch any LOD
+    uint32_t switches = 0u;
+    for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+    {
+        Bounds moved = instances[i];
+        moved.m_v3Center.z *= 1.05f;
+        switches += Lod::select(Lod::getScreenSize(viewProjection, moved), instanceLods[i], LOD_COUNT) != instanceLods[i] ? 1u : 0u;
+    }
+    passed &= switches == 0u;
+
+    const uint64_t fullDetailTriangles = static_cast<uint64_t>(triangleCounts[0]) * INSTANCE_COUNT;
+
+    char header[128];
+    snprintf(header, sizeof(header), "%u instances, %.0f to %.0f units away", INSTANCE_COUNT, MIN_DISTANCE, MAX_DISTANCE);
+    Bench::printHeader(header);
+    Bench::printResult("select", selectMs, INSTANCE_COUNT);
+    printf("  triangles: %llu of %llu at full detail (%.1fx fewer)\n", static_cast<unsigned long long>(triangles), static_cast<unsigned long long>(fullDetailTriangles),
+           static_cast<double>(fullDetailTriangles) / static_cast<double>(triangles));
+    printf("  LOD switches after moving 5%%: %u%s\n", switches, switches == 0u ? "" : " (HYSTERESIS BROKEN)");
+
+    return passed ? 0 : 1;
+}
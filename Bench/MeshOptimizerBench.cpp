@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Geometry/MeshOptimizer.hpp"
+
+/**
+ * The loader's mesh optimization on meshes in a bad export order: triangles shuffled and every triangle with its
+ * own three vertices, as exporters write meshes split at normal or UV seams. One sphere, and a cluster of
+ * overlapping spheres where draw order decides the overdraw. Reports ACMR, ATVR and overdraw after every stage
+ * and the time of the whole pass. The triangles, winding included, have to come out unchanged.
+ */
+namespace
+{
+    constexpr uint32_t ITERATIONS = 3u;
+    constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+    void appendSphere(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, uint32_t rings, uint32_t segments, const glm::vec3& center, float radius)
+    {
+        const float pi = 3.14159265358979f;
+        const uint32_t firstVertex = static_cast<uint32_t>(positions.size());
+
+        for (uint32_t ring = 0; ring <= rings; ++ring)
+        {
+            for (uint32_t segment = 0; segment <= segments; ++segment)
+            {
+                const float theta = pi * static_cast<float>(ring) / rings;
+                const float phi = 2.0f * pi * static_cast<float>(segment % segments) / segments;
+
+                if (ring == 0u || ring == rings)
+                    positions.push_back(center + glm::vec3(0.0f, ring == 0u ? radius : -radius, 0.0f));
+                else
+                    positions.push_back(center + radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+            }
+        }
+
+        for (uint32_t ring = 0; ring < rings; ++ring)
+        {
+            for (uint32_t segment = 0; segment < segments; ++segment)
+            {
+                const uint32_t v0 = firstVertex + ring * (segments + 1u) + segment;
+                const uint32_t v1 = v0 + 1u;
+                const uint32_t v2 = v0 + segments + 1u;
+                const uint32_t v3 = v2 + 1u;
+
+                if (ring != 0u)
+                    indices.insert(indices.end(), { v0, v1, v2 });
+                if (ring + 1u != rings)
+                    indices.insert(indices.end(), { v1, v3, v2 });
+            }
+        }
+    }
+
+    // Shuffled triangles with three vertices each
+    void scramble(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+    {
+        Bench::Random random(indices.size());
+
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size()) / 3u;
+        std::vector<uint32_t> order(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; ++t)
+            order[t] = t;
+        for (uint32_t t = triangleCount; t > 1u; --t)
+            std::swap(order[t - 1u], order[random.next(t)]);
+
+        std::vector<glm::vec3> scrambledPositions;
+        std::vector<uint32_t> scrambledIndices;
+        for (uint32_t t : order)
+        {
+            for (uint32_t corner = 0; corner < 3u; ++corner)
+            {
+                scrambledIndices.push_back(static_cast<uint32_t>(scrambledPositions.size()));
+                scrambledPositions.push_back(positions[indices[t * 3u + corner]]);
+            }
+        }
+
+        positions.swap(scrambledPositions);
+        indices.swap(scrambledIndices);
+    }
+
+    // Every triangle as its positions, rotated to start at the smallest corner so winding is kept, sorted
+    std::vector<std::array<float, 9>> getTriangles(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+    {
+        std::vector<std::array<float, 9>> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3u)
+        {
+            std::array<std::array<float, 3>, 3> corners;
+            for (uint32_t corner = 0; corner < 3u; ++corner)
+            {
+                const glm::vec3& p = positions[indices[i + corner]];
+                corners[corner] = { p.x, p.y, p.z };
+            }
+
+            const size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+            std::array<float, 9> triangle;
+            for (uint32_t corner = 0; corner < 3u; ++corner)
+                std::copy(corners[(first + corner) % 3u].begin(), corners[(first + corner) % 3u].end(), triangle.begin() + corner * 3u);
+            triangles.push_back(triangle);
+        }
+
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void printStage(const char* stage, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+    {
+        const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+        const MeshOptimizer::VertexCacheStats stats = MeshOptimizer::analyzeVertexCache(indices.data(), static_cast<uint32_t>(indices.size()), vertexCount);
+        const float overdraw = MeshOptimizer::analyzeOverdraw(indices.data(), static_cast<uint32_t>(indices.size()), &positions.data()->x, vertexCount, 3u);
+
+        printf("  %-16s %8u vertices  ACMR %.3f  ATVR %.3f  overdraw %.3f\n", stage, stats.m_uVertices, stats.getAcmr(), stats.getAtvr(), overdraw);
+    }
+
+    // The loader's stages, printing the stats after each of them when print is set
+    void optimize(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, bool print)
+    {
+        const uint32_t indexCount = static_cast<uint32_t>(indices.size());
+
+        std::vector<uint32_t> remap(positions.size());
+        const uint32_t uniqueCount = MeshOptimizer::generateVertexRemap(remap.data(), positions.data(), static_cast<uint32_t>(positions.size()), sizeof(glm::vec3));
+        std::vector<glm::vec3> welded(uniqueCount);
+        MeshOptimizer::remapVertices(welded.data(), positions.data(), static_cast<uint32_t>(positions.size()), sizeof(glm::vec3), remap.data());
+        MeshOptimizer::remapIndices(indices.data(), indices.data(), indexCount, remap.data());
+        if (print)
+            printStage("welded", welded, indices);
+
+        std::vector<uint32_t> scratch(indexCount);
+        MeshOptimizer::optimizeVertexCache(scratch.data(), indices.data(), indexCount, uniqueCount);
+        if (print)
+            printStage("vertex cache", welded, scratch);
+
+        MeshOptimizer::optimizeOverdraw(indices.data(), scratch.data(), indexCount, &welded.data()->x, uniqueCount, 3u, OVERDRAW_THRESHOLD);
+        if (print)
+            printStage("overdraw", welded, indices);
+
+        positions.resize(uniqueCount);
+        positions.resize(MeshOptimizer::optimizeVertexFetch(positions.data(), indices.data(), indexCount, welded.data(), uniqueCount, sizeof(glm::vec3)));
+        if (print)
+            printStage("vertex fetch", positions, indices);
+    }
+}
+
+int main()
+{
+    struct Mesh
+    {
+        const char* m_pName;
+        std::vector<glm::vec3> m_vPositions;
+        std::vector<uint32_t> m_vIndices;
+    };
+
+    Mesh meshes[2] = { { "Sphere, 147k triangles" }, { "8 overlapping spheres, 74k triangles" } };
+    appendSphere(meshes[0].m_vPositions, meshes[0].m_vIndices, 192u, 384u, glm::vec3(0.0f), 1.0f);
+
+    Bench::Random random(8u);
+    for (uint32_t s = 0; s < 8u; ++s)
+    {
+        const glm::vec3 center = glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat()) * 2.0f - 1.0f;
+        appendSphere(meshes[1].m_vPositions, meshes[1].m_vIndices, 48u, 96u, center, 0.6f + 0.4f * random.nextFloat());
+    }
+
+    bool passed = true;
+
+    for (Mesh& mesh : meshes)
+    {
+        scramble(mesh.m_vPositions, mesh.m_vIndices);
+        const std::vector<std::array<float, 9>> reference = getTriangles(mesh.m_vPositions, mesh.m_vIndices);
+
+        Bench::printHeader(mesh.m_pName);
+        printStage("input", mesh.m_vPositions, mesh.m_vIndices);
+
+        std::vector<glm::vec3> positions = mesh.m_vPositions;
+        std::vector<uint32_t> indices = mesh.m_vIndices;
+        optimize(positions, indices, true);
+
+        const bool unchanged = getTriangles(positions, indices) == reference;
+        passed &= unchanged;
+
+        const double optimizeMs = Bench::measureMs(ITERATIONS, [&]() {
+            positions = mesh.m_vPositions;
+            indices = mesh.m_vIndices;
+            optimize(positions, indices, false);
+        });
+
+        char label[64];
+        snprintf(label, sizeof(label), "optimize%s", unchanged ? "" : " (TRIANGLES CHANGED)");
+        Bench::printResult(label, optimizeMs, static_cast<uint32_t>(mesh.m_vIndices.size()) / 3u);
+    }
+
+    return passed ? 0 : 1;
+}
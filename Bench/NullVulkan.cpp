@@ -0,0 +1,173 @@
+#include "NullVulkan.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static_assert(sizeof(void*) == 8, "NullVulkan stores host pointers in non-dispatchable handles, which are only pointers on 64-bit targets");
+
+namespace
+{
+    struct NullBuffer
+    {
+        VkDeviceSize m_uSize;
+        unsigned char* m_pMemory; // set by vkBindBufferMemory
+    };
+
+    // Handles only need to be distinct and non-null, these objects are never touched through them
+    unsigned char g_DeviceObject;
+    unsigned char g_CommandBufferObject;
+
+    VkDevice g_VkDevice = reinterpret_cast<VkDevice>(&g_DeviceObject);
+
+    VkPhysicalDeviceMemoryProperties g_MemoryProperties = []() {
+        VkPhysicalDeviceMemoryProperties properties {};
+        properties.memoryTypeCount = 1u;
+        properties.memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        properties.memoryTypes[0].heapIndex = 0u;
+        properties.memoryHeapCount = 1u;
+        properties.memoryHeaps[0].size = ~0ull;
+        return properties;
+    }();
+
+    NullVulkan::Counters g_Counters;
+
+    constexpr VkDeviceSize MEMORY_ALIGNMENT = 256u;
+
+    NullBuffer* toNullBuffer(VkBuffer buffer) { return reinterpret_cast<NullBuffer*>(buffer); }
+
+    [[noreturn]] void unsupported(const char* entryPoint)
+    {
+        fprintf(stderr, "NullVulkan: %s is not supported without a device\n", entryPoint);
+        abort();
+    }
+}
+
+namespace NullVulkan
+{
+    VkDevice* getDevice() { return &g_VkDevice; }
+    VkPhysicalDeviceMemoryProperties* getMemoryProperties() { return &g_MemoryProperties; }
+    VkCommandBuffer getCommandBuffer() { return reinterpret_cast<VkCommandBuffer>(&g_CommandBufferObject); }
+
+    void cmdDrawIndexedIndirectCount(VkCommandBuffer, VkBuffer, VkDeviceSize, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t)
+    {
+        uint32_t drawCount;
+        memcpy(&drawCount, toNullBuffer(countBuffer)->m_pMemory + countBufferOffset, sizeof(drawCount));
+
+        ++g_Counters.m_uIndirectDraws;
+        g_Counters.m_uIndirectCommands += drawCount < maxDrawCount ? drawCount : maxDrawCount;
+    }
+
+    const Counters& getCounters() { return g_Counters; }
+    void resetCounters() { g_Counters = {}; }
+}
+
+// Buffers and memory
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(VkDevice, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer)
+{
+    *pBuffer = reinterpret_cast<VkBuffer>(new NullBuffer{ pCreateInfo->size, nullptr });
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks*)
+{
+    delete toNullBuffer(buffer);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements)
+{
+    pMemoryRequirements->size = toNullBuffer(buffer)->m_uSize;
+    pMemoryRequirements->alignment = MEMORY_ALIGNMENT;
+    pMemoryRequirements->memoryTypeBits = 1u;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory)
+{
+    const VkDeviceSize size = (pAllocateInfo->allocationSize + MEMORY_ALIGNMENT - 1u) & ~(MEMORY_ALIGNMENT - 1u);
+    void* memory = aligned_alloc(MEMORY_ALIGNMENT, size);
+    if (memory == nullptr)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    *pMemory = reinterpret_cast<VkDeviceMemory>(memory);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*)
+{
+    free(reinterpret_cast<void*>(memory));
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    toNullBuffer(buffer)->m_pMemory = reinterpret_cast<unsigned char*>(memory) + memoryOffset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData)
+{
+    *ppData = reinterpret_cast<unsigned char*>(memory) + offset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(VkDevice, VkDeviceMemory)
+{
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkFlushMappedMemoryRanges(VkDevice, uint32_t, const VkMappedMemoryRange*)
+{
+    return VK_SUCCESS;
+}
+
+// Command recording, only counted
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(VkCommandBuffer, VkPipelineBindPoint, VkPipeline)
+{
+    ++g_Counters.m_uPipelineBinds;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t descriptorSetCount, const VkDescriptorSet*, uint32_t, const uint32_t*)
+{
+    g_Counters.m_uDescriptorSetBinds += descriptorSetCount;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(VkCommandBuffer, VkBuffer, VkDeviceSize, VkIndexType)
+{
+    ++g_Counters.m_uIndexBufferBinds;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(VkCommandBuffer, uint32_t, uint32_t bindingCount, const VkBuffer*, const VkDeviceSize*)
+{
+    g_Counters.m_uVertexBufferBinds += bindingCount;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexed(VkCommandBuffer, uint32_t, uint32_t, uint32_t, int32_t, uint32_t)
+{
+    ++g_Counters.m_uDraws;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirect(VkCommandBuffer, VkBuffer, VkDeviceSize, uint32_t drawCount, uint32_t)
+{
+    ++g_Counters.m_uIndirectDraws;
+    g_Counters.m_uIndirectCommands += drawCount;
+}
+
+// Referenced by the staging path of Buffer.cpp and by PipelineManager.cpp, never reached without a PipelineManager
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateCommandPool(VkDevice, const VkCommandPoolCreateInfo*, const VkAllocationCallbacks*, VkCommandPool*) { unsupported("vkCreateCommandPool"); }
+VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(VkDevice, VkCommandPool, const VkAllocationCallbacks*) { unsupported("vkDestroyCommandPool"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(VkDevice, VkCommandPool, VkCommandPoolResetFlags) { unsupported("vkResetCommandPool"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo*, VkCommandBuffer*) { unsupported("vkAllocateCommandBuffers"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer, const VkCommandBufferBeginInfo*) { unsupported("vkBeginCommandBuffer"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer) { unsupported("vkEndCommandBuffer"); }
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBuffer(VkCommandBuffer, VkBuffer, VkBuffer, uint32_t, const VkBufferCopy*) { unsupported("vkCmdCopyBuffer"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(VkQueue, uint32_t, const VkSubmitInfo*, VkFence) { unsupported("vkQueueSubmit"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueWaitIdle(VkQueue) { unsupported("vkQueueWaitIdle"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateShaderModule(VkDevice, const VkShaderModuleCreateInfo*, const VkAllocationCallbacks*, VkShaderModule*) { unsupported("vkCreateShaderModule"); }
+VKAPI_ATTR void VKAPI_CALL vkDestroyShaderModule(VkDevice, VkShaderModule, const VkAllocationCallbacks*) { unsupported("vkDestroyShaderModule"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(VkDevice, const VkDescriptorSetLayoutCreateInfo*, const VkAllocationCallbacks*, VkDescriptorSetLayout*) { unsupported("vkCreateDescriptorSetLayout"); }
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorSetLayout(VkDevice, VkDescriptorSetLayout, const VkAllocationCallbacks*) { unsupported("vkDestroyDescriptorSetLayout"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineLayout(VkDevice, const VkPipelineLayoutCreateInfo*, const VkAllocationCallbacks*, VkPipelineLayout*) { unsupported("vkCreatePipelineLayout"); }
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(VkDevice, VkPipelineLayout, const VkAllocationCallbacks*) { unsupported("vkDestroyPipelineLayout"); }
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice, VkPipelineCache, uint32_t, const VkGraphicsPipelineCreateInfo*, const VkAllocationCallbacks*, VkPipeline*) { unsupported("vkCreateGraphicsPipelines"); }
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipeline(VkDevice, VkPipeline, const VkAllocationCallbacks*) { unsupported("vkDestroyPipeline"); }
@@ -0,0 +1,44 @@
+#ifndef NULL_VULKAN_HPP
+#define NULL_VULKAN_HPP
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+/**
+ * Stand-in for the Vulkan loader so the render queue can be benchmarked on a machine without a GPU.
+ * NullVulkan.cpp defines the vk* entry points the render queue and Buffer.cpp call: buffer memory is plain
+ * host memory, so LinearBuffer works as usual, and every vkCmd* only bumps a counter. Entry points the
+ * render queue never reaches (queue submission, staging uploads) abort. Link it instead of libvulkan.
+ * Single threaded, the counters are not atomic.
+ */
+namespace NullVulkan
+{
+    struct Counters
+    {
+        uint64_t m_uPipelineBinds = 0u;
+        uint64_t m_uDescriptorSetBinds = 0u;
+        uint64_t m_uIndexBufferBinds = 0u;
+        uint64_t m_uVertexBufferBinds = 0u;
+        uint64_t m_uDraws = 0u;              // vkCmdDrawIndexed
+        uint64_t m_uIndirectDraws = 0u;      // vkCmdDrawIndexedIndirect(Count) calls
+        uint64_t m_uIndirectCommands = 0u;   // commands those calls read
+
+        uint64_t getBinds() const { return m_uPipelineBinds + m_uDescriptorSetBinds + m_uIndexBufferBinds + m_uVertexBufferBinds; }
+    };
+
+    // Feed these to StaticBuffer::init(), the single memory type is host visible and coherent
+    VkDevice* getDevice();
+    VkPhysicalDeviceMemoryProperties* getMemoryProperties();
+
+    // Any non-null handle works, the commands recorded into it are only counted
+    VkCommandBuffer getCommandBuffer();
+
+    // Matches PFN_vkCmdDrawIndexedIndirectCountKHR, reads the count from the (host) buffer like a device would
+    void cmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride);
+
+    const Counters& getCounters();
+    void resetCounters();
+}
+
+#endif // NULL_VULKAN_HPP
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Visibility/Frustum.hpp"
+#include "../Visibility/FrustumCuller.hpp"
+#include "../Visibility/OcclusionCuller.hpp"
+
+/**
+ * Software occlusion culling of 200k small boxes in a city block: an 8x8 grid of building boxes as occluders,
+ * camera at street level looking down the grid. Every frame is frustum culled first, then the buildings are
+ * rasterized and the survivors tested, like in main.cpp.
+ *
+ * Two checks run before the timing, a single wall with boxes in front of, behind and beside it, and that no
+ * box nearer than the nearest building is ever reported occluded. Nothing here needs a GPU.
+ */
+namespace
+{
+    constexpr uint32_t OCCLUDEE_COUNT = 200000u;
+    constexpr uint32_t BUILDING_GRID = 8u;
+    constexpr uint32_t ITERATIONS = 50u;
+
+    const glm::vec3 EYE { 0.0f, 2.0f, 0.0f };
+
+    OccluderMesh makeUnitBox()
+    {
+        OccluderMesh mesh;
+        for (uint32_t corner = 0; corner < 8u; ++corner)
+            mesh.m_vPositions.emplace_back((corner & 1u) ? 1.0f : -1.0f, (corner & 2u) ? 1.0f : -1.0f, (corner & 4u) ? 1.0f : -1.0f);
+
+        // Two triangles per face, the culler does not care about the winding
+        mesh.m_vIndices = {
+            0, 2, 3, 0, 3, 1, // -z
+            4, 5, 7, 4, 7, 6, // +z
+            0, 4, 6, 0, 6, 2, // -x
+            1, 3, 7, 1, 7, 5, // +x
+            0, 1, 5, 0, 5, 4, // -y
+            2, 6, 7, 2, 7, 3, // +y
+        };
+
+        return mesh;
+    }
+
+    glm::mat4 makeBoxTransform(const glm::vec3& center, const glm::vec3& extents)
+    {
+        return glm::scale(glm::translate(glm::mat4(1.0f), center), extents);
+    }
+
+    bool checkWall(const glm::mat4& viewProjection)
+    {
+        // 40 x 20 wall 50 units in front of the camera, a zero-thickness box
+        const OccluderMesh box = makeUnitBox();
+        const glm::mat4 wall = makeBoxTransform(glm::vec3(0.0f, 2.0f, -50.0f), glm::vec3(20.0f, 10.0f, 0.0f));
+
+        OcclusionCuller culler;
+        culler.begin(viewProjection);
+        culler.rasterize(box, wall);
+        culler.end();
+
+        struct Case
+        {
+            const char* name;
+            glm::vec3 center;
+            bool expectVisible;
+        };
+
+        const Case cases[] = {
+            { "behind the wall", glm::vec3(0.0f, 2.0f, -80.0f), false },
+            { "far behind the wall", glm::vec3(5.0f, 0.0f, -400.0f), false },
+            { "in front of the wall", glm::vec3(0.0f, 2.0f, -30.0f), true },
+            { "beside the wall", glm::vec3(60.0f, 2.0f, -80.0f), true },
+            { "crossing the near plane", glm::vec3(0.0f, 2.0f, 0.0f), true },
+        };
+
+        bool passed = true;
+        for (const Case& testCase : cases)
+        {
+            const bool visible = culler.isVisible(testCase.center, glm::vec3(1.0f));
+            passed &= visible == testCase.expectVisible;
+            printf("  %-32s %s%s\n", testCase.name, visible ? "visible" : "occluded", visible == testCase.expectVisible ? "" : "  WRONG");
+        }
+
+        return passed;
+    }
+}
+
+int main()
+{
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), static_cast<float>(OcclusionCuller::WIDTH) / OcclusionCuller::HEIGHT, 0.1f, 1000.0f);
+    const glm::mat4 view = glm::lookAt(EYE, EYE + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 viewProjection = projection * view;
+    const Frustum frustum = Frustum::fromViewProjection(viewProjection);
+
+    Bench::printHeader("Occlusion culling, single wall");
+    const bool wallPassed = checkWall(viewProjection);
+
+    Bench::Random random(OCCLUDEE_COUNT);
+
+    // Buildings on a 75 unit grid, the first row 40 units ahead
+    const OccluderMesh box = makeUnitBox();
+    std::vector<glm::mat4> buildings;
+    float nearestBuilding = 1e30f;
+
+    for (uint32_t row = 0; row < BUILDING_GRID; ++row)
+    {
+        for (uint32_t column = 0; column < BUILDING_GRID; ++column)
+        {
+            const glm::vec3 extents(10.0f + random.nextFloat() * 15.0f, 10.0f + random.nextFloat() * 30.0f, 10.0f + random.nextFloat() * 15.0f);
+            const glm::vec3 center(-262.5f + 75.0f * column, extents.y, -40.0f - 75.0f * row - extents.z);
+
+            buildings.push_back(makeBoxTransform(center, extents));
+            nearestBuilding = std::min(nearestBuilding, -(center.z + extents.z));
+        }
+    }
+
+    FrustumCuller frustumCuller;
+    frustumCuller.reserve(OCCLUDEE_COUNT);
+    for (uint32_t i = 0; i < OCCLUDEE_COUNT; ++i)
+    {
+        const glm::vec3 center((random.nextFloat() * 2.0f - 1.0f) * 400.0f, random.nextFloat() * 60.0f, -random.nextFloat() * 700.0f);
+        const glm::vec3 extents(0.5f + random.nextFloat() * 2.5f, 0.5f + random.nextFloat() * 2.5f, 0.5f + random.nextFloat() * 2.5f);
+        frustumCuller.add(center, extents, glm::length(extents));
+    }
+
+    std::vector<uint32_t> frustumVisible(OCCLUDEE_COUNT);
+    const uint32_t frustumVisibleCount = frustumCuller.cull(frustum, frustumVisible.data());
+
+    OcclusionCuller occlusionCuller;
+    std::vector<uint32_t> visible(OCCLUDEE_COUNT);
+    uint32_t visibleCount = 0u;
+
+    const auto rasterizeOccluders = [&]() {
+        occlusionCuller.begin(viewProjection);
+        for (const glm::mat4& building : buildings)
+            occlusionCuller.rasterize(box, building);
+        occlusionCuller.end();
+    };
+
+    const auto testOccludees = [&]() {
+        std::copy(frustumVisible.begin(), frustumVisible.begin() + frustumVisibleCount, visible.begin());
+        visibleCount = occlusionCuller.cull(frustumCuller, visible.data(), frustumVisibleCount);
+    };
+
+    rasterizeOccluders();
+    testOccludees();
+
+    // Anything that starts in front of every building must survive
+    uint32_t wronglyOccluded = 0u;
+    std::vector<uint8_t> isVisible(OCCLUDEE_COUNT, 0u);
+    for (uint32_t i = 0; i < visibleCount; ++i)
+        isVisible[visible[i]] = 1u;
+
+    for (uint32_t i = 0; i < frustumVisibleCount; ++i)
+    {
+        const Bounds bounds = frustumCuller.getBounds(frustumVisible[i]);
+        const float nearestDistance = -(bounds.m_v3Center.z + bounds.m_v3Extents.z);
+        if (nearestDistance < nearestBuilding && isVisible[frustumVisible[i]] == 0u)
+            ++wronglyOccluded;
+    }
+
+    const double rasterizeMs = Bench::measureMs(ITERATIONS, rasterizeOccluders);
+    const double testMs = Bench::measureMs(ITERATIONS, testOccludees);
+
+    char header[128];
+    snprintf(header, sizeof(header), "Occlusion culling, %u objects, %u buildings, %ux%u depth buffer", OCCLUDEE_COUNT, static_cast<uint32_t>(buildings.size()),
+             OcclusionCuller::WIDTH, OcclusionCuller::HEIGHT);
+    Bench::printHeader(header);
+    printf("  %-32s %9u\n", "frustum visible", frustumVisibleCount);
+    printf("  %-32s %9u (%.1f%% occluded)\n", "occlusion visible", visibleCount, 100.0 * (frustumVisibleCount - visibleCount) / std::max(frustumVisibleCount, 1u));
+    printf("  %-32s %9u\n", "occluded in front of buildings", wronglyOccluded);
+    Bench::printResult("rasterize + hierarchy", rasterizeMs, occlusionCuller.getTriangleCount());
+    Bench::printResult("test", testMs, frustumVisibleCount);
+
+    return (wallPassed && wronglyOccluded == 0u) ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "BenchCommon.hpp"
+#include "NullVulkan.hpp"
+#include "../Buffer.hpp"
+#include "../FrameArena.hpp"
+#include "../Renderer/RenderManager.hpp"
+#include "../Renderer/CommandRecorder.hpp"
+#include "../Renderer/GeometryTable.hpp"
+
+/**
+ * Headless benchmark of the render queue: synthetic scenes of 1k to 1M renderables with varying pipeline and
+ * material cardinality are pushed through RenderManager in every RenderMode and recorded into a NullVulkan
+ * command buffer, which only counts the commands. Reports ns per submitted draw for add, sort and record, plus
+ * the commands the recorder actually issued. Immediate modes run the way VkFrame drives them (beginFrame on a
+ * FrameArena, submit, sort, record, endFrame), the best frame is reported. RETAINED registers the scene once
+ * and then measures the steady state frames in which nothing changes, once with every draw shown and once with
+ * most of them hidden, which should cost only the shown ones. Every scene runs with its primitives spread
+ * over per-prototype buffers and with all of them in one GeometryPool.
+ *
+ *   render_queue_bench [max draw count]
+ */
+namespace
+{
+    constexpr uint32_t PRIMITIVE_COUNT = 1024u;
+    constexpr uint32_t PRIMITIVES_PER_GEOMETRY = 4u;
+    constexpr uint32_t MIN_FRAMES = 3u;
+    constexpr uint32_t MAX_FRAMES = 30u;
+    constexpr uint64_t DRAWS_PER_CONFIG = 2000000u; // frame count budget, bounds the run time of the small scenes
+
+    constexpr uint32_t DRAW_COUNTS[] = { 1000u, 10000u, 100000u, 1000000u };
+    constexpr uint32_t PIPELINE_COUNTS[] = { 1u, 8u };
+    constexpr uint32_t MATERIAL_COUNTS[] = { 1u, 64u, 4096u };
+    constexpr uint32_t GEOMETRY_COUNTS[] = { PRIMITIVE_COUNT / PRIMITIVES_PER_GEOMETRY, 1u };
+
+    struct ModeConfig
+    {
+        const char* m_pName;
+        RenderMode m_eMode;
+        bool m_bInstancing;
+        uint32_t m_uShownInterval = 1u; // RETAINED only, every n-th draw is shown
+    };
+
+    constexpr ModeConfig MODES[] = {
+        { "binned",        RenderMode::BINNED,   true },
+        { "indirect",      RenderMode::INDIRECT, true },
+        { "sorted",        RenderMode::SORTED,   true },
+        { "sorted-depth",  RenderMode::SORTED,   false },
+        { "retained",      RenderMode::RETAINED, true },
+        { "retained-10%",  RenderMode::RETAINED, true, 10u },
+    };
+
+    struct Submission
+    {
+        PipelineType m_ePipeline;
+        uint32_t m_uMaterial;
+        Renderable m_Renderable;
+        glm::mat4 m_m4Transform;
+        float m_fDepth;
+    };
+
+    struct Timings
+    {
+        double m_dAddMs = 1e30;
+        double m_dSortMs = 1e30;
+        double m_dRecordMs = 1e30;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Geometry handles point at placeholder buffers, the null backend never dereferences bound buffers
+    void registerGeometry()
+    {
+        GeometryTable::clear();
+        for (uint32_t i = 0; i < PRIMITIVE_COUNT / PRIMITIVES_PER_GEOMETRY; ++i)
+        {
+            VkBuffer indexBuffer = reinterpret_cast<VkBuffer>(static_cast<uintptr_t>(2u * i + 1u) << 4);
+            VkBuffer vertexBuffer = reinterpret_cast<VkBuffer>(static_cast<uintptr_t>(2u * i + 2u) << 4);
+            GeometryTable::add(indexBuffer, vertexBuffer, VK_INDEX_TYPE_UINT32);
+        }
+    }
+
+    std::vector<Submission> makeScene(uint32_t drawCount, uint32_t pipelineCount, uint32_t materialCount, uint32_t geometryCount)
+    {
+        Bench::Random random(drawCount * 131u + pipelineCount * 17u + materialCount);
+
+        std::vector<Submission> scene(drawCount);
+        for (Submission& submission : scene)
+        {
+            const uint32_t primitive = random.next(PRIMITIVE_COUNT);
+
+            submission.m_ePipeline = static_cast<PipelineType>(random.next(pipelineCount));
+            submission.m_uMaterial = random.next(materialCount);
+
+            submission.m_Renderable = {};
+            submission.m_Renderable.geometry = primitive * geometryCount / PRIMITIVE_COUNT;
+            submission.m_Renderable.primitive = primitive;
+            submission.m_Renderable.indexCount = 36u + 12u * (primitive % 8u);
+            submission.m_Renderable.firstIndex = 1024u * (primitive % (PRIMITIVE_COUNT / geometryCount));
+
+            submission.m_m4Transform = glm::mat4(1.0f);
+            submission.m_m4Transform[3] = glm::vec4(random.nextFloat() * 100.0f, random.nextFloat() * 100.0f, random.nextFloat() * 100.0f, 1.0f);
+            submission.m_fDepth = random.nextFloat();
+        }
+
+        return scene;
+    }
+
+    void submit(RenderManager& renderManager, const std::vector<Submission>& scene, std::vector<DrawList::Handle>* handles = nullptr)
+    {
+        for (const Submission& submission : scene)
+        {
+            if (handles != nullptr)
+                handles->push_back(renderManager.addPersistentRenderable(SortBinType::OPAQUE, submission.m_ePipeline, submission.m_uMaterial, submission.m_Renderable, submission.m_m4Transform, submission.m_fDepth));
+            else
+                renderManager.addRenderable(SortBinType::OPAQUE, submission.m_ePipeline, submission.m_uMaterial, submission.m_Renderable, submission.m_m4Transform, submission.m_fDepth);
+        }
+    }
+
+    double record(const RenderManager& renderManager, LinearBuffer& instanceBuffer, LinearBuffer& indirectBuffer, CommandRecorder::Stats& stats)
+    {
+        instanceBuffer.reset();
+        indirectBuffer.reset();
+        NullVulkan::resetCounters();
+
+        const Clock::time_point start = Clock::now();
+
+        CommandRecorder recorder{ NullVulkan::getCommandBuffer(), &instanceBuffer, &indirectBuffer };
+        renderManager.render(recorder);
+
+        const Clock::time_point end = Clock::now();
+
+        stats = recorder.getStats();
+        return elapsedMs(start, end);
+    }
+
+    void printRow(const ModeConfig& mode, uint32_t drawCount, uint32_t pipelineCount, uint32_t materialCount, uint32_t geometryCount,
+                  const Timings& timings, const CommandRecorder::Stats& stats)
+    {
+        const double toNsPerDraw = 1e6 / drawCount;
+        const NullVulkan::Counters& counters = NullVulkan::getCounters();
+
+        printf("  %-13s %8u %5u %5u %5u  %8.2f %8.2f %8.2f %8.2f  %8llu %8llu %8llu %8u\n",
+               mode.m_pName, drawCount, pipelineCount, materialCount, geometryCount,
+               timings.m_dAddMs * toNsPerDraw, timings.m_dSortMs * toNsPerDraw, timings.m_dRecordMs * toNsPerDraw,
+               (timings.m_dAddMs + timings.m_dSortMs + timings.m_dRecordMs) * toNsPerDraw,
+               static_cast<unsigned long long>(counters.m_uDraws), static_cast<unsigned long long>(counters.m_uIndirectDraws),
+               static_cast<unsigned long long>(counters.getBinds()), stats.m_uElidedBinds);
+    }
+
+    void run(const ModeConfig& mode, const std::vector<Submission>& scene, uint32_t pipelineCount, uint32_t materialCount, uint32_t geometryCount,
+             LinearBuffer& instanceBuffer, LinearBuffer& indirectBuffer, FrameArena (&arenas)[2])
+    {
+        const uint32_t drawCount = static_cast<uint32_t>(scene.size());
+        const uint32_t frameCount = static_cast<uint32_t>(std::clamp<uint64_t>(DRAWS_PER_CONFIG / drawCount, MIN_FRAMES, MAX_FRAMES));
+
+        std::vector<PipelineType> pipelines;
+        for (uint32_t i = 0; i < pipelineCount; ++i)
+            pipelines.push_back(static_cast<PipelineType>(i));
+
+        RenderManager renderManager;
+        renderManager.setMode(mode.m_eMode);
+        renderManager.setInstancing(mode.m_bInstancing);
+        renderManager.addSortBin(SortBinType::OPAQUE, pipelines);
+
+        Timings timings;
+        CommandRecorder::Stats stats;
+
+        if (mode.m_eMode == RenderMode::RETAINED)
+        {
+            // add/sort are the one-off registration and commit, record is a frame without changes
+            std::vector<DrawList::Handle> handles;
+            handles.reserve(scene.size());
+
+            const Clock::time_point start = Clock::now();
+            submit(renderManager, scene, &handles);
+            for (uint32_t i = 0; i < handles.size(); ++i)
+            {
+                if (i % mode.m_uShownInterval != 0u)
+                    renderManager.setVisible(handles[i], false);
+            }
+            const Clock::time_point submitted = Clock::now();
+            renderManager.sort();
+            const Clock::time_point sorted = Clock::now();
+
+            timings.m_dAddMs = elapsedMs(start, submitted);
+            timings.m_dSortMs = elapsedMs(submitted, sorted);
+
+            for (uint32_t frame = 0; frame < frameCount; ++frame)
+            {
+                renderManager.sort();
+                timings.m_dRecordMs = std::min(timings.m_dRecordMs, record(renderManager, instanceBuffer, indirectBuffer, stats));
+            }
+
+            printRow(mode, drawCount, pipelineCount, materialCount, geometryCount, timings, stats);
+            return;
+        }
+
+        // One warm-up frame per arena, so the measured frames run on grown arenas like they do in the app
+        for (uint32_t frame = 0; frame < frameCount + 2u; ++frame)
+        {
+            FrameArena& arena = arenas[frame & 1u];
+            arena.reset();
+            renderManager.beginFrame(&arena);
+
+            const Clock::time_point start = Clock::now();
+            submit(renderManager, scene);
+            const Clock::time_point submitted = Clock::now();
+            renderManager.sort();
+            const Clock::time_point sorted = Clock::now();
+
+            const double recordMs = record(renderManager, instanceBuffer, indirectBuffer, stats);
+
+            if (frame >= 2u)
+            {
+                timings.m_dAddMs = std::min(timings.m_dAddMs, elapsedMs(start, submitted));
+                timings.m_dSortMs = std::min(timings.m_dSortMs, elapsedMs(submitted, sorted));
+                timings.m_dRecordMs = std::min(timings.m_dRecordMs, recordMs);
+            }
+
+            renderManager.endFrame();
+        }
+
+        printRow(mode, drawCount, pipelineCount, materialCount, geometryCount, timings, stats);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t maxDrawCount = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : ~0u;
+
+    StaticBuffer::init(NullVulkan::getDevice(), NullVulkan::getMemoryProperties());
+    CommandRecorder::initialize(true, true, NullVulkan::cmdDrawIndexedIndirectCount);
+    registerGeometry();
+
+    FrameArena arenas[2];
+
+    Bench::printHeader("Render queue, ns per submitted draw (best frame), commands counted by the null backend");
+    printf("  %-13s %8s %5s %5s %5s  %8s %8s %8s %8s  %8s %8s %8s %8s\n",
+           "mode", "draws", "pipes", "mats", "geos", "add", "sort", "record", "total", "draws", "indirect", "binds", "elided");
+
+    for (uint32_t drawCount : DRAW_COUNTS)
+    {
+        if (drawCount > maxDrawCount)
+            break;
+
+        // Sized for the worst case: every submission its own instance group and indirect run (with a count)
+        LinearBuffer instanceBuffer;
+        LinearBuffer indirectBuffer;
+        instanceBuffer.create(drawCount * sizeof(glm::mat4), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        indirectBuffer.create(drawCount * (sizeof(VkDrawIndexedIndirectCommand) + sizeof(uint32_t)), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+        for (uint32_t pipelineCount : PIPELINE_COUNTS)
+        {
+            for (uint32_t materialCount : MATERIAL_COUNTS)
+            {
+                for (uint32_t geometryCount : GEOMETRY_COUNTS)
+                {
+                    const std::vector<Submission> scene = makeScene(drawCount, pipelineCount, materialCount, geometryCount);
+
+                    for (const ModeConfig& mode : MODES)
+                        run(mode, scene, pipelineCount, materialCount, geometryCount, instanceBuffer, indirectBuffer, arenas);
+                }
+            }
+        }
+
+        instanceBuffer.destroy();
+        indirectBuffer.destroy();
+    }
+
+    return 0;
+}
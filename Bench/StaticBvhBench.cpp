@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Visibility/Frustum.hpp"
+#include "../Visibility/FrustumCuller.hpp"
+#include "../Visibility/StaticBvh.hpp"
+#include "../ThreadPool.hpp"
+
+/**
+ * Static BVH over 100k to 1M objects scattered through a 1km cube (same scene as frustum_cull_bench).
+ * Reports the build time on one thread and on the whole pool, the save/load round trip of the cache file,
+ * and culling through the tree next to the brute-force culler, whose visible set it has to match.
+ *
+ *   static_bvh_bench [thread count, default hardware_concurrency]
+ */
+namespace
+{
+    constexpr uint32_t OBJECT_COUNTS[] = { 100000u, 250000u, 1000000u };
+    constexpr uint32_t BUILD_ITERATIONS = 3u;
+    constexpr uint32_t CULL_ITERATIONS = 50u;
+    constexpr float SCENE_HALF_SIZE = 500.0f;
+
+    constexpr const char* CACHE_FILE = "static_bvh_bench.bin";
+
+    void makeScene(std::vector<Bounds>& bounds, std::vector<uint32_t>& ids, uint32_t objectCount)
+    {
+        Bench::Random random(objectCount);
+
+        bounds.resize(objectCount);
+        ids.resize(objectCount);
+
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            Bounds& object = bounds[i];
+            object.m_v3Center = glm::vec3((random.nextFloat() * 2.0f - 1.0f) * SCENE_HALF_SIZE,
+                                          (random.nextFloat() * 2.0f - 1.0f) * SCENE_HALF_SIZE,
+                                          (random.nextFloat() * 2.0f - 1.0f) * SCENE_HALF_SIZE);
+            object.m_v3Extents = glm::vec3(0.5f + random.nextFloat() * 4.5f, 0.5f + random.nextFloat() * 4.5f, 0.5f + random.nextFloat() * 4.5f);
+            object.m_fRadius = glm::length(object.m_v3Extents) * (0.6f + random.nextFloat() * 0.4f);
+
+            ids[i] = i;
+        }
+    }
+
+    // Different orders, same set
+    bool isSameSet(std::vector<uint32_t> lhs, std::vector<uint32_t> rhs)
+    {
+        std::sort(lhs.begin(), lhs.end());
+        std::sort(rhs.begin(), rhs.end());
+        return lhs == rhs;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t threadCount = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : std::max(std::thread::hardware_concurrency(), 1u);
+    ThreadPool threadPool(threadCount);
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    // Looking into the scene from its middle and from outside a corner, about a sixth and almost none of it visible
+    const glm::mat4 views[] = {
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.3f, 0.1f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+        glm::lookAt(glm::vec3(-700.0f, 0.0f, -700.0f), glm::vec3(-1400.0f, 0.0f, -1400.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+    };
+    const char* viewNames[] = { "inside", "looking away" };
+
+    std::vector<Bounds> bounds;
+    std::vector<uint32_t> ids;
+    bool passed = true;
+
+    for (uint32_t objectCount : OBJECT_COUNTS)
+    {
+        makeScene(bounds, ids, objectCount);
+
+        StaticBvh bvh;
+        const double serialBuildMs = Bench::measureMs(BUILD_ITERATIONS, [&]() { bvh.build(bounds.data(), ids.data(), objectCount); });
+        const double parallelBuildMs = Bench::measureMs(BUILD_ITERATIONS, [&]() { bvh.build(bounds.data(), ids.data(), objectCount, &threadPool); });
+
+        const uint64_t key = StaticBvh::computeSourceKey(bounds.data(), ids.data(), objectCount);
+        const double saveMs = Bench::measureMs(BUILD_ITERATIONS, [&]() { passed &= bvh.save(CACHE_FILE, key); });
+
+        StaticBvh loaded;
+        const double loadMs = Bench::measureMs(BUILD_ITERATIONS, [&]() { passed &= loaded.load(CACHE_FILE, key); });
+        const bool staleRejected = !StaticBvh().load(CACHE_FILE, key + 1u);
+        passed &= staleRejected;
+        remove(CACHE_FILE);
+
+        FrustumCuller culler;
+        culler.reserve(objectCount);
+        for (const Bounds& object : bounds)
+            culler.add(object);
+
+        char header[128];
+        snprintf(header, sizeof(header), "Static BVH, %u objects, %u nodes", objectCount, bvh.getNodeCount());
+        Bench::printHeader(header);
+        Bench::printResult("build, 1 thread", serialBuildMs, objectCount);
+
+        char label[64];
+        snprintf(label, sizeof(label), "build, %u threads (%.2fx)", threadPool.getThreadCount(), serialBuildMs / parallelBuildMs);
+        Bench::printResult(label, parallelBuildMs, objectCount);
+        Bench::printResult("save", saveMs, objectCount);
+        snprintf(label, sizeof(label), "load%s", staleRejected ? "" : " (STALE FILE ACCEPTED)");
+        Bench::printResult(label, loadMs, objectCount);
+
+        std::vector<uint32_t> reference(objectCount);
+        std::vector<uint32_t> visible(objectCount);
+
+        for (uint32_t v = 0; v < 2u; ++v)
+        {
+            const Frustum frustum = Frustum::fromViewProjection(projection * views[v]);
+
+            uint32_t referenceCount = 0u;
+            const double bruteForceMs = Bench::measureMs(CULL_ITERATIONS, [&]() {
+                referenceCount = culler.cull(frustum, reference.data());
+                Bench::doNotOptimize(referenceCount);
+            });
+
+            uint32_t visibleCount = 0u;
+            const double bvhMs = Bench::measureMs(CULL_ITERATIONS, [&]() {
+                visibleCount = loaded.cull(frustum, visible.data());
+                Bench::doNotOptimize(visibleCount);
+            });
+
+            const bool matches = isSameSet(std::vector<uint32_t>(reference.begin(), reference.begin() + referenceCount),
+                                           std::vector<uint32_t>(visible.begin(), visible.begin() + visibleCount));
+            passed &= matches;
+
+            snprintf(label, sizeof(label), "%s, brute force (%u visible)", viewNames[v], referenceCount);
+            Bench::printResult(label, bruteForceMs, objectCount);
+            snprintf(label, sizeof(label), "%s, bvh%s", viewNames[v], matches ? "" : " (MISMATCH)");
+            Bench::printResult(label, bvhMs, objectCount);
+        }
+    }
+
+    return passed ? 0 : 1;
+}
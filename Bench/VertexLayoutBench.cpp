@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "BenchCommon.hpp"
+#include "../Renderer/VertexLayout.hpp"
+
+/**
+ * Vertex layouts on a million random vertices inside an off-center box: bytes per vertex, encode time and the
+ * largest error of every attribute after decoding them the way the vertex fetch and the draw transform do.
+ * Quantized positions have to land within half a step of the original.
+ */
+namespace
+{
+    constexpr uint32_t VERTEX_COUNT = 1u << 20u;
+    constexpr uint32_t ITERATIONS = 5u;
+
+    struct Vertex
+    {
+        glm::vec3 pos;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    struct Errors
+    {
+        float m_fPosition = 0.0f;
+        float m_fPositionBound = 0.0f; // half a quantization step, summed over the worst vertex
+        float m_fNormalDegrees = 0.0f;
+        float m_fTexcoord = 0.0f;
+    };
+
+    float unpackSnorm8(int8_t value)
+    {
+        return std::max(value / 127.0f, -1.0f);
+    }
+
+    glm::vec3 decodeOctahedral(float x, float y)
+    {
+        glm::vec3 normal(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+        if (normal.z < 0.0f)
+        {
+            normal.x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            normal.y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return glm::normalize(normal);
+    }
+
+    Errors measureErrors(const VertexLayout& layout, const std::vector<Vertex>& vertices, const std::vector<unsigned char>& encoded, const Bounds& bounds)
+    {
+        const glm::mat4 decode = layout.getPositionDecode(bounds);
+
+        Errors errors;
+        for (uint32_t v = 0; v < vertices.size(); ++v)
+        {
+            const unsigned char* vertex = encoded.data() + static_cast<size_t>(v) * layout.getStride();
+
+            glm::vec3 position;
+            glm::vec3 step;
+            if (layout.m_ePosition == PositionFormat::FLOAT3)
+            {
+                memcpy(&position.x, vertex, sizeof(float) * 3u);
+                step = glm::vec3(0.0f);
+            }
+            else
+            {
+                uint16_t components[3];
+                memcpy(components, vertex, sizeof(components));
+                for (uint32_t axis = 0; axis < 3u; ++axis)
+                {
+                    if (layout.m_ePosition == PositionFormat::UNORM16X4)
+                    {
+                        position[axis] = components[axis] / 65535.0f;
+                        step[axis] = 0.5f / 65535.0f * decode[axis][axis];
+                    }
+                    else
+                    {
+                        position[axis] = glm::unpackHalf1x16(components[axis]);
+                        step[axis] = std::ldexp(std::fabs(position[axis]), -11);
+                    }
+                }
+            }
+
+            const glm::vec3 decoded = glm::vec3(decode * glm::vec4(position, 1.0f));
+            const glm::vec3 difference = glm::abs(decoded - vertices[v].pos);
+            const float error = difference.x + difference.y + difference.z;
+            if (error > errors.m_fPosition)
+            {
+                errors.m_fPosition = error;
+                errors.m_fPositionBound = step.x + step.y + step.z;
+            }
+
+            glm::vec3 normal = vertices[v].normal;
+            if (layout.m_eNormal == NormalFormat::FLOAT3)
+            {
+                memcpy(&normal.x, vertex + layout.getNormalOffset(), sizeof(float) * 3u);
+            }
+            else if (layout.m_eNormal == NormalFormat::OCT_SNORM8)
+            {
+                int8_t components[2];
+                memcpy(components, vertex + layout.getNormalOffset(), sizeof(components));
+                normal = decodeOctahedral(unpackSnorm8(components[0]), unpackSnorm8(components[1]));
+            }
+            const float angle = std::atan2(glm::length(glm::cross(normal, vertices[v].normal)), glm::dot(normal, vertices[v].normal));
+            errors.m_fNormalDegrees = std::max(errors.m_fNormalDegrees, angle * 57.2957795f);
+
+            glm::vec2 uv = vertices[v].uv;
+            if (layout.m_eTexcoord == TexcoordFormat::FLOAT2)
+            {
+                memcpy(&uv.x, vertex + layout.getTexcoordOffset(), sizeof(float) * 2u);
+            }
+            else if (layout.m_eTexcoord == TexcoordFormat::HALF2)
+            {
+                uint16_t components[2];
+                memcpy(components, vertex + layout.getTexcoordOffset(), sizeof(components));
+                uv = glm::vec2(glm::unpackHalf1x16(components[0]), glm::unpackHalf1x16(components[1]));
+            }
+            errors.m_fTexcoord = std::max(errors.m_fTexcoord, std::max(std::fabs(uv.x - vertices[v].uv.x), std::fabs(uv.y - vertices[v].uv.y)));
+        }
+
+        return errors;
+    }
+}
+
+int main()
+{
+    struct Case
+    {
+        const char* m_pName;
+        VertexLayout m_Layout;
+    };
+
+    const Case cases[] = {
+        { "float position, normal, uv", { PositionFormat::FLOAT3, NormalFormat::FLOAT3, TexcoordFormat::FLOAT2 } },
+        { "unorm16 position, oct normal, half uv", { PositionFormat::UNORM16X4, NormalFormat::OCT_SNORM8, TexcoordFormat::HALF2 } },
+        { "half position, oct normal, half uv", { PositionFormat::HALF4, NormalFormat::OCT_SNORM8, TexcoordFormat::HALF2 } },
+        { "MESH_VERTEX_LAYOUT", MESH_VERTEX_LAYOUT },
+    };
+
+    // A 20 x 3 x 8 box away from the origin, far enough that positions relative to it gain precision
+    Aabb aabb;
+    aabb.m_v3Min = glm::vec3(100.0f, -4.0f, 37.0f);
+    aabb.m_v3Max = aabb.m_v3Min + glm::vec3(20.0f, 3.0f, 8.0f);
+
+    Bench::Random random(VERTEX_COUNT);
+    std::vector<Vertex> vertices(VERTEX_COUNT);
+    for (Vertex& vertex : vertices)
+    {
+        vertex.pos = aabb.m_v3Min + (aabb.m_v3Max - aabb.m_v3Min) * glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat());
+
+        do
+        {
+            vertex.normal = glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat()) * 2.0f - 1.0f;
+        } while (glm::dot(vertex.normal, vertex.normal) < 1e-4f || glm::dot(vertex.normal, vertex.normal) > 1.0f);
+        vertex.normal = glm::normalize(vertex.normal);
+
+        vertex.uv = glm::vec2(random.nextFloat(), random.nextFloat()) * 4.0f;
+    }
+
+    const Bounds bounds = Bounds::fromAabb(aabb);
+    const uint32_t stride = sizeof(Vertex) / sizeof(float);
+
+    bool passed = true;
+
+    for (const Case& c : cases)
+    {
+        const VertexLayout& layout = c.m_Layout;
+        std::vector<unsigned char> encoded(static_cast<size_t>(VERTEX_COUNT) * layout.getStride());
+
+        const float* normals = layout.hasNormals() ? &vertices.data()->normal.x : nullptr;
+        const float* texcoords = layout.hasTexcoords() ? &vertices.data()->uv.x : nullptr;
+
+        const double encodeMs = Bench::measureMs(ITERATIONS, [&]() {
+            layout.encode(encoded.data(), &vertices.data()->pos.x, normals, texcoords, stride, VERTEX_COUNT, bounds);
+            Bench::doNotOptimize(encoded.data());
+        });
+
+        const Errors errors = measureErrors(layout, vertices, encoded, bounds);
+        const bool withinStep = errors.m_fPosition <= errors.m_fPositionBound * 1.01f + 1e-6f;
+        passed &= withinStep;
+
+        Bench::printHeader(c.m_pName);
+        printf("  %u bytes per vertex, %.1f MiB\n", layout.getStride(), encoded.size() / (1024.0 * 1024.0));
+        printf("  max error: position %.6f%s, normal %.3f deg, uv %.6f\n", errors.m_fPosition, withinStep ? "" : " (ABOVE HALF A STEP)",
+               layout.hasNormals() ? errors.m_fNormalDegrees : 0.0f, layout.hasTexcoords() ? errors.m_fTexcoord : 0.0f);
+        Bench::printResult("encode", encodeMs, VERTEX_COUNT);
+    }
+
+    return passed ? 0 : 1;
+}
@@ -94,7 +94,7 @@ void StagingBuffer::init(VkDevice *device, VkQueue queue, uint32_t queueFamilyIn
     VK_CHECK(vkAllocateCommandBuffers(*m_pVkDevice, &commandBufferAllocateInfo, &m_VkCommandBuffer));
 }
 
-void StagingBuffer::upload(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize nbytes)
+VkCommandBuffer StagingBuffer::begin()
 {
     static const VkCommandBufferBeginInfo commandBufferBeginInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -102,15 +102,11 @@ void StagingBuffer::upload(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer
     };
 
     vkBeginCommandBuffer(m_VkCommandBuffer, &commandBufferBeginInfo);
+    return m_VkCommandBuffer;
+}
 
-    const VkBufferCopy bufferCopy {
-        .srcOffset = srcOffset,
-        .dstOffset = dstOffset,
-        .size = nbytes
-    };
-
-    vkCmdCopyBuffer(m_VkCommandBuffer, srcBuffer, dstBuffer, 1u, &bufferCopy);
-
+void StagingBuffer::submit()
+{
     vkEndCommandBuffer(m_VkCommandBuffer);
 
 #ifdef VULKAN_1_3
@@ -140,6 +136,18 @@ void StagingBuffer::upload(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer
     vkResetCommandPool(*m_pVkDevice, m_VkCommandPool, 0x0);
 }
 
+void StagingBuffer::upload(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize nbytes)
+{
+    const VkBufferCopy bufferCopy {
+        .srcOffset = srcOffset,
+        .dstOffset = dstOffset,
+        .size = nbytes
+    };
+
+    vkCmdCopyBuffer(begin(), srcBuffer, dstBuffer, 1u, &bufferCopy);
+    submit();
+}
+
 void StagingBuffer::destroy()
 {
     vkDestroyCommandPool(*m_pVkDevice, m_VkCommandPool, nullptr);
@@ -208,7 +216,21 @@ void StaticBuffer::destroy()
     m_bCreated = false;
 }
 
-void StaticBuffer::uploadData(const VkDeviceSize nbytes, const void *data)
+void *StaticBuffer::map()
+{
+    assert((m_vkBufferMemProps & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && "Attempting to map a buffer that is not host visible!");
+
+    void *bufferData = nullptr;
+    VK_CHECK(vkMapMemory(*device, m_vkBufferMemory, 0, VK_WHOLE_SIZE, 0, &bufferData));
+    return bufferData;
+}
+
+void StaticBuffer::unmap()
+{
+    vkUnmapMemory(*device, m_vkBufferMemory);
+}
+
+void StaticBuffer::uploadData(const VkDeviceSize nbytes, const void *data, const VkDeviceSize offset)
 {
     assert((m_vkBuffer != VK_NULL_HANDLE && m_vkBufferMemory != VK_NULL_HANDLE) && "Attempting to upload data to buffer before buffer creation!");
 
@@ -225,7 +247,7 @@ void StaticBuffer::uploadData(const VkDeviceSize nbytes, const void *data)
         stagingBuffer.create(stagingBufferCreateInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
         stagingBuffer.uploadData(stagingBufferCreateInfo.size, data);
 
-        StagingBuffer::upload(stagingBuffer.m_vkBuffer, 0, m_vkBuffer, 0, nbytes);
+        StagingBuffer::upload(stagingBuffer.m_vkBuffer, 0, m_vkBuffer, offset, nbytes);
 
         return;
     }
@@ -234,7 +256,7 @@ void StaticBuffer::uploadData(const VkDeviceSize nbytes, const void *data)
         // Mapped Memory
         void *bufferData;
         vkMapMemory(*device, m_vkBufferMemory, 0, VK_WHOLE_SIZE, 0, &bufferData);
-        memcpy(bufferData, data, nbytes);
+        memcpy(static_cast<unsigned char *>(bufferData) + offset, data, nbytes);
 
         VkMappedMemoryRange range{
             .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
@@ -246,4 +268,51 @@ void StaticBuffer::uploadData(const VkDeviceSize nbytes, const void *data)
         vkFlushMappedMemoryRanges(*device, 1, &range);
         vkUnmapMemory(*device, m_vkBufferMemory);
     }
+}
+
+LinearBuffer::LinearBuffer()
+    : m_pMapped{nullptr}, m_uCapacity{0u}, m_uHead{0u}
+{
+}
+
+void LinearBuffer::create(VkDeviceSize capacity, VkBufferUsageFlags usage)
+{
+    const VkBufferCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = capacity,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    // Coherent, so writes only need to land before the queue submit that consumes them
+    m_Buffer.create(createInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_pMapped = static_cast<unsigned char *>(m_Buffer.map());
+    m_uCapacity = capacity;
+    m_uHead.store(0u);
+}
+
+void LinearBuffer::destroy()
+{
+    if (m_pMapped == nullptr)
+        return;
+
+    m_Buffer.unmap();
+    m_Buffer.destroy();
+    m_pMapped = nullptr;
+    m_uCapacity = 0u;
+}
+
+LinearBuffer::Allocation LinearBuffer::allocate(VkDeviceSize nbytes, VkDeviceSize alignment)
+{
+    VkDeviceSize head = m_uHead.load(std::memory_order_relaxed);
+    VkDeviceSize offset;
+
+    do
+    {
+        offset = (head + alignment - 1u) / alignment * alignment;
+        if (offset + nbytes > m_uCapacity)
+            return {nullptr, 0u};
+    } while (!m_uHead.compare_exchange_weak(head, offset + nbytes, std::memory_order_relaxed));
+
+    return {m_pMapped + offset, offset};
 }
\ No newline at end of file
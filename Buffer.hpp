@@ -1,6 +1,7 @@
 #ifndef BUFFER_HPP
 #define BUFFER_HPP
 
+#include <atomic>
 #include <vector>
 
 #include <vulkan/vulkan.h>
@@ -26,7 +27,12 @@ public:
 
     void create(const VkBufferCreateInfo& createInfo, const VkMemoryPropertyFlags memProperties);
     void destroy();
-    void uploadData(const VkDeviceSize nbytes, const void* data);
+    // Writes nbytes at offset, device local buffers are written through a staging copy
+    void uploadData(const VkDeviceSize nbytes, const void* data, const VkDeviceSize offset = 0u);
+
+    // Only valid for HOST_VISIBLE buffers, the mapping stays valid until unmap() or destroy()
+    void* map();
+    void unmap();
 
     VkBuffer getBuffer() const { return m_vkBuffer; }
     const VkBuffer* getBufferPointer() const { return &m_vkBuffer; }
@@ -38,6 +44,38 @@ class DynamicBuffer
     std::vector<StaticBuffer> m_vBuffer;
 };
 
+/**
+ * Host visible, coherent buffer that stays mapped for its whole lifetime. Sub-allocated with a bump pointer
+ * and reset wholesale, meant for per-frame data the CPU writes once and the GPU consumes once (indirect
+ * commands, instance data). allocate() is safe to call from several recording threads at once.
+ */
+class LinearBuffer
+{
+private:
+    StaticBuffer m_Buffer;
+    unsigned char* m_pMapped;
+    VkDeviceSize m_uCapacity;
+    std::atomic<VkDeviceSize> m_uHead;
+
+public:
+    struct Allocation
+    {
+        void* m_pData;          // nullptr when the buffer is full
+        VkDeviceSize m_uOffset;
+    };
+
+    LinearBuffer();
+
+    void create(VkDeviceSize capacity, VkBufferUsageFlags usage);
+    void destroy();
+
+    Allocation allocate(VkDeviceSize nbytes, VkDeviceSize alignment);
+    void reset() { m_uHead.store(0u, std::memory_order_relaxed); }
+
+    VkBuffer getBuffer() const { return m_Buffer.getBuffer(); }
+    VkDeviceSize getCapacity() const { return m_uCapacity; }
+};
+
 class StagingBuffer
 {
 private:
@@ -49,6 +87,11 @@ private:
 public:
     static void init(VkDevice *device, VkQueue queue, uint32_t queueFamilyIndex);
     static void upload(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize nbytes);
+
+    // For uploads that take more than one copy: record into the returned command buffer between begin() and
+    // submit(), which waits until the queue is idle. Like upload(), only one thread may use them at a time.
+    static VkCommandBuffer begin();
+    static void submit();
     static void destroy();
 };
 
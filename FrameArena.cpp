@@ -0,0 +1,77 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+FrameArena::FrameArena(size_t initialSize)
+    : m_uBlockIdx{0u}, m_uOffset{0u}, m_uUsedBytes{0u}
+{
+    m_vBlocks.push_back({ static_cast<unsigned char*>(::operator new(initialSize)), initialSize });
+}
+
+FrameArena::~FrameArena()
+{
+    releaseBlocks();
+}
+
+void FrameArena::releaseBlocks()
+{
+    for (Block& block : m_vBlocks)
+        ::operator delete(block.m_pData);
+
+    m_vBlocks.clear();
+}
+
+void* FrameArena::do_allocate(size_t nbytes, size_t alignment)
+{
+    while (true)
+    {
+        Block& block = m_vBlocks[m_uBlockIdx];
+
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.m_pData);
+        const uintptr_t aligned = (base + m_uOffset + alignment - 1u) & ~static_cast<uintptr_t>(alignment - 1u);
+        const size_t end = static_cast<size_t>(aligned - base) + nbytes;
+
+        if (end <= block.m_uSize)
+        {
+            m_uUsedBytes += end - m_uOffset;
+            m_uOffset = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Spill into the next block, growing the arena when this frame outgrew every block so far
+        m_uUsedBytes += block.m_uSize - m_uOffset;
+        m_uOffset = 0u;
+
+        if (++m_uBlockIdx == m_vBlocks.size())
+        {
+            // Goes through operator new so the growth shows up in AllocationCounter
+            const size_t size = std::max(block.m_uSize * 2u, nbytes + alignment);
+            m_vBlocks.push_back({ static_cast<unsigned char*>(::operator new(size)), size });
+        }
+    }
+}
+
+void FrameArena::reset()
+{
+    if (m_uBlockIdx > 0u)
+    {
+        const size_t size = getCapacity();
+        releaseBlocks();
+        m_vBlocks.push_back({ static_cast<unsigned char*>(::operator new(size)), size });
+    }
+
+    m_uBlockIdx = 0u;
+    m_uOffset = 0u;
+    m_uUsedBytes = 0u;
+}
+
+size_t FrameArena::getCapacity() const
+{
+    size_t capacity = 0u;
+    for (const Block& block : m_vBlocks)
+        capacity += block.m_uSize;
+
+    return capacity;
+}
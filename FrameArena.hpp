@@ -0,0 +1,51 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Bump allocator for data that lives for exactly one frame (render queue storage, sort keys, scratch).
+ * Plugged into std::pmr containers; deallocate is a no-op and everything is released at once by reset(),
+ * which the owning VkFrame calls after its fence has signaled. Once the arena has grown to a frame's
+ * peak usage it serves every later frame without touching the heap. Not thread safe.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+private:
+    struct Block
+    {
+        unsigned char* m_pData;
+        size_t m_uSize;
+    };
+
+    std::vector<Block> m_vBlocks;
+    size_t m_uBlockIdx;
+    size_t m_uOffset;    // into m_vBlocks[m_uBlockIdx]
+    size_t m_uUsedBytes; // since the last reset(), including alignment padding
+
+    void* do_allocate(size_t nbytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void releaseBlocks();
+
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1u << 20;
+
+    explicit FrameArena(size_t initialSize = DEFAULT_BLOCK_SIZE);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Invalidates everything allocated since the previous reset(). If the last frame spilled into extra
+    // blocks they are merged into one block large enough for it, so the steady state is a single block.
+    void reset();
+
+    size_t getUsedBytes() const { return m_uUsedBytes; }
+    size_t getCapacity() const;
+};
+
+#endif // FRAME_ARENA_HPP
@@ -0,0 +1,76 @@
+#include "IndexConversion.hpp"
+
+#include <cassert>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define INDEX_CONVERSION_X86 1
+#include <immintrin.h>
+#else
+#define INDEX_CONVERSION_X86 0
+#endif
+
+void IndexConversion::widen(uint32_t* destination, const uint8_t* source, size_t count)
+{
+    size_t i = 0u;
+
+#if INDEX_CONVERSION_X86
+    // 16 indices per iteration, interleaving with zero bytes twice turns every byte into a 32 bit lane
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16u <= count; i += 16u)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 4u), _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 8u), _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 12u), _mm_unpackhi_epi16(high, zero));
+    }
+#endif
+
+    for (; i < count; ++i)
+        destination[i] = source[i];
+}
+
+void IndexConversion::widen(uint32_t* destination, const uint16_t* source, size_t count)
+{
+    size_t i = 0u;
+
+#if INDEX_CONVERSION_X86
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8u <= count; i += 8u)
+    {
+        const __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_unpacklo_epi16(shorts, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 4u), _mm_unpackhi_epi16(shorts, zero));
+    }
+#endif
+
+    for (; i < count; ++i)
+        destination[i] = source[i];
+}
+
+void IndexConversion::narrow(uint16_t* destination, const uint32_t* source, size_t count)
+{
+    size_t i = 0u;
+
+#if INDEX_CONVERSION_X86
+    // SSE2 only packs with signed saturation: shifting [0, 65535] down by 32768 makes it fit exactly, flipping
+    // the top bit of every 16 bit result shifts it back
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8u <= count; i += 8u)
+    {
+        const __m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), bias32);
+        const __m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4u)), bias32);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_xor_si128(_mm_packs_epi32(low, high), bias16));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        assert(source[i] <= UINT16_MAX);
+        destination[i] = static_cast<uint16_t>(source[i]);
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef INDEX_CONVERSION_HPP
+#define INDEX_CONVERSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bulk conversions between index widths, SSE2 on x86-64 and plain loops elsewhere.
+ *
+ * The loader widens glTF indices of any width to 32 bits while it works on them (LODs, occluders) and narrows
+ * them back to 16 bits for the index buffer when the vertex counts allow it. Source and destination must not
+ * overlap.
+ */
+namespace IndexConversion
+{
+    void widen(uint32_t* destination, const uint8_t* source, size_t count);
+    void widen(uint32_t* destination, const uint16_t* source, size_t count);
+
+    // Every source index must be below 65536
+    void narrow(uint16_t* destination, const uint32_t* source, size_t count);
+}
+
+#endif // INDEX_CONVERSION_HPP
@@ -0,0 +1,431 @@
+#include "MeshOptimizer.hpp"
+#include "../Hash.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    constexpr uint32_t NO_VERTEX = ~0u;
+
+    // FIFO cache by insertion time: a vertex is cached while fewer than VERTEX_CACHE_SIZE vertices were inserted
+    // after it. Times start past the cache size so nothing is cached initially, flush() empties it.
+    class VertexCache
+    {
+    public:
+        explicit VertexCache(uint32_t vertexCount) : m_vInsertionTimes(vertexCount, 0u), m_uTime(MeshOptimizer::VERTEX_CACHE_SIZE + 1u) {}
+
+        // Returns whether v missed
+        bool access(uint32_t v)
+        {
+            if (m_uTime - m_vInsertionTimes[v] <= MeshOptimizer::VERTEX_CACHE_SIZE)
+                return false;
+
+            m_vInsertionTimes[v] = m_uTime++;
+            return true;
+        }
+
+        uint32_t accessTriangle(const uint32_t* triangle)
+        {
+            return static_cast<uint32_t>(access(triangle[0])) + static_cast<uint32_t>(access(triangle[1])) + static_cast<uint32_t>(access(triangle[2]));
+        }
+
+        void flush() { m_uTime += MeshOptimizer::VERTEX_CACHE_SIZE + 1u; }
+
+        // How long ago v was inserted, above VERTEX_CACHE_SIZE when it is not cached
+        uint32_t getAge(uint32_t v) const { return m_uTime - m_vInsertionTimes[v]; }
+
+    private:
+        std::vector<uint32_t> m_vInsertionTimes;
+        uint32_t m_uTime;
+    };
+
+    glm::vec3 getPosition(const float* positions, uint32_t stride, uint32_t v)
+    {
+        const float* position = positions + static_cast<size_t>(v) * stride;
+        return glm::vec3(position[0], position[1], position[2]);
+    }
+}
+
+uint32_t MeshOptimizer::generateVertexRemap(uint32_t* remap, const void* vertices, uint32_t vertexCount, uint32_t vertexSize)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+
+    const auto hash = [bytes, vertexSize](uint32_t v) {
+        return static_cast<size_t>(Hash::bytes(Hash::SEED, bytes + static_cast<size_t>(v) * vertexSize, vertexSize));
+    };
+    const auto equal = [bytes, vertexSize](uint32_t lhs, uint32_t rhs) {
+        return memcmp(bytes + static_cast<size_t>(lhs) * vertexSize, bytes + static_cast<size_t>(rhs) * vertexSize, vertexSize) == 0;
+    };
+
+    std::unordered_map<uint32_t, uint32_t, decltype(hash), decltype(equal)> uniqueVertices(vertexCount, hash, equal);
+
+    uint32_t uniqueCount = 0u;
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        const auto inserted = uniqueVertices.emplace(v, uniqueCount);
+        if (inserted.second)
+            ++uniqueCount;
+        remap[v] = inserted.first->second;
+    }
+
+    return uniqueCount;
+}
+
+void MeshOptimizer::remapVertices(void* destination, const void* vertices, uint32_t vertexCount, uint32_t vertexSize, const uint32_t* remap)
+{
+    unsigned char* destinationBytes = static_cast<unsigned char*>(destination);
+    const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        memcpy(destinationBytes + static_cast<size_t>(remap[v]) * vertexSize, bytes + static_cast<size_t>(v) * vertexSize, vertexSize);
+}
+
+void MeshOptimizer::remapIndices(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const uint32_t* remap)
+{
+    for (uint32_t i = 0; i < indexCount; ++i)
+        destination[i] = remap[indices[i]];
+}
+
+void MeshOptimizer::optimizeVertexCache(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+{
+    assert(destination != indices && indexCount % 3u == 0u);
+
+    // Triangles around every vertex, and how many of them are still to be emitted
+    std::vector<uint32_t> fanOffsets(vertexCount + 1u, 0u);
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        assert(indices[i] < vertexCount);
+        ++fanOffsets[indices[i] + 1u];
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        fanOffsets[v + 1u] += fanOffsets[v];
+
+    std::vector<uint32_t> fans(indexCount);
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    {
+        std::vector<uint32_t> cursor(fanOffsets.begin(), fanOffsets.end() - 1);
+        for (uint32_t i = 0; i < indexCount; ++i)
+            fans[cursor[indices[i]]++] = i / 3u;
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = fanOffsets[v + 1u] - fanOffsets[v];
+
+    VertexCache cache(vertexCount);
+    std::vector<uint8_t> emitted(indexCount / 3u, 0u);
+    std::vector<uint32_t> deadEnd; // recently used vertices, where to continue when a fan leads nowhere
+    std::vector<uint32_t> candidates;
+
+    uint32_t written = 0u;
+    uint32_t scan = 0u;
+    while (scan < vertexCount && liveTriangles[scan] == 0u)
+        ++scan;
+    uint32_t fan = scan < vertexCount ? scan : NO_VERTEX;
+
+    while (fan != NO_VERTEX)
+    {
+        candidates.clear();
+
+        for (uint32_t f = fanOffsets[fan]; f < fanOffsets[fan + 1u]; ++f)
+        {
+            const uint32_t triangle = fans[f];
+            if (emitted[triangle] != 0u)
+                continue;
+
+            for (uint32_t corner = 0; corner < 3u; ++corner)
+            {
+                const uint32_t v = indices[triangle * 3u + corner];
+                destination[written++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                cache.access(v);
+            }
+
+            emitted[triangle] = 1u;
+        }
+
+        // The candidate that will still be cached after its remaining triangles are emitted, the oldest one
+        // first since it is the next to be evicted. Candidates that would not fit all score 0.
+        fan = NO_VERTEX;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates)
+        {
+            if (liveTriangles[v] == 0u)
+                continue;
+
+            int64_t priority = 0;
+            if (cache.getAge(v) + 2u * liveTriangles[v] <= VERTEX_CACHE_SIZE)
+                priority = cache.getAge(v);
+
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fan = v;
+            }
+        }
+
+        while (fan == NO_VERTEX && !deadEnd.empty())
+        {
+            const uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] != 0u)
+                fan = v;
+        }
+
+        if (fan == NO_VERTEX)
+        {
+            while (scan < vertexCount && liveTriangles[scan] == 0u)
+                ++scan;
+            fan = scan < vertexCount ? scan : NO_VERTEX;
+        }
+    }
+
+    assert(written == indexCount);
+}
+
+void MeshOptimizer::optimizeOverdraw(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride,
+                                     float threshold)
+{
+    assert(destination != indices && indexCount % 3u == 0u);
+
+    const uint32_t triangleCount = indexCount / 3u;
+    if (triangleCount == 0u)
+        return;
+
+    // Hard boundaries: triangles that miss on every vertex follow a jump to another part of the mesh
+    std::vector<uint32_t> hardBoundaries;
+    {
+        VertexCache cache(vertexCount);
+        for (uint32_t t = 0; t < triangleCount; ++t)
+        {
+            if (cache.accessTriangle(indices + t * 3u) == 3u || t == 0u)
+                hardBoundaries.push_back(t);
+        }
+        hardBoundaries.push_back(triangleCount);
+    }
+
+    // Soft boundaries: a cluster may end as soon as its own ACMR, starting from an empty cache, is within
+    // threshold of what the whole hard cluster achieves
+    std::vector<uint32_t> clusters;
+    {
+        VertexCache cache(vertexCount);
+        for (size_t h = 0; h + 1u < hardBoundaries.size(); ++h)
+        {
+            const uint32_t begin = hardBoundaries[h];
+            const uint32_t end = hardBoundaries[h + 1u];
+
+            cache.flush();
+            uint32_t misses = 0u;
+            for (uint32_t t = begin; t < end; ++t)
+                misses += cache.accessTriangle(indices + t * 3u);
+            const float clusterThreshold = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+            cache.flush();
+            clusters.push_back(begin);
+            uint32_t runningMisses = 0u;
+            uint32_t runningTriangles = 0u;
+
+            for (uint32_t t = begin; t < end; ++t)
+            {
+                runningMisses += cache.accessTriangle(indices + t * 3u);
+                ++runningTriangles;
+
+                if (t + 1u < end && static_cast<float>(runningMisses) <= clusterThreshold * static_cast<float>(runningTriangles))
+                {
+                    clusters.push_back(t + 1u);
+                    cache.flush();
+                    runningMisses = 0u;
+                    runningTriangles = 0u;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+    }
+
+    // Occlusion potential: clusters far from the center and facing away from it are likely in front of the rest
+    glm::dvec3 meshCentroid(0.0);
+    double meshArea = 0.0;
+
+    const uint32_t clusterCount = static_cast<uint32_t>(clusters.size()) - 1u;
+    std::vector<glm::dvec3> clusterCentroids(clusterCount, glm::dvec3(0.0));
+    std::vector<glm::dvec3> clusterNormals(clusterCount, glm::dvec3(0.0));
+
+    for (uint32_t c = 0; c < clusterCount; ++c)
+    {
+        double clusterArea = 0.0;
+
+        for (uint32_t t = clusters[c]; t < clusters[c + 1u]; ++t)
+        {
+            const glm::vec3 p0 = getPosition(positions, stride, indices[t * 3u]);
+            const glm::vec3 p1 = getPosition(positions, stride, indices[t * 3u + 1u]);
+            const glm::vec3 p2 = getPosition(positions, stride, indices[t * 3u + 2u]);
+
+            const glm::dvec3 normal = glm::dvec3(glm::cross(p1 - p0, p2 - p0));
+            const double area = glm::length(normal) * 0.5;
+            const glm::dvec3 centroid = glm::dvec3(p0 + p1 + p2) / 3.0;
+
+            clusterCentroids[c] += centroid * area;
+            clusterNormals[c] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroids[c];
+        meshArea += clusterArea;
+        clusterCentroids[c] = clusterArea > 0.0 ? clusterCentroids[c] / clusterArea : glm::dvec3(0.0);
+    }
+
+    if (meshArea > 0.0)
+        meshCentroid /= meshArea;
+
+    std::vector<double> potentials(clusterCount);
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c)
+    {
+        const double length = glm::length(clusterNormals[c]);
+        potentials[c] = length > 0.0 ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length) : 0.0;
+        order[c] = c;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&potentials](uint32_t lhs, uint32_t rhs) { return potentials[lhs] > potentials[rhs]; });
+
+    uint32_t written = 0u;
+    for (uint32_t c : order)
+    {
+        const uint32_t count = (clusters[c + 1u] - clusters[c]) * 3u;
+        memcpy(destination + written, indices + clusters[c] * 3u, count * sizeof(uint32_t));
+        written += count;
+    }
+}
+
+uint32_t MeshOptimizer::optimizeVertexFetch(void* destination, uint32_t* indices, uint32_t indexCount, const void* vertices, uint32_t vertexCount, uint32_t vertexSize)
+{
+    unsigned char* destinationBytes = static_cast<unsigned char*>(destination);
+    const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+
+    std::vector<uint32_t> remap(vertexCount, NO_VERTEX);
+    uint32_t written = 0u;
+
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        const uint32_t v = indices[i];
+        assert(v < vertexCount);
+
+        if (remap[v] == NO_VERTEX)
+        {
+            memcpy(destinationBytes + static_cast<size_t>(written) * vertexSize, bytes + static_cast<size_t>(v) * vertexSize, vertexSize);
+            remap[v] = written++;
+        }
+
+        indices[i] = remap[v];
+    }
+
+    return written;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+{
+    VertexCacheStats stats;
+    stats.m_uTriangles = indexCount / 3u;
+
+    VertexCache cache(vertexCount);
+    std::vector<uint8_t> referenced(vertexCount, 0u);
+
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        assert(indices[i] < vertexCount);
+        stats.m_uMisses += static_cast<uint32_t>(cache.access(indices[i]));
+
+        stats.m_uVertices += referenced[indices[i]] == 0u ? 1u : 0u;
+        referenced[indices[i]] = 1u;
+    }
+
+    return stats;
+}
+
+float MeshOptimizer::analyzeOverdraw(const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride)
+{
+    constexpr int32_t VIEWPORT_SIZE = 256;
+
+    glm::vec3 minimum(FLT_MAX);
+    glm::vec3 maximum(-FLT_MAX);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        minimum = glm::min(minimum, getPosition(positions, stride, v));
+        maximum = glm::max(maximum, getPosition(positions, stride, v));
+    }
+
+    const glm::vec3 extents = maximum - minimum;
+    const float extent = std::max(extents.x, std::max(extents.y, extents.z));
+    const float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+    std::vector<float> depths(VIEWPORT_SIZE * VIEWPORT_SIZE);
+    uint64_t covered = 0u;
+    uint64_t shaded = 0u;
+
+    for (uint32_t axis = 0; axis < 3u; ++axis)
+    {
+        for (uint32_t flip = 0; flip < 2u; ++flip)
+        {
+            std::fill(depths.begin(), depths.end(), FLT_MAX);
+
+            for (uint32_t i = 0; i + 2u < indexCount; i += 3u)
+            {
+                // Screen x and y are the two other axes, looking from the other side mirrors x and reverses depth
+                glm::vec3 screen[3];
+                for (uint32_t corner = 0; corner < 3u; ++corner)
+                {
+                    const glm::vec3 p = (getPosition(positions, stride, indices[i + corner]) - minimum) * scale;
+                    const glm::vec3 rotated = glm::vec3(p[(axis + 1u) % 3u], p[(axis + 2u) % 3u], p[axis]);
+                    screen[corner] = glm::vec3((flip ? 1.0f - rotated.x : rotated.x) * VIEWPORT_SIZE, rotated.y * VIEWPORT_SIZE, flip ? 1.0f - rotated.z : rotated.z);
+                }
+
+                const glm::vec2 e1 = glm::vec2(screen[1] - screen[0]);
+                const glm::vec2 e2 = glm::vec2(screen[2] - screen[0]);
+                // Near is small depth, so counter-clockwise triangles facing the viewer have a negative area here
+                const float area = e1.x * e2.y - e1.y * e2.x;
+                if (area >= 0.0f)
+                    continue; // back facing or degenerate
+
+                const int32_t minX = std::max(static_cast<int32_t>(std::min(screen[0].x, std::min(screen[1].x, screen[2].x))), 0);
+                const int32_t maxX = std::min(static_cast<int32_t>(std::max(screen[0].x, std::max(screen[1].x, screen[2].x))), VIEWPORT_SIZE - 1);
+                const int32_t minY = std::max(static_cast<int32_t>(std::min(screen[0].y, std::min(screen[1].y, screen[2].y))), 0);
+                const int32_t maxY = std::min(static_cast<int32_t>(std::max(screen[0].y, std::max(screen[1].y, screen[2].y))), VIEWPORT_SIZE - 1);
+
+                for (int32_t y = minY; y <= maxY; ++y)
+                {
+                    for (int32_t x = minX; x <= maxX; ++x)
+                    {
+                        const glm::vec2 pixel(static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
+                        const glm::vec2 d = pixel - glm::vec2(screen[0]);
+
+                        // Barycentrics of corners 1 and 2
+                        const float b1 = (d.x * e2.y - d.y * e2.x) / area;
+                        const float b2 = (e1.x * d.y - e1.y * d.x) / area;
+                        if (b1 < 0.0f || b2 < 0.0f || b1 + b2 > 1.0f)
+                            continue;
+
+                        const float depth = screen[0].z + b1 * (screen[1].z - screen[0].z) + b2 * (screen[2].z - screen[0].z);
+                        float& stored = depths[y * VIEWPORT_SIZE + x];
+                        if (depth < stored)
+                        {
+                            stored = depth;
+                            ++shaded;
+                        }
+                    }
+                }
+            }
+
+            covered += static_cast<uint64_t>(std::count_if(depths.begin(), depths.end(), [](float depth) { return depth != FLT_MAX; }));
+        }
+    }
+
+    return covered == 0u ? 0.0f : static_cast<float>(static_cast<double>(shaded) / static_cast<double>(covered));
+}
@@ -0,0 +1,64 @@
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include <cstdint>
+
+/**
+ * Reorders triangles and vertices for the GPU, after Sander, Nehab and Barczak, "Fast Triangle Reordering for
+ * Vertex Locality and Reduced Overdraw" (2007). A mesh is meant to go through the stages in order: weld, vertex
+ * cache (Tipsify), overdraw, vertex fetch. None of them changes the triangles themselves or their winding.
+ *
+ * The vertex cache is modelled as a FIFO of VERTEX_CACHE_SIZE entries, which is what Tipsify optimizes for and
+ * what the analysis reports: ACMR, vertex shader runs per triangle (0.5 is the best a regular grid can do,
+ * 3 means no reuse at all), and ATVR, vertex shader runs per vertex (1 is ideal).
+ */
+namespace MeshOptimizer
+{
+    constexpr uint32_t VERTEX_CACHE_SIZE = 16u;
+
+    struct VertexCacheStats
+    {
+        uint32_t m_uTriangles = 0u;
+        uint32_t m_uVertices = 0u; // referenced by the indices
+        uint32_t m_uMisses = 0u;
+
+        float getAcmr() const { return m_uTriangles == 0u ? 0.0f : static_cast<float>(m_uMisses) / static_cast<float>(m_uTriangles); }
+        float getAtvr() const { return m_uVertices == 0u ? 0.0f : static_cast<float>(m_uMisses) / static_cast<float>(m_uVertices); }
+
+        VertexCacheStats& operator+=(const VertexCacheStats& rhs)
+        {
+            m_uTriangles += rhs.m_uTriangles;
+            m_uVertices += rhs.m_uVertices;
+            m_uMisses += rhs.m_uMisses;
+            return *this;
+        }
+    };
+
+    // Maps every vertex to the first one with the same bytes, remap[v] is its index among the unique vertices.
+    // Returns the unique vertex count. Vertices must not contain padding.
+    uint32_t generateVertexRemap(uint32_t* remap, const void* vertices, uint32_t vertexCount, uint32_t vertexSize);
+    // destination has room for the unique vertices, indices may be rewritten in place
+    void remapVertices(void* destination, const void* vertices, uint32_t vertexCount, uint32_t vertexSize, const uint32_t* remap);
+    void remapIndices(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const uint32_t* remap);
+
+    // Tipsify: fans around the vertex most likely to still be in the cache, destination must not alias indices
+    void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+    // Expects indices optimized for the vertex cache. Splits them into clusters where the cache was flushed, and
+    // further where that raises the ACMR by at most threshold (1.05 = 5%), then draws the clusters facing away
+    // from the mesh's center first. positions are three floats every stride floats, destination must not alias
+    // indices.
+    void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride,
+                          float threshold);
+
+    // Orders the vertices by first use and rewrites indices in place. Returns the vertex count written to
+    // destination, unreferenced vertices are dropped. destination must not alias vertices.
+    uint32_t optimizeVertexFetch(void* destination, uint32_t* indices, uint32_t indexCount, const void* vertices, uint32_t vertexCount, uint32_t vertexSize);
+
+    VertexCacheStats analyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+    // Pixels shaded per pixel covered, rasterized in index order with a depth test from the six axis directions
+    float analyzeOverdraw(const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride);
+}
+
+#endif // MESH_OPTIMIZER_HPP
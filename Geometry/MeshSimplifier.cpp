@@ -0,0 +1,322 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    // Symmetric 4x4 sum of plane * plane^T (upper triangle) and the area those planes were weighted with
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+        double weight = 0.0;
+
+        static Quadric fromPlane(double a, double b, double c, double d, double area)
+        {
+            Quadric q;
+            q.a00 = a * a * area; q.a01 = a * b * area; q.a02 = a * c * area; q.a03 = a * d * area;
+            q.a11 = b * b * area; q.a12 = b * c * area; q.a13 = b * d * area;
+            q.a22 = c * c * area; q.a23 = c * d * area;
+            q.a33 = d * d * area;
+            q.weight = area;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& rhs)
+        {
+            a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02; a03 += rhs.a03;
+            a11 += rhs.a11; a12 += rhs.a12; a13 += rhs.a13;
+            a22 += rhs.a22; a23 += rhs.a23;
+            a33 += rhs.a33;
+            weight += rhs.weight;
+            return *this;
+        }
+
+        // Area weighted mean of the squared distances from p to the planes
+        double getError(const glm::vec3& p) const
+        {
+            const double x = p.x;
+            const double y = p.y;
+            const double z = p.z;
+
+            const double error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+                               + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+                               + a22 * z * z + 2.0 * a23 * z
+                               + a33;
+
+            return weight > 0.0 ? std::max(error / weight, 0.0) : 0.0;
+        }
+    };
+
+    Quadric operator+(Quadric lhs, const Quadric& rhs)
+    {
+        lhs += rhs;
+        return lhs;
+    }
+
+    struct Collapse
+    {
+        uint32_t m_uFrom;
+        uint32_t m_uTo;
+        double m_dError;
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3& p) const
+        {
+            uint32_t bits[3];
+            memcpy(bits, &p.x, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual
+    {
+        bool operator()(const glm::vec3& lhs, const glm::vec3& rhs) const { return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z; }
+    };
+
+    uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    glm::vec3 getNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+    {
+        return glm::cross(p1 - p0, p2 - p0);
+    }
+}
+
+uint32_t MeshSimplifier::simplify(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride,
+                                  uint32_t targetIndexCount, float maxError, float* error)
+{
+    assert(indexCount % 3u == 0u);
+
+    // Weld, every vertex is represented by the first one at its position
+    std::vector<glm::vec3> vertexPositions(vertexCount);
+    std::vector<uint32_t> welded(vertexCount);
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> firstAtPosition;
+        firstAtPosition.reserve(vertexCount);
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            vertexPositions[v] = glm::vec3(positions[v * stride], positions[v * stride + 1u], positions[v * stride + 2u]);
+            welded[v] = firstAtPosition.emplace(vertexPositions[v], v).first->second;
+        }
+    }
+
+    uint32_t* result = destination;
+    uint32_t resultCount = indexCount;
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        assert(indices[i] < vertexCount);
+        result[i] = welded[indices[i]];
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (uint32_t i = 0; i < indexCount; i += 3u)
+    {
+        const glm::vec3& p0 = vertexPositions[result[i]];
+        const glm::vec3& p1 = vertexPositions[result[i + 1u]];
+        const glm::vec3& p2 = vertexPositions[result[i + 2u]];
+
+        const glm::vec3 normal = getNormal(p0, p1, p2);
+        const double length = std::sqrt(static_cast<double>(glm::dot(normal, normal)));
+        if (length == 0.0)
+            continue;
+
+        const double a = normal.x / length;
+        const double b = normal.y / length;
+        const double c = normal.z / length;
+        const double d = -(a * p0.x + b * p0.y + c * p0.z);
+
+        const Quadric quadric = Quadric::fromPlane(a, b, c, d, length * 0.5);
+        quadrics[result[i]] += quadric;
+        quadrics[result[i + 1u]] += quadric;
+        quadrics[result[i + 2u]] += quadric;
+    }
+
+    // Endpoints of edges with a single triangle are on a border and stay where they are
+    std::vector<uint8_t> locked(vertexCount, 0u);
+    std::vector<uint64_t> edges;
+    edges.reserve(indexCount);
+
+    for (uint32_t i = 0; i < indexCount; i += 3u)
+    {
+        edges.push_back(makeEdgeKey(result[i], result[i + 1u]));
+        edges.push_back(makeEdgeKey(result[i + 1u], result[i + 2u]));
+        edges.push_back(makeEdgeKey(result[i + 2u], result[i]));
+    }
+
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t end = i + 1u;
+        while (end < edges.size() && edges[end] == edges[i])
+            ++end;
+
+        if (end - i == 1u)
+        {
+            locked[static_cast<uint32_t>(edges[i] >> 32)] = 1u;
+            locked[static_cast<uint32_t>(edges[i])] = 1u;
+        }
+
+        i = end;
+    }
+
+    const double maxErrorSquared = static_cast<double>(maxError) * static_cast<double>(maxError);
+    double resultError = 0.0;
+
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> fanOffsets(vertexCount + 1u);
+    std::vector<uint32_t> fans;
+    std::vector<Collapse> collapses;
+
+    while (resultCount > targetIndexCount)
+    {
+        const uint32_t triangleCount = resultCount / 3u;
+
+        // Triangles around every vertex
+        std::fill(fanOffsets.begin(), fanOffsets.end(), 0u);
+        for (uint32_t i = 0; i < resultCount; ++i)
+            ++fanOffsets[result[i] + 1u];
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            fanOffsets[v + 1u] += fanOffsets[v];
+
+        fans.resize(resultCount);
+        {
+            std::vector<uint32_t> cursor(fanOffsets.begin(), fanOffsets.end() - 1);
+            for (uint32_t i = 0; i < resultCount; ++i)
+                fans[cursor[result[i]]++] = i / 3u;
+        }
+
+        // Every edge once, collapsed in its cheaper direction
+        edges.clear();
+        for (uint32_t i = 0; i < resultCount; i += 3u)
+        {
+            edges.push_back(makeEdgeKey(result[i], result[i + 1u]));
+            edges.push_back(makeEdgeKey(result[i + 1u], result[i + 2u]));
+            edges.push_back(makeEdgeKey(result[i + 2u], result[i]));
+        }
+
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t edge : edges)
+        {
+            const uint32_t a = static_cast<uint32_t>(edge >> 32);
+            const uint32_t b = static_cast<uint32_t>(edge);
+            const Quadric quadric = quadrics[a] + quadrics[b];
+
+            const double errorAtB = locked[a] ? DBL_MAX : quadric.getError(vertexPositions[b]);
+            const double errorAtA = locked[b] ? DBL_MAX : quadric.getError(vertexPositions[a]);
+
+            const Collapse collapse = errorAtB <= errorAtA ? Collapse { a, b, errorAtB } : Collapse { b, a, errorAtA };
+            if (collapse.m_dError <= maxErrorSquared)
+                collapses.push_back(collapse);
+        }
+
+        if (collapses.empty())
+            break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.m_dError < rhs.m_dError; });
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            collapseTo[v] = v;
+        std::fill(touched.begin(), touched.end(), 0u);
+
+        // An interior edge takes its two triangles with it
+        const uint32_t trianglesToRemove = triangleCount - targetIndexCount / 3u;
+        uint32_t trianglesRemoved = 0u;
+        uint32_t collapseCount = 0u;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (trianglesRemoved >= trianglesToRemove)
+                break;
+
+            const uint32_t from = collapse.m_uFrom;
+            const uint32_t to = collapse.m_uTo;
+
+            // Fans touched by an earlier collapse of this pass are out of date, so is a target that moved away
+            if (touched[from] != 0u || collapseTo[to] != to)
+                continue;
+
+            bool flips = false;
+            uint32_t removed = 0u;
+
+            for (uint32_t f = fanOffsets[from]; f < fanOffsets[from + 1u] && !flips; ++f)
+            {
+                const uint32_t* triangle = result + fans[f] * 3u;
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                {
+                    ++removed;
+                    continue;
+                }
+
+                glm::vec3 moved[3];
+                for (uint32_t corner = 0; corner < 3u; ++corner)
+                    moved[corner] = vertexPositions[triangle[corner] == from ? to : triangle[corner]];
+
+                const glm::vec3 before = getNormal(vertexPositions[triangle[0]], vertexPositions[triangle[1]], vertexPositions[triangle[2]]);
+                const glm::vec3 after = getNormal(moved[0], moved[1], moved[2]);
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+
+            if (flips)
+                continue;
+
+            collapseTo[from] = to;
+            quadrics[to] += quadrics[from];
+            resultError = std::max(resultError, collapse.m_dError);
+
+            for (uint32_t f = fanOffsets[from]; f < fanOffsets[from + 1u]; ++f)
+            {
+                const uint32_t* triangle = result + fans[f] * 3u;
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1u;
+            }
+
+            trianglesRemoved += removed;
+            ++collapseCount;
+        }
+
+        if (collapseCount == 0u)
+            break;
+
+        // Rewrite the indices and drop the triangles that lost an edge
+        uint32_t written = 0u;
+        for (uint32_t i = 0; i < resultCount; i += 3u)
+        {
+            const uint32_t a = collapseTo[result[i]];
+            const uint32_t b = collapseTo[result[i + 1u]];
+            const uint32_t c = collapseTo[result[i + 2u]];
+
+            if (a == b || b == c || c == a)
+                continue;
+
+            result[written++] = a;
+            result[written++] = b;
+            result[written++] = c;
+        }
+
+        resultCount = written;
+    }
+
+    if (error != nullptr)
+        *error = static_cast<float>(std::sqrt(resultError));
+
+    return resultCount;
+}
@@ -0,0 +1,30 @@
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include <cstdint>
+
+/**
+ * Quadric error edge collapse (Garland/Heckbert) that only rewrites the index buffer.
+ *
+ * Every vertex accumulates the area weighted planes of its triangles. Collapsing an edge moves one endpoint onto
+ * the other, which is an existing vertex, so the simplified triangles keep referencing the original vertex buffer
+ * and a LOD is just another index range. The error of a collapse is the area weighted mean of the squared
+ * distances from the target to the planes of both endpoints.
+ *
+ * Collapses are done in passes: the cheapest candidates of every pass are applied as long as they touch disjoint
+ * triangle fans, then the triangles are compacted and the next pass starts. Collapses that would flip a triangle
+ * are rejected and vertices on open borders never move, so planes and holes keep their outline.
+ *
+ * Vertices with identical positions are welded before simplifying, the output references the first vertex of
+ * every position. That is exact as long as vertices carry positions only.
+ */
+namespace MeshSimplifier
+{
+    // positions are three floats every stride floats. Writes at most indexCount indices to destination and returns
+    // how many, stopping at targetIndexCount or when the next collapse would move a surface further than maxError
+    // (model units). error, when set, receives the largest error of the collapses done.
+    uint32_t simplify(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride,
+                      uint32_t targetIndexCount, float maxError, float* error = nullptr);
+}
+
+#endif // MESH_SIMPLIFIER_HPP
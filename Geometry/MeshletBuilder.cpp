@@ -0,0 +1,128 @@
+#include "MeshletBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "../Visibility/Bounds.hpp"
+
+namespace
+{
+    glm::vec3 getPosition(const float* positions, uint32_t stride, uint32_t v)
+    {
+        const float* position = positions + static_cast<size_t>(v) * stride;
+        return glm::vec3(position[0], position[1], position[2]);
+    }
+
+    // Sphere around the box center of the range's vertices, cone over its face normals
+    Meshlet computeBounds(const uint32_t* indices, uint32_t firstIndex, uint32_t indexCount, const float* positions, uint32_t stride, bool doubleSided)
+    {
+        Aabb aabb;
+        for (uint32_t i = firstIndex; i < firstIndex + indexCount; ++i)
+            aabb.expand(getPosition(positions, stride, indices[i]));
+
+        Meshlet meshlet {};
+        meshlet.m_v3Center = (aabb.m_v3Min + aabb.m_v3Max) * 0.5f;
+        meshlet.m_uFirstIndex = firstIndex;
+        meshlet.m_uIndexCount = indexCount;
+
+        float radiusSquared = 0.0f;
+        for (uint32_t i = firstIndex; i < firstIndex + indexCount; ++i)
+        {
+            const glm::vec3 offset = getPosition(positions, stride, indices[i]) - meshlet.m_v3Center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        meshlet.m_fRadius = std::sqrt(radiusSquared);
+
+        // Never culls until a valid cone is found
+        meshlet.m_v3ConeAxis = glm::vec3(0.0f);
+        meshlet.m_fConeCutoff = 1.0f;
+        if (doubleSided)
+            return meshlet;
+
+        // Degenerate triangles face nowhere, they neither widen the cone nor are ever drawn
+        glm::vec3 normalSum(0.0f);
+        for (uint32_t i = firstIndex; i < firstIndex + indexCount; i += 3u)
+        {
+            const glm::vec3 p0 = getPosition(positions, stride, indices[i + 0u]);
+            const glm::vec3 normal = glm::cross(getPosition(positions, stride, indices[i + 1u]) - p0, getPosition(positions, stride, indices[i + 2u]) - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+                normalSum += normal / length;
+        }
+
+        const float sumLength = glm::length(normalSum);
+        if (sumLength <= 0.0f)
+            return meshlet;
+
+        const glm::vec3 axis = normalSum / sumLength;
+        float minDot = 1.0f;
+        for (uint32_t i = firstIndex; i < firstIndex + indexCount; i += 3u)
+        {
+            const glm::vec3 p0 = getPosition(positions, stride, indices[i + 0u]);
+            const glm::vec3 normal = glm::cross(getPosition(positions, stride, indices[i + 1u]) - p0, getPosition(positions, stride, indices[i + 2u]) - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+                minDot = std::min(minDot, glm::dot(normal / length, axis));
+        }
+
+        // A half sphere or more of normals always has a triangle facing the viewer
+        if (minDot <= 0.0f)
+            return meshlet;
+
+        meshlet.m_v3ConeAxis = axis;
+        meshlet.m_fConeCutoff = std::sqrt(1.0f - minDot * minDot);
+        return meshlet;
+    }
+}
+
+uint32_t MeshletBuilder::build(std::vector<Meshlet>& meshlets, const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride,
+                               bool doubleSided)
+{
+    const size_t firstMeshlet = meshlets.size();
+
+    // Meshlet that last referenced the vertex, counts every vertex once per meshlet
+    std::vector<uint32_t> vertexMeshlet(vertexCount, ~0u);
+    uint32_t meshlet = 0u;
+    uint32_t meshletStart = 0u;
+    uint32_t meshletVertices = 0u;
+
+    const auto finish = [&](uint32_t end) {
+        meshlets.push_back(computeBounds(indices, meshletStart, end - meshletStart, positions, stride, doubleSided));
+        meshlets.back().m_uVertexCount = meshletVertices;
+    };
+
+    for (uint32_t i = 0; i + 2u < indexCount; i += 3u)
+    {
+        const uint32_t a = indices[i + 0u];
+        const uint32_t b = indices[i + 1u];
+        const uint32_t c = indices[i + 2u];
+
+        const auto countNew = [&]() {
+            return static_cast<uint32_t>(vertexMeshlet[a] != meshlet) +
+                   static_cast<uint32_t>(vertexMeshlet[b] != meshlet && b != a) +
+                   static_cast<uint32_t>(vertexMeshlet[c] != meshlet && c != a && c != b);
+        };
+
+        uint32_t newVertices = countNew();
+        if (meshletVertices + newVertices > MAX_VERTICES || (i - meshletStart) / 3u == MAX_TRIANGLES)
+        {
+            finish(i);
+            ++meshlet;
+            meshletStart = i;
+            meshletVertices = 0u;
+            newVertices = countNew();
+        }
+
+        vertexMeshlet[a] = meshlet;
+        vertexMeshlet[b] = meshlet;
+        vertexMeshlet[c] = meshlet;
+        meshletVertices += newVertices;
+    }
+
+    if (indexCount >= 3u)
+        finish(indexCount / 3u * 3u);
+
+    return static_cast<uint32_t>(meshlets.size() - firstMeshlet);
+}
@@ -0,0 +1,53 @@
+#ifndef MESHLET_BUILDER_HPP
+#define MESHLET_BUILDER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+/**
+ * Small piece of a primitive, culled on its own by the ClusterCuller (Visibility/ClusterCuller.hpp).
+ *
+ * The sphere bounds the meshlet's vertices, the cone its face normals: every triangle faces away from a viewer
+ * at p when dot(center - p, axis) >= cutoff * |center - p| + radius. A cutoff of 1 never culls, meshlets whose
+ * normals spread over more than a half sphere and double-sided ones get it. Local space of the primitive.
+ */
+struct Meshlet
+{
+    glm::vec3 m_v3Center;
+    float m_fRadius;
+
+    glm::vec3 m_v3ConeAxis;
+    float m_fConeCutoff; // sine of the angle between the axis and the normal farthest from it
+
+    // Index range relative to the primitive's first index, a draw of it is the primitive's renderable narrowed
+    // to the range, with the meshlet's own primitive id so instancing does not merge it with anything else
+    uint32_t m_uFirstIndex;
+    uint32_t m_uIndexCount;
+    uint32_t m_uPrimitive;
+    uint32_t m_uVertexCount;
+};
+
+/**
+ * Splits a primitive into meshlets of at most MAX_VERTICES distinct vertices and MAX_TRIANGLES triangles.
+ *
+ * Without mesh shaders a meshlet is drawn as an index range, so the split keeps the index order: triangles are
+ * taken in order and a new meshlet starts whenever the next one would exceed either limit. Meant to run on
+ * indices already ordered by MeshOptimizer, whose cache and overdraw clusters are compact and mostly face one
+ * way, which is what keeps the spheres small and the cones narrow. The limits are those of the common mesh
+ * shader layouts, so the same meshlets can feed a mesh shader path later.
+ */
+namespace MeshletBuilder
+{
+    constexpr uint32_t MAX_VERTICES = 64u;
+    constexpr uint32_t MAX_TRIANGLES = 124u;
+
+    // Appends the meshlets of the primitive to meshlets and returns how many. positions are three floats every
+    // stride floats, indices are relative to them. Primitive ids are left 0. Double-sided primitives get
+    // cones that never cull.
+    uint32_t build(std::vector<Meshlet>& meshlets, const uint32_t* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint32_t stride,
+                   bool doubleSided);
+}
+
+#endif // MESHLET_BUILDER_HPP
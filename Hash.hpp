@@ -0,0 +1,105 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * 64 bit hash in the style of wyhash (Wang Yi): 16 bytes per step are folded into the state with a 64x64 -> 128 bit
+ * multiply whose halves are xor-ed together, and the result goes through one more multiply-fold as avalanche. Every
+ * input bit reaches every output bit, so unlike a plain FNV-1a no pattern of bit flips cancels out. A call hashes its
+ * bytes with the key passed in as seed, chained calls hash a sequence of fields.
+ *
+ * Key128 runs two such lanes with independent constants, for callers that take a matching key as identity. Change
+ * detection (cooked files, the BVH cache) and hash tables use the 64 bit key. The keys are not cryptographic, they
+ * are only meant to be unique for data that is not crafted to collide.
+ */
+namespace Hash
+{
+    constexpr uint64_t SEED = 0xCBF29CE484222325ull;
+
+    struct Key128
+    {
+        uint64_t m_uLow;
+        uint64_t m_uHigh;
+
+        bool operator==(const Key128& other) const { return m_uLow == other.m_uLow && m_uHigh == other.m_uHigh; }
+        bool operator!=(const Key128& other) const { return !(*this == other); }
+    };
+
+    constexpr Key128 SEED_128 { SEED, 0x9E3779B97F4A7C15ull };
+
+    // For unordered containers, the low lane is already uniform
+    struct Key128Hasher
+    {
+        size_t operator()(const Key128& key) const { return static_cast<size_t>(key.m_uLow); }
+    };
+
+    struct Secrets
+    {
+        uint64_t m_uFold;
+        uint64_t m_uFinal;
+    };
+
+    constexpr Secrets SECRETS_LOW { 0xA0761D6478BD642Full, 0xE7037ED1A0B428DBull };
+    constexpr Secrets SECRETS_HIGH { 0x8EBC6AF09C88C6E3ull, 0x589965CC75374CC3ull };
+
+    inline uint64_t mix(uint64_t a, uint64_t b)
+    {
+        const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64u);
+    }
+
+    inline uint64_t read64(const unsigned char* data)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        return word;
+    }
+
+    // Up to 8 bytes, zero extended
+    inline uint64_t readTail(const unsigned char* data, size_t size)
+    {
+        uint64_t word = 0u;
+        memcpy(&word, data, size);
+        return word;
+    }
+
+    inline uint64_t lane(uint64_t key, const void* data, size_t size, const Secrets& secrets)
+    {
+        const unsigned char* source = static_cast<const unsigned char*>(data);
+        uint64_t state = key ^ mix(key ^ secrets.m_uFold, secrets.m_uFinal);
+
+        // The state is xor-ed back in, a step whose product happens to be zero does not lose it
+        size_t i = 0u;
+        for (; i + 16u <= size; i += 16u)
+            state ^= mix(read64(source + i) ^ secrets.m_uFold, read64(source + i + 8u) ^ state);
+
+        const size_t tail = size - i;
+        const uint64_t a = tail > 8u ? read64(source + i) : readTail(source + i, tail);
+        const uint64_t b = tail > 8u ? readTail(source + i + 8u, tail - 8u) : 0u;
+        state ^= mix(a ^ secrets.m_uFold, b ^ state);
+
+        return mix(state ^ secrets.m_uFinal, static_cast<uint64_t>(size) ^ secrets.m_uFold);
+    }
+
+    inline uint64_t bytes(uint64_t key, const void* data, size_t size)
+    {
+        return lane(key, data, size, SECRETS_LOW);
+    }
+
+    inline Key128 bytes(const Key128& key, const void* data, size_t size)
+    {
+        return { lane(key.m_uLow, data, size, SECRETS_LOW), lane(key.m_uHigh, data, size, SECRETS_HIGH) };
+    }
+
+    // The object representation, only for types without padding
+    template <typename Key, typename T>
+    Key value(const Key& key, const T& object)
+    {
+        return bytes(key, &object, sizeof(T));
+    }
+}
+
+#endif // HASH_HPP
@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <string>
@@ -8,6 +15,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <tinygltf/tiny_gltf.h>
+#include <tinygltf/json.hpp>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,19 +23,88 @@
 
 #include "Loader.hpp"
 #include "Buffer.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
 #include "Model.hpp"
+#include "PrototypeCache.hpp"
+#include "Renderer/GeometryPool.hpp"
+#include "Renderer/TexturePool.hpp"
+#include "Renderer/VertexLayout.hpp"
+#include "Visibility/Bounds.hpp"
+#include "Geometry/IndexConversion.hpp"
+#include "Geometry/MeshletBuilder.hpp"
+#include "Geometry/MeshOptimizer.hpp"
+#include "Geometry/MeshSimplifier.hpp"
 
 namespace
 {
     constexpr bool LOADER_DEBUG = true;
 
+    // Next Renderable::primitive id, unique across every loaded file, files are decoded in parallel
+    std::atomic<uint32_t> g_uPrimitiveCount { 0u };
+
+    // Every prototype alive, shared by all nodes, files and batches that load the same mesh
+    PrototypeCache g_PrototypeCache;
+
+    // LODs per primitive including the original. Every level aims at half the triangles of the previous one and
+    // may move the surface by MESH_LOD_BASE_ERROR of the primitive's radius, twice that for every further level.
+    constexpr uint32_t MESH_LOD_COUNT = 4u;
+    constexpr float MESH_LOD_BASE_ERROR = 0.01f;
+
+    // No level is generated from fewer triangles or when it would keep more than MESH_LOD_MAX_RATIO of them
+    constexpr uint32_t MESH_LOD_MIN_TRIANGLES = 64u;
+    constexpr float MESH_LOD_MAX_RATIO = 0.8f;
+
+    // Clusters of a primitive may be split for draw order as long as that costs at most 5% of its vertex cache hits
+    constexpr float MESH_OVERDRAW_THRESHOLD = 1.05f;
+
+    // Prototypes whose primitives all have at most this many vertices get a 16 bit index buffer. Indices are
+    // relative to the primitive's first vertex and 0xFFFF stays free as the primitive restart value.
+    constexpr uint32_t MAX_SHORT_INDEX_VERTEX_COUNT = 0xFFFFu;
+
+    // Full precision while decoding, welding and simplifying. Attributes MESH_VERTEX_LAYOUT has no room for stay
+    // zero, so they do not keep vertices apart.
     struct Vertex
     {
         glm::vec3 pos;
-        // glm::vec3 normal;
-        // glm::vec2 uv;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    // CPU side of a prototype, kept until uploadPrototype() created its buffers
+    struct DecodedPrototype
+    {
+        std::shared_ptr<ModelPrototype> m_pPrototype;
+        std::vector<Vertex> m_vVertexData;         // while decoding
+        std::vector<unsigned char> m_vVertexBytes; // m_vVertexData encoded in MESH_VERTEX_LAYOUT, uploaded
+        std::vector<uint32_t> m_vIndexData;      // while decoding, and uploaded for VK_INDEX_TYPE_UINT32
+        std::vector<uint16_t> m_vShortIndexData; // uploaded for VK_INDEX_TYPE_UINT16
+    };
+
+    struct StbImageDeleter
+    {
+        void operator()(unsigned char* pixels) const { stbi_image_free(pixels); }
     };
 
+    struct DecodedGLTF
+    {
+        std::vector<Model> m_vModels;
+
+        // What uploadGLTF() copies into buffers, pointing into m_vPrototypes or m_Cache. Prototypes the
+        // PrototypeCache already had are not in here, their buffers exist or are uploaded with another file.
+        std::vector<MeshCache::Prototype> m_vUploads;
+
+        // Every image the prototypes' MeshCache::Prototype::m_vImages refer to, pointing into m_vPixels or m_Cache
+        std::vector<TexturePool::Image> m_vImages;
+
+        std::vector<DecodedPrototype> m_vPrototypes; // decoded from the glTF
+        std::vector<std::unique_ptr<unsigned char, StbImageDeleter>> m_vPixels;
+        MeshCache m_Cache;                           // or mapped from its cooked file
+    };
+
+    // Cooked files live next to their source, "Plane.gltf" is cooked into "Plane.gltf.cooked"
+    constexpr const char* COOKED_MESH_EXTENSION = ".cooked";
+
 #ifdef MATERIAL_LOADING
     static std::unordered_map<std::string, std::unique_ptr<BaseMaterial>> g_MaterialMap;
 
@@ -68,13 +145,238 @@ namespace
     }
 #endif
 
-    bool loadModel(tinygltf::Model &model, const char *filename)
+    // Where the bytes of a glTF buffer are, a file mapping or tinygltf's copy of a data URI
+    struct BufferRange
+    {
+        const unsigned char* m_pData;
+        size_t m_uSize;
+    };
+
+    // Parsed glTF whose accessors are read straight from mappings of the .glb/.gltf and its external buffers
+    struct GLTFFile
+    {
+        tinygltf::Model m_Model;
+        std::vector<MappedFile> m_vMappings;
+        std::vector<std::string> m_vDependencies; // paths of the mapped files, the cooked file's source key covers them
+        std::vector<BufferRange> m_vBuffers; // parallel to m_Model.buffers
+        std::vector<BufferRange> m_vImages;  // encoded bytes, parallel to m_Model.images, empty when missing
+    };
+
+    // tinygltf loads every buffer and image it is given, mapped ones are replaced by these one byte stand-ins
+    constexpr const char* STAND_IN_BUFFER_URI = "data:application/octet-stream;base64,AA==";
+    constexpr const char* STAND_IN_IMAGE_URI = "data:image/png;base64,AA==";
+
+    constexpr uint32_t GLB_MAGIC = 0x46546C67u;      // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534Au; // "JSON"
+    constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942u;  // "BIN\0"
+
+    uint32_t readUint32(const unsigned char* data)
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Splits a .glb into its JSON and (optional) BIN chunk, false when the container is damaged
+    bool splitGLB(const MappedFile& mapping, BufferRange& json, BufferRange& bin)
+    {
+        const unsigned char* data = mapping.getData();
+        const size_t size = mapping.getSize();
+
+        if (size < 20u || readUint32(data + 8u) > size)
+            return false;
+
+        size_t offset = 12u;
+        json = { nullptr, 0u };
+        bin = { nullptr, 0u };
+
+        while (offset + 8u <= size)
+        {
+            const uint32_t chunkLength = readUint32(data + offset);
+            const uint32_t chunkType = readUint32(data + offset + 4u);
+            offset += 8u;
+
+            if (chunkLength > size - offset)
+                return false;
+
+            // The first chunk must be JSON, the first BIN chunk after it is buffer 0, unknown chunks are skipped
+            if (json.m_pData == nullptr)
+            {
+                if (chunkType != GLB_CHUNK_JSON)
+                    return false;
+                json = { data + offset, chunkLength };
+            }
+            else if (chunkType == GLB_CHUNK_BIN && bin.m_pData == nullptr)
+            {
+                bin = { data + offset, chunkLength };
+            }
+
+            offset += chunkLength;
+        }
+
+        return json.m_pData != nullptr;
+    }
+
+    bool isDataUri(const std::string& uri)
+    {
+        return uri.compare(0u, 5u, "data:") == 0;
+    }
+
+    // Relative URIs may be percent-encoded ("my%20mesh.bin")
+    std::string decodeUri(const std::string& uri)
     {
+        std::string path;
+        path.reserve(uri.size());
+
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2u < uri.size() && isxdigit(static_cast<unsigned char>(uri[i + 1u])) && isxdigit(static_cast<unsigned char>(uri[i + 2u])))
+            {
+                path += static_cast<char>(std::stoi(uri.substr(i + 1u, 2u), nullptr, 16));
+                i += 2u;
+            }
+            else
+            {
+                path += uri[i];
+            }
+        }
+
+        return path;
+    }
+
+    // Keeps tinygltf from decoding images, only the ones materials of decoded meshes sample are decoded, later and
+    // once. Data URIs are kept encoded. Images in buffer views are handed pointers into the stand-in buffers and
+    // are read from the mappings instead.
+    bool keepEncodedImage(tinygltf::Image* image, const int, std::string*, std::string*, int, int, const unsigned char* bytes, int size, void*)
+    {
+        if (image->bufferView < 0)
+            image->image.assign(bytes, bytes + size);
+        return true;
+    }
+
+    // .gltf and .glb. The file and every external buffer are mapped, tinygltf only parses the JSON and decodes
+    // data URIs, so the only heap copy of mapped geometry is the one the loader builds its vertices in.
+    bool loadModel(GLTFFile &file, const char *filename)
+    {
+        MappedFile mapping;
+        if (!mapping.open(filename))
+        {
+            std::cout << "Failed to open glTF: " << filename << std::endl;
+            return false;
+        }
+
+        BufferRange json { mapping.getData(), mapping.getSize() };
+        BufferRange bin { nullptr, 0u };
+
+        if (mapping.getSize() >= 4u && readUint32(mapping.getData()) == GLB_MAGIC && !splitGLB(mapping, json, bin))
+        {
+            std::cout << "Invalid GLB container: " << filename << std::endl;
+            return false;
+        }
+
+        nlohmann::json document = nlohmann::json::parse(json.m_pData, json.m_pData + json.m_uSize, nullptr, false);
+        if (document.is_discarded() || !document.is_object())
+        {
+            std::cout << "Invalid glTF JSON: " << filename << std::endl;
+            return false;
+        }
+
+        file.m_vMappings.push_back(std::move(mapping));
+        file.m_vDependencies.push_back(filename);
+
+        const std::string path = filename;
+        const size_t separator = path.find_last_of("/\\");
+        const std::string baseDir = separator == std::string::npos ? std::string() : path.substr(0u, separator + 1u);
+
+        nlohmann::json::iterator buffers = document.find("buffers");
+        if (buffers != document.end() && buffers->is_array())
+        {
+            for (nlohmann::json& buffer : *buffers)
+            {
+                BufferRange range { nullptr, 0u };
+
+                nlohmann::json::iterator uri = buffer.find("uri");
+                if (uri == buffer.end())
+                {
+                    range = bin;
+                }
+                else if (uri->is_string() && !isDataUri(uri->get<std::string>()))
+                {
+                    const std::string bufferPath = baseDir + decodeUri(uri->get<std::string>());
+
+                    MappedFile external;
+                    if (!external.open(bufferPath.c_str()))
+                    {
+                        std::cout << "Failed to open glTF buffer: " << bufferPath << std::endl;
+                        return false;
+                    }
+
+                    range = { external.getData(), external.getSize() };
+                    file.m_vMappings.push_back(std::move(external));
+                    file.m_vDependencies.push_back(bufferPath);
+                }
+                else
+                {
+                    // Data URI, filled in from tinygltf's decoded copy below
+                    file.m_vBuffers.push_back(range);
+                    continue;
+                }
+
+                if (range.m_pData == nullptr || (buffer.find("byteLength") != buffer.end() && buffer["byteLength"].is_number_unsigned() && buffer["byteLength"].get<size_t>() > range.m_uSize))
+                {
+                    std::cout << "glTF buffer larger than its data: " << filename << std::endl;
+                    return false;
+                }
+
+                buffer["uri"] = STAND_IN_BUFFER_URI;
+                buffer["byteLength"] = 1u;
+                file.m_vBuffers.push_back(range);
+            }
+        }
+
+        // External images are mapped like buffers. A missing one only costs its texture, as with tinygltf.
+        std::vector<bool> externalImages;
+        nlohmann::json::iterator images = document.find("images");
+        if (images != document.end() && images->is_array())
+        {
+            for (nlohmann::json& image : *images)
+            {
+                BufferRange range { nullptr, 0u };
+
+                nlohmann::json::iterator uri = image.find("uri");
+                externalImages.push_back(uri != image.end() && uri->is_string() && !isDataUri(uri->get<std::string>()));
+                if (externalImages.back())
+                {
+                    const std::string imagePath = baseDir + decodeUri(uri->get<std::string>());
+
+                    MappedFile external;
+                    if (external.open(imagePath.c_str()))
+                    {
+                        range = { external.getData(), external.getSize() };
+                        file.m_vMappings.push_back(std::move(external));
+                        file.m_vDependencies.push_back(imagePath);
+                    }
+                    else
+                    {
+                        std::cout << "Failed to open glTF image: " << imagePath << std::endl;
+                    }
+
+                    image["uri"] = STAND_IN_IMAGE_URI;
+                }
+
+                file.m_vImages.push_back(range);
+            }
+        }
+
+        const std::string stripped = document.dump();
+
         tinygltf::TinyGLTF loader;
+        loader.SetImageLoader(keepEncodedImage, nullptr);
+
         std::string err;
         std::string warn;
 
-        bool res = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+        bool res = loader.LoadASCIIFromString(&file.m_Model, &err, &warn, stripped.c_str(), static_cast<unsigned int>(stripped.size()), baseDir);
         if (!warn.empty())
         {
             std::cout << "WARN: " << warn << std::endl;
@@ -85,6 +387,36 @@ namespace
             std::cout << "ERR: " << err << std::endl;
         }
 
+        if (res)
+        {
+            for (size_t i = 0; i < file.m_vBuffers.size(); ++i)
+            {
+                if (file.m_vBuffers[i].m_pData == nullptr)
+                    file.m_vBuffers[i] = { file.m_Model.buffers[i].data.data(), file.m_Model.buffers[i].data.size() };
+            }
+
+            // Data URIs from tinygltf's decoded copy, buffer views from the buffers they are in
+            file.m_vImages.resize(file.m_Model.images.size(), { nullptr, 0u });
+            externalImages.resize(file.m_Model.images.size(), false);
+            for (size_t i = 0; i < file.m_vImages.size(); ++i)
+            {
+                const tinygltf::Image& image = file.m_Model.images[i];
+                if (externalImages[i])
+                    continue;
+
+                if (image.bufferView < 0)
+                {
+                    file.m_vImages[i] = { image.image.data(), image.image.size() };
+                    continue;
+                }
+
+                const tinygltf::BufferView& bufferView = file.m_Model.bufferViews[image.bufferView];
+                const BufferRange& buffer = file.m_vBuffers[bufferView.buffer];
+                if (bufferView.byteOffset + bufferView.byteLength <= buffer.m_uSize)
+                    file.m_vImages[i] = { buffer.m_pData + bufferView.byteOffset, bufferView.byteLength };
+            }
+        }
+
         if (!res)
             std::cout << "Failed to load glTF: " << filename << std::endl;
         else
@@ -93,160 +425,739 @@ namespace
         return res;
     }
 
-    std::shared_ptr<ModelPrototype> processGLTFNode(const tinygltf::Model &gltfModel, const tinygltf::Node &gltfNode)
+    const unsigned char* getAccessorData(const GLTFFile& file, const tinygltf::Accessor& accessor)
     {
+        const tinygltf::BufferView& bufferView = file.m_Model.bufferViews[accessor.bufferView];
+        const BufferRange& buffer = file.m_vBuffers[bufferView.buffer];
+
+        assert(bufferView.byteOffset + bufferView.byteLength <= buffer.m_uSize && "Buffer view outside of its buffer!");
+        return buffer.m_pData + bufferView.byteOffset + accessor.byteOffset;
+    }
+
+    // Reads componentCount components of the first count elements of a float or normalized integer accessor into
+    // destination, stride floats from one element to the next
+    void readAttribute(const GLTFFile& file, const tinygltf::Accessor& accessor, uint32_t componentCount, uint32_t count, float* destination, uint32_t stride)
+    {
+        const tinygltf::BufferView& bufferView = file.m_Model.bufferViews[accessor.bufferView];
+        const unsigned char* source = getAccessorData(file, accessor);
+        const int32_t sourceStride = accessor.ByteStride(bufferView);
+        count = std::min(count, static_cast<uint32_t>(accessor.count));
+
+        for (uint32_t element = 0; element < count; ++element, source += sourceStride, destination += stride)
+        {
+            for (uint32_t component = 0; component < componentCount; ++component)
+            {
+                switch (accessor.componentType)
+                {
+                case TINYGLTF_PARAMETER_TYPE_FLOAT:
+                    memcpy(&destination[component], source + component * sizeof(float), sizeof(float));
+                    break;
+                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+                {
+                    uint16_t value;
+                    memcpy(&value, source + component * sizeof(uint16_t), sizeof(value));
+                    destination[component] = value / 65535.0f;
+                    break;
+                }
+                case TINYGLTF_PARAMETER_TYPE_SHORT:
+                {
+                    int16_t value;
+                    memcpy(&value, source + component * sizeof(int16_t), sizeof(value));
+                    destination[component] = std::max(value / 32767.0f, -1.0f);
+                    break;
+                }
+                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+                    destination[component] = source[component] / 255.0f;
+                    break;
+                case TINYGLTF_PARAMETER_TYPE_BYTE:
+                    destination[component] = std::max(static_cast<int8_t>(source[component]) / 127.0f, -1.0f);
+                    break;
+                default:
+                    std::cerr << "Attribute component type " << accessor.componentType << " not supported!" << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+
+    // Welds the primitive's vertices, reorders its triangles for the post-transform cache and then overdraw, and
+    // its vertices into the order the triangles fetch them. The primitive's vertices are the end of vertexData,
+    // starting at firstVertex, and are replaced. Returns their new count.
+    uint32_t optimizePrimitive(std::vector<Vertex>& vertexData, uint32_t firstVertex, uint32_t* indices, uint32_t indexCount,
+                               MeshOptimizer::VertexCacheStats& before, MeshOptimizer::VertexCacheStats& after)
+    {
+        const uint32_t vertexCount = static_cast<uint32_t>(vertexData.size()) - firstVertex;
+        Vertex* vertices = vertexData.data() + firstVertex;
+        before += MeshOptimizer::analyzeVertexCache(indices, indexCount, vertexCount);
+
+        std::vector<uint32_t> remap(vertexCount);
+        const uint32_t uniqueCount = MeshOptimizer::generateVertexRemap(remap.data(), vertices, vertexCount, sizeof(Vertex));
+        std::vector<Vertex> welded(uniqueCount);
+        MeshOptimizer::remapVertices(welded.data(), vertices, vertexCount, sizeof(Vertex), remap.data());
+        MeshOptimizer::remapIndices(indices, indices, indexCount, remap.data());
+
+        std::vector<uint32_t> cacheOrder(indexCount);
+        MeshOptimizer::optimizeVertexCache(cacheOrder.data(), indices, indexCount, uniqueCount);
+        MeshOptimizer::optimizeOverdraw(indices, cacheOrder.data(), indexCount, &welded.data()->pos.x, uniqueCount, sizeof(Vertex) / sizeof(float), MESH_OVERDRAW_THRESHOLD);
+
+        const uint32_t optimizedCount = MeshOptimizer::optimizeVertexFetch(vertices, indices, indexCount, welded.data(), uniqueCount, sizeof(Vertex));
+        vertexData.resize(firstVertex + optimizedCount);
+
+        after += MeshOptimizer::analyzeVertexCache(indices, indexCount, optimizedCount);
+        return optimizedCount;
+    }
+
+    // Appends the simplified levels of every primitive to indexData, each one simplified from the level before
+    void generateLods(ModelPrototype& prototype, const std::vector<Vertex>& vertexData, const std::vector<uint32_t>& primitiveVertexCounts, std::vector<uint32_t>& indexData)
+    {
+        const uint32_t primitiveCount = static_cast<uint32_t>(prototype.m_Renderables.size());
+
+        std::vector<std::vector<Renderable>> primitiveLods(primitiveCount);
+        std::vector<uint32_t> lodIndices;
+        std::vector<uint32_t> cacheOrder;
+        uint32_t lodCount = 1u;
+
+        for (uint32_t primitive = 0; primitive < primitiveCount; ++primitive)
+        {
+            const float radius = prototype.m_vPrimitiveBounds[primitive].m_fRadius;
+            Renderable previous = prototype.m_Renderables[primitive];
+
+            for (uint32_t lod = 1u; lod < MESH_LOD_COUNT; ++lod)
+            {
+                if (previous.indexCount / 3u < MESH_LOD_MIN_TRIANGLES)
+                    break;
+
+                lodIndices.resize(previous.indexCount);
+                const uint32_t indexCount = MeshSimplifier::simplify(lodIndices.data(), &indexData[previous.firstIndex], previous.indexCount,
+                                                                     &vertexData[previous.vertexOffset].pos.x, primitiveVertexCounts[primitive], sizeof(Vertex) / sizeof(float),
+                                                                     previous.indexCount / 6u * 3u, radius * MESH_LOD_BASE_ERROR * static_cast<float>(1u << (lod - 1u)));
+
+                if (indexCount == 0u || indexCount > previous.indexCount * MESH_LOD_MAX_RATIO)
+                    break;
+
+                // Vertices keep the fetch order of LOD 0, only the triangles are reordered
+                cacheOrder.resize(indexCount);
+                MeshOptimizer::optimizeVertexCache(cacheOrder.data(), lodIndices.data(), indexCount, primitiveVertexCounts[primitive]);
+
+                // A new primitive id keeps the instancing in DrawList from merging it with the other levels
+                Renderable renderable = previous;
+                renderable.firstIndex = static_cast<uint32_t>(indexData.size());
+                renderable.indexCount = indexCount;
+                renderable.primitive = g_uPrimitiveCount++;
+
+                indexData.insert(indexData.end(), cacheOrder.begin(), cacheOrder.end());
+                primitiveLods[primitive].push_back(renderable);
+                previous = renderable;
+            }
+
+            lodCount = std::max(lodCount, static_cast<uint32_t>(primitiveLods[primitive].size()) + 1u);
+        }
+
+        prototype.m_vLodRenderables.resize(lodCount - 1u);
+        for (uint32_t lod = 1u; lod < lodCount; ++lod)
+        {
+            for (uint32_t primitive = 0; primitive < primitiveCount; ++primitive)
+            {
+                const std::vector<Renderable>& lods = primitiveLods[primitive];
+                prototype.m_vLodRenderables[lod - 1u].push_back(lods.empty() ? prototype.m_Renderables[primitive] : lods[std::min<size_t>(lod, lods.size()) - 1u]);
+            }
+        }
+
+        // One write, files are decoded on several threads at once
+        if constexpr (LOADER_DEBUG)
+        {
+            std::string message = "LOD triangles:";
+            for (uint32_t lod = 0; lod < lodCount; ++lod)
+                message += ' ' + std::to_string(prototype.getTriangleCount(lod));
+            std::cout << message + '\n';
+        }
+    }
+
+    DecodedPrototype decodeGLTFNode(const GLTFFile &file, const tinygltf::Node &gltfNode)
+    {
+        const tinygltf::Model &gltfModel = file.m_Model;
+
         // Process Mesh (Group of renderables)
         const tinygltf::Mesh &gltfMesh = gltfModel.meshes[gltfNode.mesh];
 
-        std::shared_ptr<ModelPrototype> prototype = std::make_shared<ModelPrototype>();
+        DecodedPrototype decoded;
+        decoded.m_pPrototype = std::make_shared<ModelPrototype>();
+        ModelPrototype* prototype = decoded.m_pPrototype.get();
 
-        std::vector<Renderable> rednerables;
-
-        std::vector<Vertex> vertexData;
+        std::vector<Vertex>& vertexData = decoded.m_vVertexData;
         uint32_t vertexOffset = 0u;
 
-        std::vector<uint32_t> indexData;
+        std::vector<uint32_t>& indexData = decoded.m_vIndexData;
         uint32_t indexOffset = 0u;
 
+        std::vector<uint32_t> primitiveVertexCounts;
+
+        Aabb prototypeAabb;
+        prototype->m_vFirstMeshlets.push_back(0u);
+        MeshOptimizer::VertexCacheStats cacheBefore;
+        MeshOptimizer::VertexCacheStats cacheAfter;
+
         for (uint32_t i = 0; i < gltfMesh.primitives.size(); ++i)
         {
             const tinygltf::Primitive &gltfPrimitive = gltfMesh.primitives[i];
 
             // Assign vertex/index buffer and
             const tinygltf::Accessor &gltfIndexAccessor = gltfModel.accessors[gltfPrimitive.indices];
-            const tinygltf::BufferView &gltfIndexBufferView = gltfModel.bufferViews[gltfIndexAccessor.bufferView];
-            const void *gltfIndexBuffer = &(gltfModel.buffers[gltfIndexBufferView.buffer].data[gltfIndexBufferView.byteOffset]);
+            const void *gltfIndexBuffer = getAccessorData(file, gltfIndexAccessor);
             const uint32_t indexCount = gltfIndexAccessor.count;
 
             auto iter = gltfPrimitive.attributes.find("POSITION");
             assert(iter != gltfPrimitive.attributes.end());
             const tinygltf::Accessor &gltfPositionAccessor = gltfModel.accessors[iter->second];
             const tinygltf::BufferView &gltfPositionBufferView = gltfModel.bufferViews[gltfPositionAccessor.bufferView];
-            const float *gltfPositionBuffer = reinterpret_cast<const float *>(&(gltfModel.buffers[gltfPositionBufferView.buffer].data[gltfPositionAccessor.byteOffset + gltfPositionBufferView.byteOffset]));
+            const float *gltfPositionBuffer = reinterpret_cast<const float *>(getAccessorData(file, gltfPositionAccessor));
             const int32_t posStride = gltfPositionAccessor.ByteStride(gltfPositionBufferView) / sizeof(float);
+            const uint32_t positionCount = static_cast<uint32_t>(gltfPositionAccessor.count);
+
+            // glTF requires min/max on POSITION accessors, exporters that skip them cost a pass over the positions
+            Aabb primitiveAabb;
+            if (gltfPositionAccessor.minValues.size() == 3 && gltfPositionAccessor.maxValues.size() == 3)
+            {
+                primitiveAabb.m_v3Min = glm::vec3(gltfPositionAccessor.minValues[0], gltfPositionAccessor.minValues[1], gltfPositionAccessor.minValues[2]);
+                primitiveAabb.m_v3Max = glm::vec3(gltfPositionAccessor.maxValues[0], gltfPositionAccessor.maxValues[1], gltfPositionAccessor.maxValues[2]);
+            }
+            else
+            {
+                primitiveAabb = Aabb::fromPositions(gltfPositionBuffer, positionCount, posStride);
+            }
+
+            prototypeAabb.expand(primitiveAabb);
+            prototype->m_vPrimitiveBounds.push_back(Bounds::fromPositions(primitiveAabb, gltfPositionBuffer, positionCount, posStride));
 
             for (uint32_t vertexIndex = 0; vertexIndex < gltfPositionAccessor.count; ++vertexIndex)
             {
-                Vertex vertex;
+                Vertex vertex {};
                 vertex.pos = glm::make_vec3(&(gltfPositionBuffer[vertexIndex * posStride]));
 
                 vertexData.push_back(vertex);
             }
 
+            // Read only when the layout keeps them, primitives without them get zeros
+            auto normals = gltfPrimitive.attributes.find("NORMAL");
+            if (MESH_VERTEX_LAYOUT.hasNormals() && normals != gltfPrimitive.attributes.end())
+                readAttribute(file, gltfModel.accessors[normals->second], 3u, positionCount, &vertexData[vertexOffset].normal.x, sizeof(Vertex) / sizeof(float));
+
+            auto texcoords = gltfPrimitive.attributes.find("TEXCOORD_0");
+            if (MESH_VERTEX_LAYOUT.hasTexcoords() && texcoords != gltfPrimitive.attributes.end())
+                readAttribute(file, gltfModel.accessors[texcoords->second], 2u, positionCount, &vertexData[vertexOffset].uv.x, sizeof(Vertex) / sizeof(float));
+
+            // Index accessors are tightly packed, every width is converted in bulk
+            indexData.resize(indexOffset + indexCount);
+            uint32_t *indexDestination = indexData.data() + indexOffset;
+
             switch (gltfIndexAccessor.componentType)
             {
             case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-            {
-                const uint32_t *buf = static_cast<const uint32_t *>(gltfIndexBuffer);
-                for (size_t index = 0; index < indexCount; index++)
-                {
-                    indexData.push_back(buf[index]);
-                }
+                memcpy(indexDestination, gltfIndexBuffer, indexCount * sizeof(uint32_t));
                 break;
-            }
             case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-            {
-                const uint16_t *buf = static_cast<const uint16_t *>(gltfIndexBuffer);
-                for (size_t index = 0; index < indexCount; index++)
-                {
-                    indexData.push_back(buf[index]);
-                }
+                IndexConversion::widen(indexDestination, static_cast<const uint16_t *>(gltfIndexBuffer), indexCount);
                 break;
-            }
             case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-            {
-                const uint8_t *buf = static_cast<const uint8_t *>(gltfIndexBuffer);
-                for (size_t index = 0; index < indexCount; index++)
-                {
-                    indexData.push_back(buf[index]);
-                }
+                IndexConversion::widen(indexDestination, static_cast<const uint8_t *>(gltfIndexBuffer), indexCount);
                 break;
-            }
             default:
                 std::cerr << "Index component type " << gltfIndexAccessor.componentType << " not supported!" << std::endl;
                 exit(EXIT_FAILURE);
             }
 
-            Renderable renderable { prototype->m_IndexBuffer, prototype->m_VertexBuffer };
+            const uint32_t vertexCount = optimizePrimitive(vertexData, vertexOffset, indexDestination, indexCount, cacheBefore, cacheAfter);
+
+            // Split in the final triangle order, glTF culls back faces unless the material is double-sided
+            const bool doubleSided = gltfPrimitive.material >= 0 && gltfModel.materials[gltfPrimitive.material].doubleSided;
+            const uint32_t meshletCount = MeshletBuilder::build(prototype->m_vMeshlets, indexDestination, indexCount, &vertexData[vertexOffset].pos.x, vertexCount,
+                                                                sizeof(Vertex) / sizeof(float), doubleSided);
+            const uint32_t firstMeshletPrimitive = g_uPrimitiveCount.fetch_add(meshletCount);
+            for (uint32_t m = 0; m < meshletCount; ++m)
+                prototype->m_vMeshlets[prototype->m_vFirstMeshlets.back() + m].m_uPrimitive = firstMeshletPrimitive + m;
+            prototype->m_vFirstMeshlets.push_back(static_cast<uint32_t>(prototype->m_vMeshlets.size()));
+
+            // Geometry handle is assigned once the buffers exist
+            Renderable renderable {};
             renderable.vertexOffset = vertexOffset;
             renderable.firstIndex = indexOffset;
             renderable.indexCount = indexCount;
+            renderable.primitive = g_uPrimitiveCount++;
 
             prototype->m_Renderables.push_back(renderable);
+            primitiveVertexCounts.push_back(vertexCount);
 
-            vertexOffset += gltfPositionAccessor.count;
+            vertexOffset += vertexCount;
             indexOffset += gltfIndexAccessor.count;
         }
 
-        VkBufferCreateInfo vertexBufferCreateInfo {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-            .size = static_cast<VkDeviceSize>(vertexData.size() * sizeof(Vertex)),
-            .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        };
+        if constexpr (LOADER_DEBUG)
+        {
+            char message[128];
+            snprintf(message, sizeof(message), "Vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %zu meshlets\n",
+                     cacheBefore.getAcmr(), cacheAfter.getAcmr(), cacheBefore.getAtvr(), cacheAfter.getAtvr(), prototype->m_vMeshlets.size());
+            std::cout << message;
+        }
 
-        prototype->m_VertexBuffer.create(vertexBufferCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        prototype->m_VertexBuffer.uploadData(vertexBufferCreateInfo.size, vertexData.data());
+        // Radius over every vertex of the mesh, tighter than combining the primitive spheres
+        prototype->m_Bounds = Bounds::fromPositions(prototypeAabb, &vertexData.data()->pos.x, static_cast<uint32_t>(vertexData.size()), sizeof(Vertex) / sizeof(float));
 
-        VkBufferCreateInfo indexBufferCreateInfo {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-            .size = static_cast<VkDeviceSize>(indexData.size() * sizeof(uint32_t)),
-            .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        // "extras": { "occluder": true } on the mesh keeps a CPU copy of its triangles for occlusion culling,
+        // meant for large closed meshes (walls, terrain, buildings) or low-poly stand-ins of them
+        if (gltfMesh.extras.IsObject() && gltfMesh.extras.Has("occluder") && gltfMesh.extras.Get("occluder").IsBool() && gltfMesh.extras.Get("occluder").Get<bool>())
+        {
+            OccluderMesh& occluder = prototype->m_Occluder;
+            occluder.m_vPositions.reserve(vertexData.size());
+            for (const Vertex& vertex : vertexData)
+                occluder.m_vPositions.push_back(vertex.pos);
+
+            // Primitive indices are relative to the primitive's first vertex
+            occluder.m_vIndices.reserve(indexData.size());
+            for (const Renderable& renderable : prototype->m_Renderables)
+            {
+                for (uint32_t index = 0; index < renderable.indexCount; ++index)
+                    occluder.m_vIndices.push_back(indexData[renderable.firstIndex + index] + renderable.vertexOffset);
+            }
+        }
+
+        generateLods(*prototype, vertexData, primitiveVertexCounts, indexData);
+
+        // LODs only ever reference existing vertices, so they fit whenever the source primitives do
+        const uint32_t maxVertexCount = primitiveVertexCounts.empty() ? 0u : *std::max_element(primitiveVertexCounts.begin(), primitiveVertexCounts.end());
+        if (maxVertexCount <= MAX_SHORT_INDEX_VERTEX_COUNT)
+        {
+            decoded.m_vShortIndexData.resize(indexData.size());
+            IndexConversion::narrow(decoded.m_vShortIndexData.data(), indexData.data(), indexData.size());
+            std::vector<uint32_t>().swap(indexData);
+            prototype->m_eIndexType = VK_INDEX_TYPE_UINT16;
+        }
+
+        // Quantized positions are relative to the bounds, which cover every vertex
+        prototype->m_uVertexLayout = MESH_VERTEX_LAYOUT.getKey();
+        prototype->m_m4VertexDecode = MESH_VERTEX_LAYOUT.getPositionDecode(prototype->m_Bounds);
+        decoded.m_vVertexBytes.resize(vertexData.size() * MESH_VERTEX_LAYOUT.getStride());
+        MESH_VERTEX_LAYOUT.encode(decoded.m_vVertexBytes.data(), &vertexData.data()->pos.x, &vertexData.data()->normal.x, &vertexData.data()->uv.x,
+                                  sizeof(Vertex) / sizeof(float), static_cast<uint32_t>(vertexData.size()), prototype->m_Bounds);
+        std::vector<Vertex>().swap(vertexData);
+
+        return decoded;
+    }
+
+    // glTF images the materials of the mesh's primitives sample and whether they hold color, in order of first use.
+    // Base color and emissive are stored in sRGB, metallic-roughness, normals and occlusion are linear data.
+    std::vector<std::pair<int, bool>> getMeshImages(const tinygltf::Model& gltfModel, const tinygltf::Mesh& gltfMesh)
+    {
+        std::vector<std::pair<int, bool>> images;
+
+        const auto add = [&](int texture, bool srgb) {
+            if (texture < 0 || texture >= static_cast<int>(gltfModel.textures.size()))
+                return;
+
+            const int source = gltfModel.textures[texture].source;
+            if (source >= 0 && source < static_cast<int>(gltfModel.images.size()) && std::find(images.begin(), images.end(), std::make_pair(source, srgb)) == images.end())
+                images.emplace_back(source, srgb);
         };
 
-        prototype->m_IndexBuffer.create(indexBufferCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        prototype->m_IndexBuffer.uploadData(indexBufferCreateInfo.size, indexData.data());
+        for (const tinygltf::Primitive& gltfPrimitive : gltfMesh.primitives)
+        {
+            if (gltfPrimitive.material < 0)
+                continue;
+
+            const tinygltf::Material& material = gltfModel.materials[gltfPrimitive.material];
+            add(material.pbrMetallicRoughness.baseColorTexture.index, true);
+            add(material.emissiveTexture.index, true);
+            add(material.pbrMetallicRoughness.metallicRoughnessTexture.index, false);
+            add(material.normalTexture.index, false);
+            add(material.occlusionTexture.index, false);
+        }
 
-        return prototype;
+        return images;
     }
-}
 
-std::vector<Model> processGLTF(const std::string &filepath)
-{
-    // We are starting to process a new model that we have NOT processed before
-    std::vector<Model> models;
+    // Images of one file, every glTF image is decoded at most once however many meshes and materials use it
+    struct ImageDecoder
+    {
+        std::unordered_map<int, TexturePool::Image> m_SourceImages; // no pixels when stb_image could not read it
+        std::map<std::pair<int, bool>, uint32_t> m_FileImages; // (glTF image, sRGB) -> DecodedGLTF::m_vImages
+
+        // Indices into decoded.m_vImages of the mesh's images, the ones that could not be decoded are left out
+        std::vector<uint32_t> decode(DecodedGLTF& decoded, const GLTFFile& file, const tinygltf::Mesh& gltfMesh)
+        {
+            std::vector<uint32_t> images;
+
+            for (const std::pair<int, bool>& meshImage : getMeshImages(file.m_Model, gltfMesh))
+            {
+                auto fileImage = m_FileImages.find(meshImage);
+                if (fileImage == m_FileImages.end())
+                {
+                    auto sourceImage = m_SourceImages.find(meshImage.first);
+                    if (sourceImage == m_SourceImages.end())
+                        sourceImage = m_SourceImages.emplace(meshImage.first, decodeSource(decoded, file, meshImage.first)).first;
+
+                    if (sourceImage->second.m_pPixels == nullptr)
+                        continue;
+
+                    TexturePool::Image image = sourceImage->second;
+                    image.m_eFormat = meshImage.second ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+                    image.m_ContentKey = TexturePool::computeContentKey(image);
+
+                    fileImage = m_FileImages.emplace(meshImage, static_cast<uint32_t>(decoded.m_vImages.size())).first;
+                    decoded.m_vImages.push_back(image);
+                }
+
+                images.push_back(fileImage->second);
+            }
+
+            return images;
+        }
+
+        // Always RGBA8, the only layout TexturePool takes
+        static TexturePool::Image decodeSource(DecodedGLTF& decoded, const GLTFFile& file, int source)
+        {
+            TexturePool::Image image {};
+            const BufferRange& encoded = file.m_vImages[source];
 
-    tinygltf::Model gltfModel;
-    if (!loadModel(gltfModel, filepath.c_str()))
-        return models;
+            int width = 0;
+            int height = 0;
+            int components = 0;
+            unsigned char* pixels = encoded.m_pData == nullptr || encoded.m_uSize > INT_MAX ? nullptr :
+                                    stbi_load_from_memory(encoded.m_pData, static_cast<int>(encoded.m_uSize), &width, &height, &components, 4);
+
+            if (pixels == nullptr)
+            {
+                std::cout << "Failed to decode glTF image " << source << '\n';
+                return image;
+            }
+
+            decoded.m_vPixels.emplace_back(pixels);
+            image.m_pPixels = pixels;
+            image.m_uWidth = static_cast<uint32_t>(width);
+            image.m_uHeight = static_cast<uint32_t>(height);
+            return image;
+        }
+    };
+
+    // Every Vulkan call of loading a prototype. Its geometry goes into the GeometryPool, renderables are moved
+    // from offsets into the prototype's own buffers to offsets into the pool's.
+    void uploadPrototype(const MeshCache::Prototype& upload)
+    {
+        ModelPrototype* prototype = upload.m_pPrototype.get();
+
+        GeometryPool::Allocation& geometry = prototype->m_Geometry;
+        if (!GeometryPool::allocate(upload.m_uVertexBytes, upload.m_uIndexBytes, prototype->m_eIndexType, geometry))
+        {
+            std::cerr << "Geometry pool is full, " << upload.m_uVertexBytes << " vertex and " << upload.m_uIndexBytes << " index bytes requested!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        GeometryPool::upload(geometry, upload.m_pVertices, upload.m_uVertexBytes, upload.m_pIndices, upload.m_uIndexBytes);
+
+        prototype->m_uGeometry = geometry.m_uGeometry;
+        for (uint32_t lod = 0; lod < prototype->getLodCount(); ++lod)
+        {
+            std::vector<Renderable>& renderables = lod == 0u ? prototype->m_Renderables : prototype->m_vLodRenderables[lod - 1u];
+            for (Renderable& renderable : renderables)
+            {
+                renderable.geometry = geometry.m_uGeometry;
+                renderable.vertexOffset += geometry.m_iVertexOffset;
+                renderable.firstIndex += geometry.m_uFirstIndex;
+            }
+        }
+    }
+
+    // Warm start, the cooked file stands in for tinygltf and everything decodeGLTFNode() does
+    bool loadCooked(DecodedGLTF& decoded, const std::string& fileKey, const std::string& cookedPath)
+    {
+        if (!decoded.m_Cache.load(cookedPath.c_str()))
+            return false;
+
+        const uint32_t firstPrimitive = g_uPrimitiveCount.fetch_add(decoded.m_Cache.getPrimitiveCount());
+        std::vector<std::shared_ptr<ModelPrototype>> prototypes;
+
+        for (const MeshCache::Prototype& cooked : decoded.m_Cache.getPrototypes())
+        {
+            std::shared_ptr<ModelPrototype> prototype = g_PrototypeCache.find(fileKey, cooked.m_uMesh);
+            if (prototype == nullptr)
+                prototype = g_PrototypeCache.add(fileKey, cooked.m_uMesh, cooked.m_ContentKey, cooked.m_pPrototype);
+
+            if (prototype == cooked.m_pPrototype)
+            {
+                for (uint32_t lod = 0; lod < prototype->getLodCount(); ++lod)
+                {
+                    std::vector<Renderable>& renderables = lod == 0u ? prototype->m_Renderables : prototype->m_vLodRenderables[lod - 1u];
+                    for (Renderable& renderable : renderables)
+                        renderable.primitive += firstPrimitive;
+                }
+                for (Meshlet& meshlet : prototype->m_vMeshlets)
+                    meshlet.m_uPrimitive += firstPrimitive;
+
+                decoded.m_vUploads.push_back(cooked);
+            }
+
+            prototypes.push_back(std::move(prototype));
+        }
+
+        for (const MeshCache::Instance& instance : decoded.m_Cache.getInstances())
+        {
+            decoded.m_vModels.emplace_back(prototypes[instance.m_uPrototype], instance.m_m4Transform);
+            decoded.m_vModels.back().m_bDynamic = instance.m_bDynamic;
+        }
+
+        decoded.m_vImages = decoded.m_Cache.getImages();
+
+        std::cout << "Loaded cooked mesh: " << cookedPath << std::endl;
+        return true;
+    }
+
+    // Parses the file and builds its models without touching Vulkan, safe to run on any thread.
+    // The models reference their prototypes already, those get their buffers in uploadGLTF().
+    DecodedGLTF decodeGLTF(const std::string &filepath)
+    {
+        DecodedGLTF decoded;
+
+        const std::string fileKey = PrototypeCache::makeFileKey(filepath);
+        const std::string cookedPath = filepath + COOKED_MESH_EXTENSION;
+        if (loadCooked(decoded, fileKey, cookedPath))
+            return decoded;
+
+        GLTFFile file;
+        if (!loadModel(file, filepath.c_str()))
+            return decoded;
+
+        // Mappings are released when file goes out of scope, everything needed was copied by then
+        const tinygltf::Model &gltfModel = file.m_Model;
 
 #ifdef MATERIAL_LOADING
-    loadMaterials(gltfModel);
+        loadMaterials(file.m_Model);
 #endif
 
-    const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene];
-    for (size_t i = 0; i < scene.nodes.size(); ++i)
-    {
-        assert((scene.nodes[i] >= 0) && (scene.nodes[i] < gltfModel.nodes.size()));
+        // Nodes referencing the same mesh share one prototype, so their renderables can be drawn instanced.
+        // Every distinct mesh of the file is cooked from the data decoded here, even when the prototype the
+        // models use came from the PrototypeCache. A mesh the cache knew by (file, mesh) is not decoded at all.
+        std::unordered_map<int, uint32_t> meshPrototypes;
+        std::vector<std::shared_ptr<ModelPrototype>> prototypes;
+        std::vector<MeshCache::Prototype> cookedPrototypes;
+        std::vector<MeshCache::Instance> instances;
+        ImageDecoder images;
+        bool cookable = true;
+
+        const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene];
+        for (size_t i = 0; i < scene.nodes.size(); ++i)
+        {
+            assert((scene.nodes[i] >= 0) && (scene.nodes[i] < gltfModel.nodes.size()));
 
-        const tinygltf::Node &gltfNode = gltfModel.nodes[scene.nodes[i]];
-        std::shared_ptr<ModelPrototype> prototype = processGLTFNode(gltfModel, gltfNode);
+            const tinygltf::Node &gltfNode = gltfModel.nodes[scene.nodes[i]];
 
-        // Extract translation
-        glm::mat4 transform { 1.0f };
+            auto prototype = meshPrototypes.find(gltfNode.mesh);
+            if (prototype == meshPrototypes.end())
+            {
+                prototype = meshPrototypes.emplace(gltfNode.mesh, static_cast<uint32_t>(prototypes.size())).first;
+                const uint32_t mesh = static_cast<uint32_t>(gltfNode.mesh);
+
+                std::shared_ptr<ModelPrototype> shared = g_PrototypeCache.find(fileKey, mesh);
+                if (shared != nullptr)
+                {
+                    cookable = false;
+                    cookedPrototypes.push_back({});
+                }
+                else
+                {
+                    decoded.m_vPrototypes.push_back(decodeGLTFNode(file, gltfNode));
+                    const DecodedPrototype& decodedPrototype = decoded.m_vPrototypes.back();
+
+                    const bool shortIndices = decodedPrototype.m_pPrototype->m_eIndexType == VK_INDEX_TYPE_UINT16;
+                    MeshCache::Prototype view { decodedPrototype.m_pPrototype, decodedPrototype.m_vVertexBytes.data(), decodedPrototype.m_vVertexBytes.size(),
+                                                shortIndices ? static_cast<const void*>(decodedPrototype.m_vShortIndexData.data()) : decodedPrototype.m_vIndexData.data(),
+                                                shortIndices ? decodedPrototype.m_vShortIndexData.size() * sizeof(uint16_t) : decodedPrototype.m_vIndexData.size() * sizeof(uint32_t),
+                                                mesh, 0u };
+                    view.m_vImages = images.decode(decoded, file, gltfModel.meshes[mesh]);
+                    view.m_ContentKey = PrototypeCache::computeContentKey(view, decoded.m_vImages);
+
+                    shared = g_PrototypeCache.add(fileKey, mesh, view.m_ContentKey, view.m_pPrototype);
+                    if (shared == view.m_pPrototype)
+                        decoded.m_vUploads.push_back(view);
+
+                    cookedPrototypes.push_back(view);
+                }
+
+                prototypes.push_back(std::move(shared));
+            }
 
-        if (!gltfNode.translation.empty())
+            // Extract translation
+            glm::mat4 transform { 1.0f };
+
+            if (!gltfNode.translation.empty())
+            {
+                const glm::vec3 translation = glm::make_vec3(gltfNode.translation.data());
+                transform = glm::translate(transform, translation);
+            }
+
+            if (!gltfNode.rotation.empty())
+            {
+                const glm::quat quaternion = glm::make_quat(gltfNode.rotation.data());
+                const glm::mat4 rotationMatrix = glm::toMat4(quaternion);
+                transform = (rotationMatrix * transform);
+            }
+
+            if (!gltfNode.scale.empty())
+            {
+                const glm::vec3 scale = glm::make_vec3(gltfNode.scale.data());
+                transform = glm::scale(transform, scale);
+            }
+
+            decoded.m_vModels.emplace_back(prototypes[prototype->second], transform);
+
+            // Level geometry unless the node says otherwise with "extras": { "dynamic": true }
+            if (gltfNode.extras.IsObject() && gltfNode.extras.Has("dynamic") && gltfNode.extras.Get("dynamic").IsBool())
+                decoded.m_vModels.back().m_bDynamic = gltfNode.extras.Get("dynamic").Get<bool>();
+
+            instances.push_back({ prototype->second, transform, decoded.m_vModels.back().m_bDynamic });
+        }
+
+        // First run, cook for the next one. Failing to write only costs the next start another decode.
+        // Files that reused a mesh by (file, mesh) were loaded before, that load cooked them.
+        uint64_t sourceKey = 0u;
+        if (cookable &&
+            (!MeshCache::computeSourceKey(file.m_vDependencies, sourceKey) ||
+             !MeshCache::save(cookedPath.c_str(), sourceKey, file.m_vDependencies, cookedPrototypes, instances, decoded.m_vImages)))
         {
-            const glm::vec3 translation = glm::make_vec3(gltfNode.translation.data());
-            transform = glm::translate(transform, translation);
+            std::cout << "Could not write " << cookedPath << std::endl;
         }
 
-        if (!gltfNode.rotation.empty())
+        return decoded;
+    }
+
+    std::vector<Model> uploadGLTF(DecodedGLTF& decoded)
+    {
+        for (const MeshCache::Prototype& upload : decoded.m_vUploads)
+            uploadPrototype(upload);
+
+        // Images of every prototype that is uploaded, in one TexturePool batch
+        std::vector<TexturePool::Image> images;
+        std::vector<uint32_t> uploadImages(decoded.m_vImages.size(), UINT32_MAX);
+        for (const MeshCache::Prototype& upload : decoded.m_vUploads)
         {
-            const glm::quat quaternion = glm::make_quat(gltfNode.rotation.data());
-            const glm::mat4 rotationMatrix = glm::toMat4(quaternion);
-            transform = (rotationMatrix * transform);
+            for (uint32_t image : upload.m_vImages)
+            {
+                if (uploadImages[image] == UINT32_MAX)
+                {
+                    uploadImages[image] = static_cast<uint32_t>(images.size());
+                    images.push_back(decoded.m_vImages[image]);
+                }
+            }
         }
 
-        if (!gltfNode.scale.empty())
+        const std::vector<std::shared_ptr<Texture>> textures = TexturePool::upload(images);
+        for (const MeshCache::Prototype& upload : decoded.m_vUploads)
         {
-            const glm::vec3 scale = glm::make_vec3(gltfNode.scale.data());
-            transform = glm::scale(transform, scale);
+            for (uint32_t image : upload.m_vImages)
+                upload.m_pPrototype->m_vTextures.push_back(textures[uploadImages[image]]);
         }
 
-        models.emplace_back(prototype, transform);
+        return std::move(decoded.m_vModels);
     }
+}
+
+std::vector<Model> processGLTF(const std::string &filepath)
+{
+    DecodedGLTF decoded = decodeGLTF(filepath);
+    return uploadGLTF(decoded);
+}
+
+GLTFBatchLoader::GLTFBatchLoader(ThreadPool& threadPool)
+    : m_ThreadPool(threadPool)
+    , m_uPendingFiles(0u)
+    , m_bStopping(false)
+    , m_UploadThread(&GLTFBatchLoader::uploadLoop, this)
+{
+}
+
+GLTFBatchLoader::~GLTFBatchLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStopping = true;
+    }
+
+    m_UploadAvailable.notify_one();
+    m_UploadThread.join();
+}
+
+std::vector<std::future<std::vector<Model>>> GLTFBatchLoader::load(const std::vector<std::string>& filepaths)
+{
+    std::vector<std::future<std::vector<Model>>> futures;
+    futures.reserve(filepaths.size());
+
+    for (const std::string& filepath : filepaths)
+    {
+        // Shared so the upload, which is a std::function, can own it
+        std::shared_ptr<std::promise<std::vector<Model>>> promise = std::make_shared<std::promise<std::vector<Model>>>();
+        futures.push_back(promise->get_future());
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_uPendingFiles;
+        }
+
+        // Every file either posts an upload or is marked done here, otherwise the destructor would wait forever
+        m_ThreadPool.submit([this, filepath, promise]() {
+            try
+            {
+                std::shared_ptr<DecodedGLTF> decoded = std::make_shared<DecodedGLTF>(decodeGLTF(filepath));
+                postUpload([decoded, promise]() {
+                    try
+                    {
+                        promise->set_value(uploadGLTF(*decoded));
+                    }
+                    catch (...)
+                    {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                --m_uPendingFiles;
+                m_UploadAvailable.notify_one();
+            }
+        });
+    }
+
+    return futures;
+}
+
+void GLTFBatchLoader::postUpload(std::function<void()> upload)
+{
+    // Notified under the lock, once the upload ran the destructor may return and take the condition with it
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Uploads.push_back(std::move(upload));
+    m_UploadAvailable.notify_one();
+}
 
-    return models;
-}
\ No newline at end of file
+void GLTFBatchLoader::uploadLoop()
+{
+    while (true)
+    {
+        std::function<void()> upload;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+
+            // Files still decoding post their upload later, stopping waits for them
+            m_UploadAvailable.wait(lock, [this] { return !m_Uploads.empty() || (m_bStopping && m_uPendingFiles == 0u); });
+            if (m_Uploads.empty())
+                return;
+
+            upload = std::move(m_Uploads.front());
+            m_Uploads.pop_front();
+        }
+
+        upload();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        --m_uPendingFiles;
+    }
+}
@@ -1,11 +1,59 @@
 #ifndef MICA_LOADER_HPP
 #define MICA_LOADER_HPP
 
-#include <vector>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "Model.hpp"
+#include "ThreadPool.hpp"
 
 std::vector<Model> processGLTF(const std::string &filepath);
 
-#endif // MICA_LOADER_HPP
\ No newline at end of file
+/**
+ * Loads a batch of glTF files concurrently. Parsing, decoding and LOD generation of every file run as one
+ * ThreadPool task each, the Vulkan side (GeometryPool allocation, texture and staging uploads) is
+ * funneled through a single upload thread, since the staging command pool and the queue it submits to must
+ * not be used from two threads at once. Files upload in the order they finish decoding.
+ *
+ * The upload thread shares the graphics queue with rendering, so no frame may be submitted until every
+ * future of a batch is ready. Files share prototypes through the PrototypeCache, a model's buffers may be
+ * uploaded with another file of the batch.
+ */
+class GLTFBatchLoader
+{
+public:
+    explicit GLTFBatchLoader(ThreadPool& threadPool);
+    // Waits for every file that is still loading
+    ~GLTFBatchLoader();
+
+    GLTFBatchLoader(const GLTFBatchLoader&) = delete;
+    GLTFBatchLoader& operator=(const GLTFBatchLoader&) = delete;
+
+    // One future per path in the same order, ready once the file's buffers are uploaded.
+    // A file that fails to load yields no models, like processGLTF(). An exception thrown while decoding or
+    // uploading a file (std::bad_alloc) is rethrown by its future, the other files are not affected.
+    std::vector<std::future<std::vector<Model>>> load(const std::vector<std::string>& filepaths);
+
+private:
+    void postUpload(std::function<void()> upload);
+    void uploadLoop();
+
+    ThreadPool& m_ThreadPool;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_UploadAvailable;
+    std::deque<std::function<void()>> m_Uploads; // guarded by m_Mutex
+    uint32_t m_uPendingFiles;                    // guarded by m_Mutex, loading files that did not upload yet
+    bool m_bStopping;                            // guarded by m_Mutex
+
+    // Last, starts running once everything above is initialized
+    std::thread m_UploadThread;
+};
+
+#endif // MICA_LOADER_HPP
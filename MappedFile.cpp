@@ -0,0 +1,79 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile()
+    : m_pData{nullptr}, m_uSize{0u}
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& rhs)
+    : m_pData{rhs.m_pData}, m_uSize{rhs.m_uSize}
+{
+    rhs.m_pData = nullptr;
+    rhs.m_uSize = 0u;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs)
+{
+    if (this != &rhs)
+    {
+        close();
+
+        m_pData = rhs.m_pData;
+        m_uSize = rhs.m_uSize;
+
+        rhs.m_pData = nullptr;
+        rhs.m_uSize = 0u;
+    }
+
+    return *this;
+}
+
+bool MappedFile::open(const char* filename)
+{
+    close();
+
+    const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file referenced on its own
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    // Accessors are mostly read front to back, let the kernel read ahead
+    madvise(data, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+    m_pData = static_cast<const unsigned char*>(data);
+    m_uSize = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_pData != nullptr)
+        munmap(const_cast<unsigned char*>(m_pData), m_uSize);
+
+    m_pData = nullptr;
+    m_uSize = 0u;
+}
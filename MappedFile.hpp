@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+
+/**
+ * Read-only memory mapping of a whole file. The pages are file-backed, so the kernel reads them on first
+ * touch and can drop them again under memory pressure instead of the loader holding a heap copy of every
+ * asset. The mapping is private and never written.
+ */
+class MappedFile
+{
+private:
+    const unsigned char* m_pData;
+    size_t m_uSize;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(MappedFile&& rhs);
+    MappedFile& operator=(MappedFile&& rhs);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False when the file is missing, empty or cannot be mapped. Unmaps whatever was mapped before.
+    bool open(const char* filename);
+    void close();
+
+    bool isOpen() const { return m_pData != nullptr; }
+
+    const unsigned char* getData() const { return m_pData; }
+    size_t getSize() const { return m_uSize; }
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,521 @@
+#include "MeshCache.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#include "Renderer/VertexLayout.hpp"
+
+namespace
+{
+    constexpr uint32_t FILE_MAGIC = 0x3148534Du; // "MSH1"
+    constexpr uint32_t FILE_VERSION = 10u;
+
+    struct FileHeader
+    {
+        uint32_t m_uMagic;
+        uint32_t m_uVersion;
+        uint64_t m_uSourceKey;
+        uint64_t m_uFileSize;
+        uint32_t m_uDependencyCount;
+        uint32_t m_uPrototypeCount;
+        uint32_t m_uInstanceCount;
+        uint32_t m_uPrimitiveCount;
+        uint32_t m_uImageCount;
+        uint32_t m_uReserved;
+    };
+
+    struct CookedPrototype
+    {
+        glm::mat4 m_m4VertexDecode;
+        Bounds m_Bounds;
+        uint32_t m_uRenderableCount; // per LOD
+        uint32_t m_uLodCount;
+        uint32_t m_uOccluderPositionCount;
+        uint32_t m_uOccluderIndexCount;
+        uint32_t m_uMeshletCount;
+        uint32_t m_uImageCount;
+        uint32_t m_uIndexType; // VkIndexType of the index blob
+        uint32_t m_uMesh;
+        uint32_t m_uVertexLayout;
+        Hash::Key128 m_ContentKey;
+
+        // Primitive bounds, renderables of every LOD, occluder positions and indices, first meshlet of every
+        // LOD 0 renderable plus the end, meshlets, image indices
+        uint64_t m_uTableOffset;
+
+        uint64_t m_uVertexOffset;
+        uint64_t m_uVertexBytes;
+        uint64_t m_uIndexOffset;
+        uint64_t m_uIndexBytes;
+    };
+
+    struct CookedInstance
+    {
+        glm::mat4 m_m4Transform;
+        uint32_t m_uPrototype;
+        uint32_t m_uDynamic;
+    };
+
+    struct CookedImage
+    {
+        uint32_t m_uWidth;
+        uint32_t m_uHeight;
+        uint32_t m_uFormat; // VkFormat
+        uint32_t m_uReserved;
+        Hash::Key128 m_ContentKey;
+        uint64_t m_uPixelOffset; // width * height RGBA8 texels
+    };
+
+    constexpr uint64_t TEXEL_SIZE = 4u;
+
+    struct CookedRenderable
+    {
+        uint32_t m_uPrimitive;
+        uint32_t m_uIndexCount;
+        uint32_t m_uFirstIndex;
+        int32_t m_iVertexOffset;
+    };
+
+    constexpr uint64_t TABLE_ALIGNMENT = 8u;
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1u) / alignment * alignment;
+    }
+
+    // Whether every vertex the indices fetch, offset by vertexOffset, lies in [0, vertexCount)
+    template <typename Index>
+    bool isVertexRangeValid(const Index* indices, uint32_t indexCount, int32_t vertexOffset, uint64_t vertexCount)
+    {
+        if (indexCount == 0u)
+            return true;
+
+        Index minIndex = indices[0];
+        Index maxIndex = indices[0];
+        for (uint32_t i = 1; i < indexCount; ++i)
+        {
+            minIndex = std::min(minIndex, indices[i]);
+            maxIndex = std::max(maxIndex, indices[i]);
+        }
+
+        return static_cast<int64_t>(minIndex) + vertexOffset >= 0 && static_cast<int64_t>(maxIndex) + vertexOffset < static_cast<int64_t>(vertexCount);
+    }
+
+    bool getFileSize(const std::string& path, uint64_t& size)
+    {
+        struct stat fileStat;
+        if (stat(path.c_str(), &fileStat) != 0)
+            return false;
+
+        size = static_cast<uint64_t>(fileStat.st_size);
+        return true;
+    }
+
+    class MetadataWriter
+    {
+    public:
+        std::vector<unsigned char> m_vData;
+
+        template <typename T>
+        void append(const T* values, size_t count)
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+            m_vData.insert(m_vData.end(), bytes, bytes + count * sizeof(T));
+        }
+
+        template <typename T>
+        void patch(uint64_t offset, const T& value)
+        {
+            memcpy(m_vData.data() + offset, &value, sizeof(T));
+        }
+
+        void align(uint64_t alignment)
+        {
+            m_vData.resize(alignUp(m_vData.size(), alignment), 0u);
+        }
+
+        uint64_t size() const { return m_vData.size(); }
+    };
+
+    // Bounds and alignment checked views into the mapping
+    class MappingReader
+    {
+    public:
+        const unsigned char* m_pData;
+        uint64_t m_uSize;
+
+        template <typename T>
+        const T* get(uint64_t offset, uint64_t count) const
+        {
+            if (offset % alignof(T) != 0u || offset > m_uSize || count > (m_uSize - offset) / sizeof(T))
+                return nullptr;
+            return reinterpret_cast<const T*>(m_pData + offset);
+        }
+    };
+}
+
+bool MeshCache::computeSourceKey(const std::vector<std::string>& dependencies, uint64_t& key)
+{
+    key = Hash::SEED;
+
+    const uint64_t count = dependencies.size();
+    key = Hash::value(key, count);
+
+    for (const std::string& dependency : dependencies)
+    {
+        MappedFile file;
+        if (!file.open(dependency.c_str()))
+            return false;
+
+        const uint64_t size = file.getSize();
+        key = Hash::value(key, size);
+        key = Hash::bytes(key, file.getData(), file.getSize());
+    }
+
+    return true;
+}
+
+bool MeshCache::save(const char* filename, uint64_t sourceKey, const std::vector<std::string>& dependencies,
+                     const std::vector<Prototype>& prototypes, const std::vector<Instance>& instances, const std::vector<TexturePool::Image>& images)
+{
+    MetadataWriter metadata;
+
+    FileHeader header {};
+    header.m_uMagic = FILE_MAGIC;
+    header.m_uVersion = FILE_VERSION;
+    header.m_uSourceKey = sourceKey;
+    header.m_uDependencyCount = static_cast<uint32_t>(dependencies.size());
+    header.m_uPrototypeCount = static_cast<uint32_t>(prototypes.size());
+    header.m_uInstanceCount = static_cast<uint32_t>(instances.size());
+    header.m_uImageCount = static_cast<uint32_t>(images.size());
+    metadata.append(&header, 1u);
+
+    // Size, path length and path of every dependency, each entry 8 byte aligned
+    for (const std::string& dependency : dependencies)
+    {
+        uint64_t size;
+        if (!getFileSize(dependency, size))
+            return false;
+
+        const uint32_t length = static_cast<uint32_t>(dependency.size());
+        metadata.append(&size, 1u);
+        metadata.append(&length, 1u);
+        metadata.append(dependency.data(), length);
+        metadata.align(sizeof(uint64_t));
+    }
+    metadata.align(TABLE_ALIGNMENT);
+
+    const uint64_t prototypeTableOffset = metadata.size();
+    std::vector<CookedPrototype> cookedPrototypes(prototypes.size());
+    metadata.append(cookedPrototypes.data(), cookedPrototypes.size());
+
+    for (const Instance& instance : instances)
+    {
+        const CookedInstance cookedInstance { instance.m_m4Transform, instance.m_uPrototype, instance.m_bDynamic ? 1u : 0u };
+        metadata.append(&cookedInstance, 1u);
+    }
+
+    const uint64_t imageTableOffset = metadata.size();
+    std::vector<CookedImage> cookedImages(images.size());
+    metadata.append(cookedImages.data(), cookedImages.size());
+
+    // Levels a primitive ran out of repeat its coarsest renderable, those keep sharing one id
+    std::unordered_map<uint32_t, uint32_t> localPrimitives;
+
+    for (size_t p = 0; p < prototypes.size(); ++p)
+    {
+        const ModelPrototype& prototype = *prototypes[p].m_pPrototype;
+        CookedPrototype& cooked = cookedPrototypes[p];
+
+        metadata.align(TABLE_ALIGNMENT);
+        cooked.m_m4VertexDecode = prototype.m_m4VertexDecode;
+        cooked.m_Bounds = prototype.m_Bounds;
+        cooked.m_uRenderableCount = static_cast<uint32_t>(prototype.m_Renderables.size());
+        cooked.m_uLodCount = prototype.getLodCount();
+        cooked.m_uOccluderPositionCount = static_cast<uint32_t>(prototype.m_Occluder.m_vPositions.size());
+        cooked.m_uOccluderIndexCount = static_cast<uint32_t>(prototype.m_Occluder.m_vIndices.size());
+        cooked.m_uMeshletCount = static_cast<uint32_t>(prototype.m_vMeshlets.size());
+        cooked.m_uImageCount = static_cast<uint32_t>(prototypes[p].m_vImages.size());
+        cooked.m_uIndexType = prototype.m_eIndexType;
+        cooked.m_uMesh = prototypes[p].m_uMesh;
+        cooked.m_uVertexLayout = prototype.m_uVertexLayout;
+        cooked.m_ContentKey = prototypes[p].m_ContentKey;
+        cooked.m_uTableOffset = metadata.size();
+        cooked.m_uVertexBytes = prototypes[p].m_uVertexBytes;
+        cooked.m_uIndexBytes = prototypes[p].m_uIndexBytes;
+
+        metadata.append(prototype.m_vPrimitiveBounds.data(), prototype.m_vPrimitiveBounds.size());
+
+        for (uint32_t lod = 0; lod < prototype.getLodCount(); ++lod)
+        {
+            for (const Renderable& renderable : prototype.getRenderables(lod))
+            {
+                const uint32_t primitive = localPrimitives.emplace(renderable.primitive, static_cast<uint32_t>(localPrimitives.size())).first->second;
+                const CookedRenderable cookedRenderable { primitive, renderable.indexCount, renderable.firstIndex, renderable.vertexOffset };
+                metadata.append(&cookedRenderable, 1u);
+            }
+        }
+
+        metadata.append(prototype.m_Occluder.m_vPositions.data(), prototype.m_Occluder.m_vPositions.size());
+        metadata.append(prototype.m_Occluder.m_vIndices.data(), prototype.m_Occluder.m_vIndices.size());
+
+        metadata.append(prototype.m_vFirstMeshlets.data(), prototype.m_vFirstMeshlets.size());
+        for (Meshlet meshlet : prototype.m_vMeshlets)
+        {
+            meshlet.m_uPrimitive = localPrimitives.emplace(meshlet.m_uPrimitive, static_cast<uint32_t>(localPrimitives.size())).first->second;
+            metadata.append(&meshlet, 1u);
+        }
+
+        metadata.append(prototypes[p].m_vImages.data(), prototypes[p].m_vImages.size());
+    }
+
+    // Blobs go after the metadata, their offsets are known once its size is
+    metadata.align(BLOB_ALIGNMENT);
+
+    uint64_t blobOffset = metadata.size();
+    for (CookedPrototype& cooked : cookedPrototypes)
+    {
+        cooked.m_uVertexOffset = blobOffset;
+        blobOffset = alignUp(blobOffset + cooked.m_uVertexBytes, BLOB_ALIGNMENT);
+        cooked.m_uIndexOffset = blobOffset;
+        blobOffset = alignUp(blobOffset + cooked.m_uIndexBytes, BLOB_ALIGNMENT);
+    }
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        cookedImages[i] = { images[i].m_uWidth, images[i].m_uHeight, static_cast<uint32_t>(images[i].m_eFormat), 0u, images[i].m_ContentKey, blobOffset };
+        blobOffset = alignUp(blobOffset + images[i].m_uWidth * static_cast<uint64_t>(images[i].m_uHeight) * TEXEL_SIZE, BLOB_ALIGNMENT);
+    }
+
+    header.m_uFileSize = blobOffset;
+    header.m_uPrimitiveCount = static_cast<uint32_t>(localPrimitives.size());
+    metadata.patch(0u, header);
+    for (size_t p = 0; p < cookedPrototypes.size(); ++p)
+        metadata.patch(prototypeTableOffset + p * sizeof(CookedPrototype), cookedPrototypes[p]);
+    for (size_t i = 0; i < cookedImages.size(); ++i)
+        metadata.patch(imageTableOffset + i * sizeof(CookedImage), cookedImages[i]);
+
+    // Written next to the target and renamed, a concurrent load never maps a half-written file
+    const std::string temporary = std::string(filename) + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    static const unsigned char padding[BLOB_ALIGNMENT] = {};
+
+    bool written = fwrite(metadata.m_vData.data(), 1u, metadata.size(), f) == metadata.size();
+    for (size_t p = 0; written && p < prototypes.size(); ++p)
+    {
+        const uint64_t vertexPadding = cookedPrototypes[p].m_uIndexOffset - cookedPrototypes[p].m_uVertexOffset - cookedPrototypes[p].m_uVertexBytes;
+        const uint64_t indexPadding = alignUp(cookedPrototypes[p].m_uIndexBytes, BLOB_ALIGNMENT) - cookedPrototypes[p].m_uIndexBytes;
+
+        written = fwrite(prototypes[p].m_pVertices, 1u, prototypes[p].m_uVertexBytes, f) == prototypes[p].m_uVertexBytes;
+        written = written && fwrite(padding, 1u, vertexPadding, f) == vertexPadding;
+        written = written && fwrite(prototypes[p].m_pIndices, 1u, prototypes[p].m_uIndexBytes, f) == prototypes[p].m_uIndexBytes;
+        written = written && fwrite(padding, 1u, indexPadding, f) == indexPadding;
+    }
+    for (size_t i = 0; written && i < images.size(); ++i)
+    {
+        const uint64_t pixelBytes = images[i].m_uWidth * static_cast<uint64_t>(images[i].m_uHeight) * TEXEL_SIZE;
+        const uint64_t pixelPadding = alignUp(pixelBytes, BLOB_ALIGNMENT) - pixelBytes;
+
+        written = fwrite(images[i].m_pPixels, 1u, pixelBytes, f) == pixelBytes;
+        written = written && fwrite(padding, 1u, pixelPadding, f) == pixelPadding;
+    }
+
+    written = (fclose(f) == 0) && written;
+    written = written && rename(temporary.c_str(), filename) == 0;
+    if (!written)
+        remove(temporary.c_str());
+
+    return written;
+}
+
+bool MeshCache::load(const char* filename)
+{
+    clear();
+
+    if (!m_File.open(filename))
+        return false;
+
+    const MappingReader reader { m_File.getData(), m_File.getSize() };
+
+    const FileHeader* header = reader.get<FileHeader>(0u, 1u);
+    bool valid = header != nullptr && header->m_uMagic == FILE_MAGIC && header->m_uVersion == FILE_VERSION && header->m_uFileSize == reader.m_uSize;
+
+    uint64_t offset = sizeof(FileHeader);
+    std::vector<std::string> dependencies;
+
+    for (uint32_t i = 0; valid && i < header->m_uDependencyCount; ++i)
+    {
+        const uint64_t* size = reader.get<uint64_t>(offset, 1u);
+        const uint32_t* length = reader.get<uint32_t>(offset + sizeof(uint64_t), 1u);
+        const char* path = size != nullptr && length != nullptr ? reader.get<char>(offset + sizeof(uint64_t) + sizeof(uint32_t), *length) : nullptr;
+
+        valid = path != nullptr;
+        if (valid)
+        {
+            dependencies.emplace_back(path, *length);
+            offset = alignUp(offset + sizeof(uint64_t) + sizeof(uint32_t) + *length, sizeof(uint64_t));
+
+            // A changed size rejects the file before anything is read
+            uint64_t currentSize;
+            valid = getFileSize(dependencies.back(), currentSize) && currentSize == *size;
+        }
+    }
+
+    // Reads every source file once, still far cheaper than parsing it
+    uint64_t sourceKey = 0u;
+    valid = valid && computeSourceKey(dependencies, sourceKey) && sourceKey == header->m_uSourceKey;
+
+    offset = alignUp(offset, TABLE_ALIGNMENT);
+    const CookedPrototype* cookedPrototypes = valid ? reader.get<CookedPrototype>(offset, header->m_uPrototypeCount) : nullptr;
+    offset += valid ? header->m_uPrototypeCount * sizeof(CookedPrototype) : 0u;
+    const CookedInstance* cookedInstances = valid ? reader.get<CookedInstance>(offset, header->m_uInstanceCount) : nullptr;
+    offset += valid ? header->m_uInstanceCount * sizeof(CookedInstance) : 0u;
+    const CookedImage* cookedImages = valid ? reader.get<CookedImage>(offset, header->m_uImageCount) : nullptr;
+    valid = valid && cookedPrototypes != nullptr && cookedInstances != nullptr && cookedImages != nullptr;
+
+    // Only the formats TexturePool creates, with every texel inside the file
+    for (uint32_t i = 0; valid && i < header->m_uImageCount; ++i)
+    {
+        const CookedImage& cooked = cookedImages[i];
+        const unsigned char* pixels = reader.get<unsigned char>(cooked.m_uPixelOffset, cooked.m_uWidth * static_cast<uint64_t>(cooked.m_uHeight) * TEXEL_SIZE);
+        const VkFormat format = static_cast<VkFormat>(cooked.m_uFormat);
+
+        valid = pixels != nullptr && cooked.m_uWidth > 0u && cooked.m_uHeight > 0u && cooked.m_uPixelOffset % BLOB_ALIGNMENT == 0u &&
+                (format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB);
+        if (valid)
+            m_vImages.push_back({ pixels, cooked.m_uWidth, cooked.m_uHeight, format, cooked.m_ContentKey });
+    }
+
+    for (uint32_t p = 0; valid && p < header->m_uPrototypeCount; ++p)
+    {
+        const CookedPrototype& cooked = cookedPrototypes[p];
+        const uint64_t renderableCount = static_cast<uint64_t>(cooked.m_uRenderableCount) * cooked.m_uLodCount;
+
+        uint64_t tableOffset = cooked.m_uTableOffset;
+        const Bounds* primitiveBounds = reader.get<Bounds>(tableOffset, cooked.m_uRenderableCount);
+        tableOffset += cooked.m_uRenderableCount * sizeof(Bounds);
+        const CookedRenderable* renderables = reader.get<CookedRenderable>(tableOffset, renderableCount);
+        tableOffset += renderableCount * sizeof(CookedRenderable);
+        const glm::vec3* occluderPositions = reader.get<glm::vec3>(tableOffset, cooked.m_uOccluderPositionCount);
+        tableOffset += cooked.m_uOccluderPositionCount * sizeof(glm::vec3);
+        const uint32_t* occluderIndices = reader.get<uint32_t>(tableOffset, cooked.m_uOccluderIndexCount);
+        tableOffset += cooked.m_uOccluderIndexCount * sizeof(uint32_t);
+        const uint32_t* firstMeshlets = reader.get<uint32_t>(tableOffset, static_cast<uint64_t>(cooked.m_uRenderableCount) + 1u);
+        tableOffset += (static_cast<uint64_t>(cooked.m_uRenderableCount) + 1u) * sizeof(uint32_t);
+        const Meshlet* meshlets = reader.get<Meshlet>(tableOffset, cooked.m_uMeshletCount);
+        tableOffset += cooked.m_uMeshletCount * sizeof(Meshlet);
+        const uint32_t* images = reader.get<uint32_t>(tableOffset, cooked.m_uImageCount);
+
+        const unsigned char* vertices = reader.get<unsigned char>(cooked.m_uVertexOffset, cooked.m_uVertexBytes);
+        const bool shortIndices = cooked.m_uIndexType == VK_INDEX_TYPE_UINT16;
+        const uint64_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+        const void* indices = shortIndices ? static_cast<const void*>(reader.get<uint16_t>(cooked.m_uIndexOffset, cooked.m_uIndexBytes / indexSize))
+                                           : reader.get<uint32_t>(cooked.m_uIndexOffset, cooked.m_uIndexBytes / indexSize);
+
+        valid = primitiveBounds != nullptr && renderables != nullptr && occluderPositions != nullptr && occluderIndices != nullptr &&
+                firstMeshlets != nullptr && meshlets != nullptr && images != nullptr &&
+                vertices != nullptr && indices != nullptr && cooked.m_uLodCount > 0u &&
+                (shortIndices || cooked.m_uIndexType == VK_INDEX_TYPE_UINT32) &&
+                cooked.m_uVertexLayout == MESH_VERTEX_LAYOUT.getKey() &&
+                cooked.m_uVertexOffset % BLOB_ALIGNMENT == 0u && cooked.m_uIndexOffset % BLOB_ALIGNMENT == 0u;
+
+        // Draws and the occlusion rasterizer trust these ranges, down to the vertices the indices fetch
+        const uint64_t indexCount = cooked.m_uIndexBytes / indexSize;
+        const uint64_t vertexCount = cooked.m_uVertexBytes / MESH_VERTEX_LAYOUT.getStride();
+        for (uint64_t r = 0; valid && r < renderableCount; ++r)
+        {
+            const CookedRenderable& renderable = renderables[r];
+            valid = renderable.m_uPrimitive < header->m_uPrimitiveCount &&
+                    static_cast<uint64_t>(renderable.m_uFirstIndex) + renderable.m_uIndexCount <= indexCount &&
+                    (shortIndices ? isVertexRangeValid(static_cast<const uint16_t*>(indices) + renderable.m_uFirstIndex, renderable.m_uIndexCount,
+                                                       renderable.m_iVertexOffset, vertexCount)
+                                  : isVertexRangeValid(static_cast<const uint32_t*>(indices) + renderable.m_uFirstIndex, renderable.m_uIndexCount,
+                                                       renderable.m_iVertexOffset, vertexCount));
+        }
+        for (uint32_t i = 0; valid && i < cooked.m_uOccluderIndexCount; ++i)
+            valid = occluderIndices[i] < cooked.m_uOccluderPositionCount;
+
+        // Meshlet ranges are relative to their LOD 0 renderable and must stay inside it
+        valid = valid && firstMeshlets[0] == 0u && firstMeshlets[cooked.m_uRenderableCount] == cooked.m_uMeshletCount;
+        for (uint32_t r = 0; valid && r < cooked.m_uRenderableCount; ++r)
+        {
+            valid = firstMeshlets[r] <= firstMeshlets[r + 1u];
+            for (uint32_t m = firstMeshlets[r]; valid && m < firstMeshlets[r + 1u]; ++m)
+            {
+                valid = meshlets[m].m_uPrimitive < header->m_uPrimitiveCount &&
+                        static_cast<uint64_t>(meshlets[m].m_uFirstIndex) + meshlets[m].m_uIndexCount <= renderables[r].m_uIndexCount;
+            }
+        }
+
+        for (uint32_t i = 0; valid && i < cooked.m_uImageCount; ++i)
+            valid = images[i] < header->m_uImageCount;
+
+        if (!valid)
+            break;
+
+        std::shared_ptr<ModelPrototype> prototype = std::make_shared<ModelPrototype>();
+        prototype->m_Bounds = cooked.m_Bounds;
+        prototype->m_uVertexLayout = cooked.m_uVertexLayout;
+        prototype->m_m4VertexDecode = cooked.m_m4VertexDecode;
+        prototype->m_eIndexType = static_cast<VkIndexType>(cooked.m_uIndexType);
+        prototype->m_vPrimitiveBounds.assign(primitiveBounds, primitiveBounds + cooked.m_uRenderableCount);
+        prototype->m_Occluder.m_vPositions.assign(occluderPositions, occluderPositions + cooked.m_uOccluderPositionCount);
+        prototype->m_Occluder.m_vIndices.assign(occluderIndices, occluderIndices + cooked.m_uOccluderIndexCount);
+        prototype->m_vFirstMeshlets.assign(firstMeshlets, firstMeshlets + cooked.m_uRenderableCount + 1u);
+        prototype->m_vMeshlets.assign(meshlets, meshlets + cooked.m_uMeshletCount);
+        prototype->m_vLodRenderables.resize(cooked.m_uLodCount - 1u);
+
+        for (uint32_t lod = 0; lod < cooked.m_uLodCount; ++lod)
+        {
+            std::vector<Renderable>& lodRenderables = lod == 0u ? prototype->m_Renderables : prototype->m_vLodRenderables[lod - 1u];
+            for (uint32_t r = 0; r < cooked.m_uRenderableCount; ++r)
+            {
+                const CookedRenderable& cookedRenderable = renderables[lod * cooked.m_uRenderableCount + r];
+
+                Renderable renderable {};
+                renderable.primitive = cookedRenderable.m_uPrimitive;
+                renderable.indexCount = cookedRenderable.m_uIndexCount;
+                renderable.firstIndex = cookedRenderable.m_uFirstIndex;
+                renderable.vertexOffset = cookedRenderable.m_iVertexOffset;
+                lodRenderables.push_back(renderable);
+            }
+        }
+
+        m_vPrototypes.push_back({ std::move(prototype), vertices, cooked.m_uVertexBytes, indices, cooked.m_uIndexBytes, cooked.m_uMesh, cooked.m_ContentKey,
+                                  std::vector<uint32_t>(images, images + cooked.m_uImageCount) });
+    }
+
+    for (uint32_t i = 0; valid && i < header->m_uInstanceCount; ++i)
+    {
+        const CookedInstance& cooked = cookedInstances[i];
+        valid = cooked.m_uPrototype < header->m_uPrototypeCount;
+        if (valid)
+            m_vInstances.push_back({ cooked.m_uPrototype, cooked.m_m4Transform, cooked.m_uDynamic != 0u });
+    }
+
+    if (!valid)
+    {
+        clear();
+        return false;
+    }
+
+    m_uPrimitiveCount = header->m_uPrimitiveCount;
+    return true;
+}
+
+void MeshCache::clear()
+{
+    m_vPrototypes.clear();
+    m_vInstances.clear();
+    m_vImages.clear();
+    m_uPrimitiveCount = 0u;
+    m_File.close();
+}
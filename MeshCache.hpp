@@ -0,0 +1,90 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+#include "Model.hpp"
+#include "Renderer/TexturePool.hpp"
+
+/**
+ * Cooked form of one glTF file: the final vertex and index buffer contents of every prototype, its renderables
+ * (LODs included), meshlets, bounds and occluder, the decoded RGBA8 images its materials sample and the instances
+ * of the scene. A warm load maps the file, checks it and hands out pointers into the mapping, which
+ * StaticBuffer::uploadData() and TexturePool::upload() copy straight into staging memory. Nothing is parsed,
+ * decoded or re-packed.
+ *
+ * The file is keyed by a hash over the contents of every file the source was loaded from (the .gltf/.glb and
+ * its external buffers), so editing any of them invalidates it. The paths and sizes are stored in the file itself,
+ * a warm load does not need the glTF JSON to know what to hash and skips hashing when a size changed. Bump FILE_VERSION whenever the loader's output
+ * changes (LOD or optimization settings). Prototypes record their vertex layout, files cooked in another layout
+ * than MESH_VERTEX_LAYOUT are rejected like damaged ones.
+ *
+ * Layout, native endianness: header, dependency paths, prototype, instance and image tables, per-prototype
+ * tables, then the vertex and index blobs and the pixel blobs, each starting at a BLOB_ALIGNMENT boundary.
+ */
+class MeshCache
+{
+public:
+    static constexpr uint64_t BLOB_ALIGNMENT = 64u;
+
+    struct Prototype
+    {
+        // Everything but the GeometryPool allocation and the geometry handle, vertex offsets and first
+        // indices are relative to the blobs. Primitive ids are local to the file after load(),
+        // [0, getPrimitiveCount()), the loader offsets them into its global range.
+        std::shared_ptr<ModelPrototype> m_pPrototype;
+
+        const void* m_pVertices;
+        uint64_t m_uVertexBytes;
+        const void* m_pIndices;
+        uint64_t m_uIndexBytes;
+
+        // What the PrototypeCache knows the prototype by, the glTF mesh it was decoded from and its content key
+        uint32_t m_uMesh;
+        Hash::Key128 m_ContentKey;
+
+        // Indices into the file's images, the order of ModelPrototype::m_vTextures once uploaded
+        std::vector<uint32_t> m_vImages;
+    };
+
+    struct Instance
+    {
+        uint32_t m_uPrototype;
+        glm::mat4 m_m4Transform;
+        bool m_bDynamic;
+    };
+
+    // Hash over the contents of the files, false when one of them cannot be read
+    static bool computeSourceKey(const std::vector<std::string>& dependencies, uint64_t& key);
+
+    // Writes a new file, primitive ids are renumbered from 0 in order of appearance
+    static bool save(const char* filename, uint64_t sourceKey, const std::vector<std::string>& dependencies,
+                     const std::vector<Prototype>& prototypes, const std::vector<Instance>& instances, const std::vector<TexturePool::Image>& images);
+
+    // False and left empty when the file is missing, damaged, of another version or any dependency changed
+    bool load(const char* filename);
+    void clear();
+
+    const std::vector<Prototype>& getPrototypes() const { return m_vPrototypes; }
+    const std::vector<Instance>& getInstances() const { return m_vInstances; }
+    const std::vector<TexturePool::Image>& getImages() const { return m_vImages; }
+    uint32_t getPrimitiveCount() const { return m_uPrimitiveCount; }
+
+private:
+    // The blobs point into it, keep the cache alive until they are uploaded
+    MappedFile m_File;
+
+    std::vector<Prototype> m_vPrototypes;
+    std::vector<Instance> m_vInstances;
+    std::vector<TexturePool::Image> m_vImages;
+    uint32_t m_uPrimitiveCount = 0u;
+};
+
+#endif // MESH_CACHE_HPP
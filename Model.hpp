@@ -7,19 +7,78 @@
 #include <glm/mat4x4.hpp>
 
 #include "Buffer.hpp"
+#include "Geometry/MeshletBuilder.hpp"
+#include "Renderer/GeometryPool.hpp"
 #include "Renderer/Renderable.hpp"
+#include "Renderer/TexturePool.hpp"
+#include "Visibility/Bounds.hpp"
+#include "Visibility/OcclusionCuller.hpp"
 
 
 struct ModelPrototype {
-    StaticBuffer m_VertexBuffer;    
-    StaticBuffer m_IndexBuffer;
+    ModelPrototype() = default;
+    ModelPrototype(const ModelPrototype&) = delete;
+    ModelPrototype& operator=(const ModelPrototype&) = delete;
 
-    std::vector<VkImage> m_VkImages;
-    std::vector<VkImageView> m_VkImageViews;
-    std::vector<VkDeviceMemory> m_VkImageDeviceMemory;
+    ~ModelPrototype() { GeometryPool::free(m_Geometry); }
+
+    // Vertex and index ranges in the GeometryPool, invalid until the prototype is uploaded. The renderables'
+    // vertexOffset and firstIndex include the allocation's offsets from then on.
+    GeometryPool::Allocation m_Geometry;
+    uint32_t m_uGeometry; // GeometryTable handle of the pool for m_eIndexType
+    VkIndexType m_eIndexType = VK_INDEX_TYPE_UINT32; // UINT16 when every primitive's indices fit
+
+    // VertexLayout::getKey() of the vertices, and the matrix taking their positions to local space
+    uint32_t m_uVertexLayout = 0u;
+    glm::mat4 m_m4VertexDecode { 1.0f };
+
+    // Local space, m_vPrimitiveBounds is parallel to m_Renderables
+    Bounds m_Bounds;
+    std::vector<Bounds> m_vPrimitiveBounds;
+
+    // Local space triangles rasterized by the OcclusionCuller, empty unless the glTF mesh is marked as occluder
+    OccluderMesh m_Occluder;
+
+    // Every image the materials of the primitives sample, once each, empty until the prototype is uploaded.
+    // Shared with every prototype that uses the same pixels.
+    std::vector<std::shared_ptr<Texture>> m_vTextures;
 
     std::vector<uint32_t> m_vMaterialIds;
     std::vector<Renderable> m_Renderables;
+
+    // Simplified levels of m_Renderables, m_vLodRenderables[lod - 1] is parallel to it. Every level is an index
+    // range of the prototype's indices with its own primitive id, primitives that ran out of levels repeat their coarsest one.
+    std::vector<std::vector<Renderable>> m_vLodRenderables;
+
+    // Meshlets of m_Renderables (LOD 0 only), renderable r owns [m_vFirstMeshlets[r], m_vFirstMeshlets[r + 1])
+    // of m_vMeshlets. Their index ranges are relative to the renderable, so they stay valid across uploads.
+    std::vector<Meshlet> m_vMeshlets;
+    std::vector<uint32_t> m_vFirstMeshlets;
+
+    uint32_t getLodCount() const { return static_cast<uint32_t>(m_vLodRenderables.size()) + 1u; }
+
+    const std::vector<Renderable>& getRenderables(uint32_t lod) const { return lod == 0u ? m_Renderables : m_vLodRenderables[lod - 1u]; }
+
+    uint32_t getMeshletCount(uint32_t renderable) const { return m_vFirstMeshlets[renderable + 1u] - m_vFirstMeshlets[renderable]; }
+    const Meshlet* getMeshlets(uint32_t renderable) const { return m_vMeshlets.data() + m_vFirstMeshlets[renderable]; }
+
+    // LOD 0 renderable narrowed to one of its meshlets
+    Renderable getMeshletRenderable(uint32_t renderable, const Meshlet& meshlet) const
+    {
+        Renderable narrowed = m_Renderables[renderable];
+        narrowed.primitive = meshlet.m_uPrimitive;
+        narrowed.firstIndex += meshlet.m_uFirstIndex;
+        narrowed.indexCount = meshlet.m_uIndexCount;
+        return narrowed;
+    }
+
+    uint32_t getTriangleCount(uint32_t lod) const
+    {
+        uint32_t triangleCount = 0u;
+        for (const Renderable& renderable : getRenderables(lod))
+            triangleCount += renderable.indexCount / 3u;
+        return triangleCount;
+    }
 };
 
 struct Model
@@ -27,11 +86,23 @@ struct Model
     Model(std::shared_ptr<ModelPrototype> prototype, glm::mat4 transform)
     : m_pPrototype(prototype)
     , m_m4Transform(transform)
-    {}
+    {
+        updateTransform();
+    }
 
     Model(Model&& other)
     : m_uHandle(std::move(other.m_uHandle))
     , m_pPrototype(std::move(other.m_pPrototype))
+    , m_m4Transform(other.m_m4Transform)
+    , m_m4DrawTransform(other.m_m4DrawTransform)
+    , m_WorldBounds(other.m_WorldBounds)
+    , m_vDrawHandles(std::move(other.m_vDrawHandles))
+    , m_vMeshletHandles(std::move(other.m_vMeshletHandles))
+    , m_vMeshletVisible(std::move(other.m_vMeshletVisible))
+    , m_vSplitRenderables(std::move(other.m_vSplitRenderables))
+    , m_bVisible(other.m_bVisible)
+    , m_bDynamic(other.m_bDynamic)
+    , m_uLod(other.m_uLod)
     {
         other.m_uHandle = -1;
         other.m_pPrototype = nullptr;
@@ -41,6 +112,16 @@ struct Model
     {
         m_uHandle = rhs.m_uHandle;
         m_pPrototype = rhs.m_pPrototype;
+        m_m4Transform = rhs.m_m4Transform;
+        m_m4DrawTransform = rhs.m_m4DrawTransform;
+        m_WorldBounds = rhs.m_WorldBounds;
+        m_vDrawHandles = std::move(rhs.m_vDrawHandles);
+        m_vMeshletHandles = std::move(rhs.m_vMeshletHandles);
+        m_vMeshletVisible = std::move(rhs.m_vMeshletVisible);
+        m_vSplitRenderables = std::move(rhs.m_vSplitRenderables);
+        m_bVisible = rhs.m_bVisible;
+        m_bDynamic = rhs.m_bDynamic;
+        m_uLod = rhs.m_uLod;
 
         rhs.m_uHandle = -1;
         rhs.m_pPrototype = nullptr;
@@ -51,6 +132,40 @@ struct Model
     uint16_t m_uHandle;
     std::shared_ptr<ModelPrototype> m_pPrototype;
     glm::mat4 m_m4Transform;
+
+    // m_m4Transform with the prototype's vertex decode applied, what the renderables are drawn with
+    glm::mat4 m_m4DrawTransform;
+
+    // Prototype bounds under m_m4Transform
+    Bounds m_WorldBounds;
+
+    // Call after changing m_m4Transform
+    void updateTransform()
+    {
+        m_m4DrawTransform = m_m4Transform * m_pPrototype->m_m4VertexDecode;
+        m_WorldBounds = m_pPrototype->m_Bounds.transformed(m_m4Transform);
+    }
+
+    // RenderManager handles of the prototype's renderables of every LOD while the model is registered in
+    // RETAINED mode, m_vDrawHandles[lod * m_Renderables.size() + renderable]
+    std::vector<uint32_t> m_vDrawHandles;
+
+    // RETAINED mode handles of the LOD 0 meshlets, parallel to the prototype's m_vMeshlets, and which of them are
+    // shown. A LOD 0 renderable is drawn whole unless m_vSplitRenderables[renderable] is set, then by its shown
+    // meshlets. Both are cleared while the model is hidden or at another LOD.
+    std::vector<uint32_t> m_vMeshletHandles;
+    std::vector<uint8_t> m_vMeshletVisible;
+    std::vector<uint8_t> m_vSplitRenderables;
+
+    // Frustum culling result of the last frame, RETAINED mode only pushes changes of it to the RenderManager
+    bool m_bVisible = true;
+
+    // Static models are culled through the scene's StaticBvh and must keep their transform,
+    // dynamic ones are brute-force culled and may move every frame
+    bool m_bDynamic = false;
+
+    // LOD drawn last frame (Lod::select), only the draws of this LOD are visible in RETAINED mode
+    uint32_t m_uLod = 0u;
 };
 
 #endif // MODEL_HPP
\ No newline at end of file
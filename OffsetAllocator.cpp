@@ -0,0 +1,97 @@
+#include "OffsetAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+OffsetAllocator::OffsetAllocator(uint32_t capacity)
+    : m_uCapacity{0u}, m_uFreeSize{0u}
+{
+    reset(capacity);
+}
+
+void OffsetAllocator::reset(uint32_t capacity)
+{
+    m_FreeByOffset.clear();
+    m_FreeBySize.clear();
+    m_Allocations.clear();
+
+    m_uCapacity = capacity;
+    m_uFreeSize = 0u;
+    if (capacity > 0u)
+        addFreeRange(0u, capacity);
+}
+
+uint32_t OffsetAllocator::allocate(uint32_t size)
+{
+    size = std::max(size, 1u);
+
+    auto bestFit = m_FreeBySize.lower_bound(size);
+    if (bestFit == m_FreeBySize.end())
+        return INVALID_OFFSET;
+
+    const uint32_t offset = bestFit->second;
+    const uint32_t rangeSize = bestFit->first;
+    removeFreeRange(m_FreeByOffset.find(offset));
+
+    // The rest of the range stays free
+    if (rangeSize > size)
+        addFreeRange(offset + size, rangeSize - size);
+
+    m_Allocations.emplace(offset, size);
+    return offset;
+}
+
+void OffsetAllocator::free(uint32_t offset)
+{
+    auto allocation = m_Allocations.find(offset);
+    assert(allocation != m_Allocations.end() && "Freeing an offset that was not allocated!");
+    if (allocation == m_Allocations.end())
+        return;
+
+    uint32_t size = allocation->second;
+    m_Allocations.erase(allocation);
+
+    auto next = m_FreeByOffset.lower_bound(offset);
+    if (next != m_FreeByOffset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        next = std::next(next);
+        removeFreeRange(std::prev(next));
+    }
+
+    if (next != m_FreeByOffset.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            removeFreeRange(previous);
+        }
+    }
+
+    addFreeRange(offset, size);
+}
+
+void OffsetAllocator::addFreeRange(uint32_t offset, uint32_t size)
+{
+    m_FreeByOffset.emplace(offset, size);
+    m_FreeBySize.emplace(size, offset);
+    m_uFreeSize += size;
+}
+
+void OffsetAllocator::removeFreeRange(std::map<uint32_t, uint32_t>::iterator range)
+{
+    auto bySize = m_FreeBySize.equal_range(range->second);
+    for (auto entry = bySize.first; entry != bySize.second; ++entry)
+    {
+        if (entry->second == range->first)
+        {
+            m_FreeBySize.erase(entry);
+            break;
+        }
+    }
+
+    m_uFreeSize -= range->second;
+    m_FreeByOffset.erase(range);
+}
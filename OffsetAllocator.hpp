@@ -0,0 +1,45 @@
+#ifndef OFFSET_ALLOCATOR_HPP
+#define OFFSET_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+/**
+ * Hands out ranges of a fixed capacity without touching the memory itself, for sub-allocating GPU buffers.
+ * Sizes and offsets are in whatever unit the caller picks (vertices, 4 byte index words). Best fit over the free
+ * ranges, freed ranges merge with their free neighbours. Every call is O(log n) in the number of ranges, meant
+ * for load time rather than per-frame churn. Not thread safe.
+ */
+class OffsetAllocator
+{
+public:
+    static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+    explicit OffsetAllocator(uint32_t capacity = 0u);
+
+    // Frees everything, the allocator then manages [0, capacity)
+    void reset(uint32_t capacity);
+
+    // INVALID_OFFSET when no free range is large enough. Empty requests take one unit, offsets stay unique.
+    uint32_t allocate(uint32_t size);
+    void free(uint32_t offset);
+
+    uint32_t getCapacity() const { return m_uCapacity; }
+    uint32_t getFreeSize() const { return m_uFreeSize; }
+    uint32_t getLargestFreeRange() const { return m_FreeBySize.empty() ? 0u : m_FreeBySize.rbegin()->first; }
+    uint32_t getAllocationCount() const { return static_cast<uint32_t>(m_Allocations.size()); }
+
+private:
+    void addFreeRange(uint32_t offset, uint32_t size);
+    void removeFreeRange(std::map<uint32_t, uint32_t>::iterator range);
+
+    uint32_t m_uCapacity;
+    uint32_t m_uFreeSize;
+
+    std::map<uint32_t, uint32_t> m_FreeByOffset;     // offset -> size, finds the neighbours to merge with
+    std::multimap<uint32_t, uint32_t> m_FreeBySize;  // size -> offset, finds the best fit
+    std::unordered_map<uint32_t, uint32_t> m_Allocations; // offset -> size
+};
+
+#endif // OFFSET_ALLOCATOR_HPP
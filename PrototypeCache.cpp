@@ -0,0 +1,104 @@
+#include "PrototypeCache.hpp"
+#include "Hash.hpp"
+
+#include <cstdlib>
+
+#include <limits.h>
+
+std::string PrototypeCache::makeFileKey(const std::string& filepath)
+{
+    char* resolved = realpath(filepath.c_str(), nullptr);
+    if (resolved == nullptr)
+        return filepath;
+
+    std::string fileKey = resolved;
+    free(resolved);
+    return fileKey;
+}
+
+Hash::Key128 PrototypeCache::computeContentKey(const MeshCache::Prototype& prototype, const std::vector<TexturePool::Image>& images)
+{
+    const ModelPrototype& model = *prototype.m_pPrototype;
+
+    Hash::Key128 key = Hash::SEED_128;
+    key = Hash::value(key, prototype.m_uVertexBytes);
+    key = Hash::bytes(key, prototype.m_pVertices, prototype.m_uVertexBytes);
+    key = Hash::value(key, prototype.m_uIndexBytes);
+    key = Hash::bytes(key, prototype.m_pIndices, prototype.m_uIndexBytes);
+    key = Hash::value(key, model.m_eIndexType);
+
+    // Quantized vertices of meshes that only differ in size are the same bytes
+    key = Hash::value(key, model.m_uVertexLayout);
+    key = Hash::value(key, model.m_m4VertexDecode);
+
+    key = Hash::value(key, model.getLodCount());
+    key = Hash::value(key, model.m_Renderables.size());
+    for (uint32_t lod = 0; lod < model.getLodCount(); ++lod)
+    {
+        for (const Renderable& renderable : model.getRenderables(lod))
+        {
+            key = Hash::value(key, renderable.indexCount);
+            key = Hash::value(key, renderable.firstIndex);
+            key = Hash::value(key, renderable.vertexOffset);
+        }
+    }
+
+    // Cones depend on the material being double-sided, not only on the geometry
+    key = Hash::value(key, model.m_vMeshlets.size());
+    for (const Meshlet& meshlet : model.m_vMeshlets)
+    {
+        key = Hash::value(key, meshlet.m_uFirstIndex);
+        key = Hash::value(key, meshlet.m_uIndexCount);
+        key = Hash::value(key, meshlet.m_fConeCutoff);
+    }
+
+    key = Hash::value(key, model.m_Occluder.m_vPositions.size());
+    key = Hash::bytes(key, model.m_Occluder.m_vPositions.data(), model.m_Occluder.m_vPositions.size() * sizeof(glm::vec3));
+    key = Hash::value(key, model.m_Occluder.m_vIndices.size());
+    key = Hash::bytes(key, model.m_Occluder.m_vIndices.data(), model.m_Occluder.m_vIndices.size() * sizeof(uint32_t));
+
+    // The same mesh with other textures is another prototype
+    key = Hash::value(key, prototype.m_vImages.size());
+    for (uint32_t image : prototype.m_vImages)
+        key = Hash::value(key, images[image].m_ContentKey);
+
+    return key;
+}
+
+std::shared_ptr<ModelPrototype> PrototypeCache::find(const std::string& fileKey, uint32_t mesh)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto file = m_FileMeshes.find(fileKey);
+    if (file == m_FileMeshes.end() || mesh >= file->second.size())
+        return nullptr;
+
+    return file->second[mesh].lock();
+}
+
+std::shared_ptr<ModelPrototype> PrototypeCache::add(const std::string& fileKey, uint32_t mesh, const Hash::Key128& contentKey, const std::shared_ptr<ModelPrototype>& prototype)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::weak_ptr<ModelPrototype>& content = m_ContentPrototypes[contentKey];
+    std::shared_ptr<ModelPrototype> shared = content.lock();
+    if (shared == nullptr)
+    {
+        shared = prototype;
+        content = prototype;
+    }
+
+    std::vector<std::weak_ptr<ModelPrototype>>& meshes = m_FileMeshes[fileKey];
+    if (mesh >= meshes.size())
+        meshes.resize(mesh + 1u);
+    meshes[mesh] = shared;
+
+    return shared;
+}
+
+void PrototypeCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_FileMeshes.clear();
+    m_ContentPrototypes.clear();
+}
@@ -0,0 +1,53 @@
+#ifndef PROTOTYPE_CACHE_HPP
+#define PROTOTYPE_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Hash.hpp"
+#include "MeshCache.hpp"
+#include "Model.hpp"
+
+/**
+ * Prototypes that are alive, so loading a mesh that already has one hands out the same shared_ptr, primitive ids
+ * and GPU buffers instead of building a copy. Entries are weak, a prototype is released with its last model.
+ *
+ * Looked up by (file, mesh index) first, which skips decoding a mesh of a file that was loaded before (files are
+ * expected not to change while the application runs), then by a key over the prototype's final content, which
+ * catches the same mesh exported into several files. The 128 bit content key (Hash::Key128) is trusted, a hit is
+ * not compared byte by byte since a live prototype's geometry only exists on the GPU: two different meshes whose
+ * keys collide would share one prototype's buffers.
+ *
+ * Files of a batch are decoded concurrently, a prototype may be handed out before the file that added it uploaded
+ * its buffers. GLTFBatchLoader's rule that nothing is drawn before every file of a batch is ready covers that.
+ */
+class PrototypeCache
+{
+public:
+    // Absolute path without "." and ".." or symbolic links, so every spelling of a path finds the same entries
+    static std::string makeFileKey(const std::string& filepath);
+
+    // Vertex and index bytes with their layout and decode, index type, renderable ranges of every LOD, the
+    // occluder and the content keys of the prototype's images, primitive ids excluded
+    static Hash::Key128 computeContentKey(const MeshCache::Prototype& prototype, const std::vector<TexturePool::Image>& images);
+
+    // Null when the mesh was never added or its prototype is gone
+    std::shared_ptr<ModelPrototype> find(const std::string& fileKey, uint32_t mesh);
+
+    // The live prototype with the same content key if there is one, prototype otherwise, registered for the mesh
+    // either way. Callers own the buffers of prototype only when it is returned.
+    std::shared_ptr<ModelPrototype> add(const std::string& fileKey, uint32_t mesh, const Hash::Key128& contentKey, const std::shared_ptr<ModelPrototype>& prototype);
+
+    void clear();
+
+private:
+    std::mutex m_Mutex;
+    std::unordered_map<std::string, std::vector<std::weak_ptr<ModelPrototype>>> m_FileMeshes; // indexed by mesh
+    std::unordered_map<Hash::Key128, std::weak_ptr<ModelPrototype>, Hash::Key128Hasher> m_ContentPrototypes;
+};
+
+#endif // PROTOTYPE_CACHE_HPP
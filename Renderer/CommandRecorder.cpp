@@ -0,0 +1,136 @@
+#include "CommandRecorder.hpp"
+#include "../Buffer.hpp"
+
+#include <cassert>
+
+bool CommandRecorder::m_bMultiDrawIndirect = false;
+bool CommandRecorder::m_bDrawIndirectFirstInstance = false;
+PFN_vkCmdDrawIndexedIndirectCountKHR CommandRecorder::m_pfnDrawIndexedIndirectCount = nullptr;
+
+void CommandRecorder::invalidate()
+{
+    m_VkBoundPipeline = VK_NULL_HANDLE;
+
+    m_VkBoundLayout = VK_NULL_HANDLE;
+    m_vVkBoundDescriptorSets.fill(VK_NULL_HANDLE);
+
+    m_VkBoundIndexBuffer = VK_NULL_HANDLE;
+    m_uBoundIndexOffset = 0u;
+    m_eBoundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+    m_vVkBoundVertexBuffers.fill(VK_NULL_HANDLE);
+    m_vBoundVertexOffsets.fill(0u);
+}
+
+void CommandRecorder::bindPipeline(VkPipeline pipeline)
+{
+    if (pipeline == m_VkBoundPipeline)
+    {
+        ++m_Stats.m_uElidedBinds;
+        return;
+    }
+
+    vkCmdBindPipeline(m_VkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    m_VkBoundPipeline = pipeline;
+    ++m_Stats.m_uIssuedBinds;
+}
+
+void CommandRecorder::bindDescriptorSet(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptorSet)
+{
+    assert(set < MAX_DESCRIPTOR_SETS);
+
+    // Sets bound through a different layout may have been disturbed, don't trust any of them
+    if (layout != m_VkBoundLayout)
+    {
+        m_VkBoundLayout = layout;
+        m_vVkBoundDescriptorSets.fill(VK_NULL_HANDLE);
+    }
+
+    if (descriptorSet == m_vVkBoundDescriptorSets[set])
+    {
+        ++m_Stats.m_uElidedBinds;
+        return;
+    }
+
+    vkCmdBindDescriptorSets(m_VkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1u, &descriptorSet, 0u, nullptr);
+    m_vVkBoundDescriptorSets[set] = descriptorSet;
+    ++m_Stats.m_uIssuedBinds;
+}
+
+void CommandRecorder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    if (buffer == m_VkBoundIndexBuffer && offset == m_uBoundIndexOffset && indexType == m_eBoundIndexType)
+    {
+        ++m_Stats.m_uElidedBinds;
+        return;
+    }
+
+    vkCmdBindIndexBuffer(m_VkCommandBuffer, buffer, offset, indexType);
+    m_VkBoundIndexBuffer = buffer;
+    m_uBoundIndexOffset = offset;
+    m_eBoundIndexType = indexType;
+    ++m_Stats.m_uIssuedBinds;
+}
+
+void CommandRecorder::bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+{
+    assert(binding < MAX_VERTEX_BINDINGS);
+
+    if (buffer == m_vVkBoundVertexBuffers[binding] && offset == m_vBoundVertexOffsets[binding])
+    {
+        ++m_Stats.m_uElidedBinds;
+        return;
+    }
+
+    vkCmdBindVertexBuffers(m_VkCommandBuffer, binding, 1u, &buffer, &offset);
+    m_vVkBoundVertexBuffers[binding] = buffer;
+    m_vBoundVertexOffsets[binding] = offset;
+    ++m_Stats.m_uIssuedBinds;
+}
+
+glm::mat4* CommandRecorder::allocateInstances(uint32_t count, uint32_t& firstInstance)
+{
+    assert(m_pInstanceBuffer != nullptr && "CommandRecorder has no instance buffer!");
+
+    // Aligned to a whole matrix so the offset is an instance index into the buffer bound at offset 0
+    const LinearBuffer::Allocation allocation = m_pInstanceBuffer->allocate(count * sizeof(glm::mat4), sizeof(glm::mat4));
+    if (allocation.m_pData == nullptr)
+        return nullptr;
+
+    bindVertexBuffer(INSTANCE_BINDING, m_pInstanceBuffer->getBuffer(), 0u);
+
+    firstInstance = static_cast<uint32_t>(allocation.m_uOffset / sizeof(glm::mat4));
+    return static_cast<glm::mat4*>(allocation.m_pData);
+}
+
+void CommandRecorder::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+    vkCmdDrawIndexed(m_VkCommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    ++m_Stats.m_uDraws;
+}
+
+void CommandRecorder::drawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount)
+{
+    if (m_bMultiDrawIndirect)
+    {
+        vkCmdDrawIndexedIndirect(m_VkCommandBuffer, buffer, offset, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+        ++m_Stats.m_uDraws;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < drawCount; ++i)
+            vkCmdDrawIndexedIndirect(m_VkCommandBuffer, buffer, offset + i * sizeof(VkDrawIndexedIndirectCommand), 1u, sizeof(VkDrawIndexedIndirectCommand));
+        m_Stats.m_uDraws += drawCount;
+    }
+
+    m_Stats.m_uIndirectCommands += drawCount;
+}
+
+void CommandRecorder::drawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount)
+{
+    assert(supportsDrawIndirectCount() && "vkCmdDrawIndexedIndirectCount is not available on this device!");
+
+    m_pfnDrawIndexedIndirectCount(m_VkCommandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    ++m_Stats.m_uDraws;
+    m_Stats.m_uIndirectCommands += maxDrawCount;
+}
@@ -0,0 +1,107 @@
+#ifndef COMMAND_RECORDER_HPP
+#define COMMAND_RECORDER_HPP
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+#include <glm/mat4x4.hpp>
+
+class LinearBuffer;
+
+/**
+ * Thin wrapper around a VkCommandBuffer that remembers the currently bound pipeline, descriptor sets,
+ * index buffer and vertex buffers and drops binds that would not change anything. One recorder per
+ * command buffer being recorded; it is not thread safe.
+ */
+class CommandRecorder
+{
+public:
+    static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4u;
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 4u;
+
+    // Vertex binding the per-instance model matrices are read from (see PipelineManager)
+    static constexpr uint32_t INSTANCE_BINDING = 1u;
+
+    struct Stats
+    {
+        uint32_t m_uIssuedBinds = 0u;
+        uint32_t m_uElidedBinds = 0u;
+        uint32_t m_uDraws = 0u;             // draw calls recorded, an indirect call counts once
+        uint32_t m_uIndirectCommands = 0u;  // VkDrawIndexedIndirectCommands consumed by indirect calls
+
+        Stats& operator+=(const Stats& rhs)
+        {
+            m_uIssuedBinds += rhs.m_uIssuedBinds;
+            m_uElidedBinds += rhs.m_uElidedBinds;
+            m_uDraws += rhs.m_uDraws;
+            m_uIndirectCommands += rhs.m_uIndirectCommands;
+            return *this;
+        }
+    };
+
+    // Device capabilities for the indirect path. Without multiDrawIndirect every indirect command is issued
+    // as its own call, drawIndexedIndirectCount may be nullptr when VK_KHR_draw_indirect_count is missing.
+    // Without drawIndirectFirstInstance indirect commands cannot address the instance buffer.
+    static void initialize(bool multiDrawIndirect, bool drawIndirectFirstInstance, PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount)
+    {
+        m_bMultiDrawIndirect = multiDrawIndirect;
+        m_bDrawIndirectFirstInstance = drawIndirectFirstInstance;
+        m_pfnDrawIndexedIndirectCount = drawIndexedIndirectCount;
+    }
+
+    static bool supportsDrawIndirectCount() { return m_pfnDrawIndexedIndirectCount != nullptr; }
+    static bool supportsDrawIndirectFirstInstance() { return m_bDrawIndirectFirstInstance; }
+
+    CommandRecorder(VkCommandBuffer commandBuffer, LinearBuffer* instanceBuffer, LinearBuffer* indirectBuffer = nullptr)
+        : m_VkCommandBuffer{commandBuffer}, m_pInstanceBuffer{instanceBuffer}, m_pIndirectBuffer{indirectBuffer}
+    {
+        invalidate();
+    }
+
+    VkCommandBuffer getCommandBuffer() const { return m_VkCommandBuffer; }
+    const Stats& getStats() const { return m_Stats; }
+
+    // Per-frame buffer indirect commands are written to, nullptr when the indirect path is unavailable
+    LinearBuffer* getIndirectBuffer() const { return m_pIndirectBuffer; }
+
+    // Forget all tracked state, the next bind of every kind is always issued
+    void invalidate();
+
+    void bindPipeline(VkPipeline pipeline);
+    void bindDescriptorSet(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptorSet);
+    void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+    void bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset);
+
+    // Reserves count model matrices in the per-frame instance buffer and makes sure it is bound. Returns nullptr
+    // when the buffer is full, otherwise firstInstance is the value the draw reading these matrices must use.
+    glm::mat4* allocateInstances(uint32_t count, uint32_t& firstInstance);
+
+    void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+    void drawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount);
+    void drawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount);
+
+private:
+    static bool m_bMultiDrawIndirect;
+    static bool m_bDrawIndirectFirstInstance;
+    static PFN_vkCmdDrawIndexedIndirectCountKHR m_pfnDrawIndexedIndirectCount;
+
+    VkCommandBuffer m_VkCommandBuffer;
+    LinearBuffer* m_pInstanceBuffer;
+    LinearBuffer* m_pIndirectBuffer;
+    Stats m_Stats;
+
+    VkPipeline m_VkBoundPipeline;
+
+    VkPipelineLayout m_VkBoundLayout;
+    std::array<VkDescriptorSet, MAX_DESCRIPTOR_SETS> m_vVkBoundDescriptorSets;
+
+    VkBuffer m_VkBoundIndexBuffer;
+    VkDeviceSize m_uBoundIndexOffset;
+    VkIndexType m_eBoundIndexType;
+
+    std::array<VkBuffer, MAX_VERTEX_BINDINGS> m_vVkBoundVertexBuffers;
+    std::array<VkDeviceSize, MAX_VERTEX_BINDINGS> m_vBoundVertexOffsets;
+};
+
+#endif // COMMAND_RECORDER_HPP
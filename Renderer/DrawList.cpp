@@ -0,0 +1,256 @@
+#include "DrawList.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+PipelineManager* DrawList::m_pPipelineManager = nullptr;
+
+namespace
+{
+    constexpr uint32_t RADIX_BITS = 8u;
+    constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+    constexpr uint32_t RADIX_PASSES = 64u / RADIX_BITS;
+
+    // Maps a float onto a uint32_t whose unsigned ordering matches the float ordering
+    uint32_t orderedFloatBits(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+}
+
+uint64_t DrawList::makeKey(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, float depth)
+{
+    const uint64_t sortBin = static_cast<uint64_t>(sortBinType);
+    const uint64_t pipeline = static_cast<uint64_t>(pipelineType);
+
+    assert(sortBin < (1ull << SORT_BIN_BITS) && "SortBinType does not fit in the sort key");
+    assert(pipeline < (1ull << PIPELINE_BITS) && "PipelineType does not fit in the sort key");
+    assert(matId < (1u << MATERIAL_BITS) && "Material id does not fit in the sort key");
+
+    return (sortBin << SORT_BIN_SHIFT) |
+           (pipeline << PIPELINE_SHIFT) |
+           (static_cast<uint64_t>(matId) << MATERIAL_SHIFT) |
+           static_cast<uint64_t>(orderedFloatBits(depth));
+}
+
+uint64_t DrawList::makeInstancingKey(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, uint32_t primitive)
+{
+    // Depth 0.0f maps to 0x80000000, clear it so the low bits carry only the primitive
+    return (makeKey(sortBinType, pipelineType, matId, 0.0f) & ~((1ull << DEPTH_BITS) - 1u)) | primitive;
+}
+
+void DrawList::reserve(uint32_t count)
+{
+    m_vKeys.reserve(count);
+    m_vPendingKeys.reserve(count);
+    m_vScratch.reserve(count);
+    m_vRenderables.reserve(count);
+    m_vTransforms.reserve(count);
+    m_vSlotKeys.reserve(count);
+    m_vFlags.reserve(count);
+    m_vChangedSlots.reserve(count);
+}
+
+DrawList::Handle DrawList::addRenderable(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, const Renderable& renderable, const glm::mat4& transform, float depth)
+{
+    const uint64_t key = m_bInstancing ? makeInstancingKey(sortBinType, pipelineType, matId, renderable.primitive)
+                                       : makeKey(sortBinType, pipelineType, matId, depth);
+
+    Handle handle;
+    if (m_vFreeSlots.empty())
+    {
+        handle = static_cast<Handle>(m_vRenderables.size());
+        m_vRenderables.push_back(renderable);
+        m_vTransforms.push_back(transform);
+        m_vSlotKeys.push_back(key);
+        m_vFlags.push_back(FLAG_ALIVE | FLAG_VISIBLE | FLAG_COMMITTED);
+    }
+    else
+    {
+        handle = m_vFreeSlots.back();
+        m_vFreeSlots.pop_back();
+        m_vRenderables[handle] = renderable;
+        m_vTransforms[handle] = transform;
+        m_vSlotKeys[handle] = key;
+        m_vFlags[handle] = FLAG_ALIVE | FLAG_VISIBLE | FLAG_COMMITTED;
+    }
+
+    m_vPendingKeys.push_back({ key, handle });
+    return handle;
+}
+
+void DrawList::remove(Handle handle)
+{
+    assert(isAlive(handle));
+
+    // The slot is only recycled once sort() has dropped its key
+    m_vFlags[handle] &= ~(FLAG_ALIVE | FLAG_VISIBLE);
+    markChanged(handle);
+}
+
+/**
+ * LSD radix sort over the 64-bit keys, 8 bits per pass. All histograms are built in a single read of the
+ * keys and passes where every key shares the same digit are skipped, which is the common case for the
+ * sort bin / pipeline bytes. Stable, so equal keys keep their submission order.
+ */
+void DrawList::radixSort(std::pmr::vector<SortKey>& keys, std::pmr::vector<SortKey>& scratch)
+{
+    const size_t count = keys.size();
+    if (count < 2)
+        return;
+
+    std::array<std::array<uint32_t, RADIX_BUCKETS>, RADIX_PASSES> histograms {};
+
+    for (const SortKey& sortKey : keys)
+    {
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+            ++histograms[pass][(sortKey.m_uKey >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1u)];
+    }
+
+    scratch.resize(count);
+
+    SortKey* src = keys.data();
+    SortKey* dst = scratch.data();
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+    {
+        std::array<uint32_t, RADIX_BUCKETS>& histogram = histograms[pass];
+
+        const uint32_t firstDigit = (src[0].m_uKey >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1u);
+        if (histogram[firstDigit] == count)
+            continue;
+
+        uint32_t offset = 0u;
+        for (uint32_t& bucket : histogram)
+        {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t digit = (src[i].m_uKey >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1u);
+            dst[histogram[digit]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != keys.data())
+        memcpy(keys.data(), src, count * sizeof(SortKey));
+}
+
+/**
+ * Only the changed slots are visited: keys of entries that stopped being drawable are dropped, keys of entries
+ * that became drawable join the ones added since the last call. Those are sorted and merged behind the committed
+ * keys they compare equal to, so equal keys draw in the order they were committed. Frames without changes do no
+ * work at all, immediate mode frames only add.
+ */
+void DrawList::sort()
+{
+    bool dropKeys = false;
+    for (const Handle handle : m_vChangedSlots)
+    {
+        uint8_t& flags = m_vFlags[handle];
+        const bool drawable = (flags & (FLAG_ALIVE | FLAG_VISIBLE)) == (FLAG_ALIVE | FLAG_VISIBLE);
+
+        if (drawable && !(flags & FLAG_COMMITTED))
+            m_vPendingKeys.push_back({ m_vSlotKeys[handle], handle });
+        dropKeys |= !drawable && (flags & FLAG_COMMITTED);
+
+        flags = drawable ? ((flags | FLAG_COMMITTED) & ~FLAG_CHANGED) : (flags & ~(FLAG_COMMITTED | FLAG_CHANGED));
+    }
+
+    if (dropKeys)
+    {
+        const auto isDropped = [this](const SortKey& sortKey) { return !(m_vFlags[sortKey.m_uDrawIdx] & FLAG_COMMITTED); };
+        m_vKeys.erase(std::remove_if(m_vKeys.begin(), m_vKeys.end(), isDropped), m_vKeys.end());
+        m_vPendingKeys.erase(std::remove_if(m_vPendingKeys.begin(), m_vPendingKeys.end(), isDropped), m_vPendingKeys.end());
+    }
+
+    // No key refers to a removed slot anymore
+    for (const Handle handle : m_vChangedSlots)
+    {
+        if (!(m_vFlags[handle] & FLAG_ALIVE))
+            m_vFreeSlots.push_back(handle);
+    }
+    m_vChangedSlots.clear();
+
+    if (!m_vPendingKeys.empty())
+    {
+        radixSort(m_vPendingKeys, m_vScratch);
+
+        if (m_vKeys.empty())
+        {
+            m_vKeys.swap(m_vPendingKeys);
+        }
+        else
+        {
+            m_vScratch.resize(m_vKeys.size() + m_vPendingKeys.size());
+            std::merge(m_vKeys.begin(), m_vKeys.end(), m_vPendingKeys.begin(), m_vPendingKeys.end(), m_vScratch.begin(),
+                       [](const SortKey& lhs, const SortKey& rhs) { return lhs.m_uKey < rhs.m_uKey; });
+            m_vKeys.swap(m_vScratch);
+        }
+
+        m_vPendingKeys.clear();
+    }
+}
+
+void DrawList::render(CommandRecorder& recorder, uint32_t begin, uint32_t end) const
+{
+    assert(begin <= end && end <= size());
+
+    constexpr uint64_t PIPELINE_STATE_MASK = ~0ull << PIPELINE_SHIFT;
+    constexpr uint64_t MATERIAL_STATE_MASK = ~0ull << MATERIAL_SHIFT;
+
+    // Invalid key prefixes, so the first draw of the range always binds its state
+    uint64_t boundPipelineState = ~0ull;
+    uint64_t boundMaterialState = ~0ull;
+
+    uint32_t runEnd;
+    for (uint32_t i = begin; i < end; i = runEnd)
+    {
+        const SortKey& sortKey = m_vKeys[i];
+
+        // Equal instancing keys mean the same state and primitive, without instancing every draw is its own run
+        runEnd = i + 1u;
+        if (m_bInstancing)
+        {
+            while (runEnd < end && m_vKeys[runEnd].m_uKey == sortKey.m_uKey)
+                ++runEnd;
+        }
+
+        const uint32_t instanceCount = runEnd - i;
+
+        if ((sortKey.m_uKey & PIPELINE_STATE_MASK) != boundPipelineState)
+        {
+            boundPipelineState = sortKey.m_uKey & PIPELINE_STATE_MASK;
+            boundMaterialState = ~0ull;
+
+            const PipelineType pipelineType = static_cast<PipelineType>(getPipeline(sortKey.m_uKey));
+            recorder.bindPipeline(PipelineManager::resolvePipeline(m_pPipelineManager, pipelineType));
+        }
+
+        if ((sortKey.m_uKey & MATERIAL_STATE_MASK) != boundMaterialState)
+        {
+            boundMaterialState = sortKey.m_uKey & MATERIAL_STATE_MASK;
+
+            // bind mat
+        }
+
+        uint32_t firstInstance;
+        glm::mat4* instances = recorder.allocateInstances(instanceCount, firstInstance);
+        assert(instances != nullptr && "Per-frame instance buffer is full!");
+        if (instances == nullptr)
+            continue;
+
+        for (uint32_t j = i; j < runEnd; ++j)
+            *instances++ = m_vTransforms[m_vKeys[j].m_uDrawIdx];
+
+        m_vRenderables[sortKey.m_uDrawIdx].render(recorder, instanceCount, firstInstance);
+    }
+}
@@ -0,0 +1,169 @@
+#ifndef DRAW_LIST_HPP
+#define DRAW_LIST_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+#include <glm/mat4x4.hpp>
+
+#include "Types.hpp"
+#include "Renderable.hpp"
+#include "PipelineManager.hpp"
+#include "CommandRecorder.hpp"
+
+/**
+ * Flat alternative to the RenderManager -> SortBin -> PipelineBin hash map hierarchy.
+ *
+ * Every submission is packed into one 64-bit sort key plus an index into a flat renderable array:
+ *
+ *   [63..60] sort bin | [59..52] pipeline | [51..32] material | [31..0] depth
+ *
+ * The keys are radix sorted once per frame and walked linearly, so the draw order is deterministic
+ * and every pipeline/material change is issued exactly once per run of equal key prefixes.
+ *
+ * With instancing enabled the low 32 bits hold the renderable's primitive id instead of the depth. Runs of
+ * equal keys then draw the same primitive with the same state and are emitted as one instanced draw whose
+ * model matrices are gathered into the per-frame instance buffer.
+ *
+ * Entries are retained: addRenderable() returns a handle that stays valid until remove(), transform and
+ * visibility changes only touch that entry's slot. The committed keys hold only the drawable entries: sort()
+ * drops the keys of entries hidden or removed since the previous call, radix sorts the keys of the ones added
+ * or shown and merges them in. Hidden entries cost nothing per frame, sort() and render() scale with the drawn
+ * entries and the changes. Immediate-mode users call reset() every frame instead, ideally on a list constructed
+ * from the frame's FrameArena.
+ */
+class DrawList
+{
+public:
+    struct SortKey
+    {
+        uint64_t m_uKey;
+        uint32_t m_uDrawIdx;
+    };
+
+    static constexpr uint32_t DEPTH_BITS    = 32u;
+    static constexpr uint32_t MATERIAL_BITS = 20u;
+    static constexpr uint32_t PIPELINE_BITS = 8u;
+    static constexpr uint32_t SORT_BIN_BITS = 4u;
+
+    static constexpr uint32_t MATERIAL_SHIFT = DEPTH_BITS;
+    static constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+    static constexpr uint32_t SORT_BIN_SHIFT = PIPELINE_SHIFT + PIPELINE_BITS;
+
+    static_assert(SORT_BIN_SHIFT + SORT_BIN_BITS == 64u, "Sort key fields must fill exactly 64 bits");
+
+    static void initialize(PipelineManager* pipelineManager)
+    {
+        m_pPipelineManager = pipelineManager;
+    }
+
+    // Every array of the list is allocated from resource
+    explicit DrawList(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_vKeys{resource}, m_vPendingKeys{resource}, m_vScratch{resource}
+        , m_vRenderables{resource}, m_vTransforms{resource}, m_vSlotKeys{resource}, m_vFlags{resource}
+        , m_vChangedSlots{resource}, m_vFreeSlots{resource}
+    {
+    }
+
+    // Sizes the arrays for count entries up front, avoids the regrowth garbage in a bump allocated list
+    void reserve(uint32_t count);
+
+    static uint64_t makeKey(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, float depth);
+    static uint64_t makeInstancingKey(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, uint32_t primitive);
+
+    static uint32_t getSortBin(uint64_t key) { return static_cast<uint32_t>(key >> SORT_BIN_SHIFT); }
+    static uint32_t getPipeline(uint64_t key) { return static_cast<uint32_t>(key >> PIPELINE_SHIFT) & ((1u << PIPELINE_BITS) - 1u); }
+    static uint32_t getMaterial(uint64_t key) { return static_cast<uint32_t>(key >> MATERIAL_SHIFT) & ((1u << MATERIAL_BITS) - 1u); }
+
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = ~0u;
+
+    // Trades the front-to-back depth order for grouping identical primitives, takes effect from the next addRenderable()
+    void setInstancing(bool instancing) { m_bInstancing = instancing; }
+    bool getInstancing() const { return m_bInstancing; }
+
+    // The key is computed once here, entries stay in the list until remove() or reset()
+    Handle addRenderable(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, const Renderable& renderable, const glm::mat4& transform, float depth = 0.0f);
+
+    void remove(Handle handle);
+
+    void setTransform(Handle handle, const glm::mat4& transform)
+    {
+        assert(isAlive(handle));
+        m_vTransforms[handle] = transform;
+    }
+
+    void setVisible(Handle handle, bool visible)
+    {
+        assert(isAlive(handle));
+        m_vFlags[handle] = visible ? (m_vFlags[handle] | FLAG_VISIBLE) : (m_vFlags[handle] & ~FLAG_VISIBLE);
+        markChanged(handle);
+    }
+
+    bool isAlive(Handle handle) const { return handle < m_vFlags.size() && (m_vFlags[handle] & FLAG_ALIVE); }
+
+    // Commits the changes since the last call, must run before render() whenever anything was added, removed,
+    // shown or hidden
+    void sort();
+
+    void render(CommandRecorder& recorder) const { render(recorder, 0u, size()); }
+    void render(CommandRecorder& recorder, uint32_t begin, uint32_t end) const;
+
+    void reset()
+    {
+        m_vKeys.clear();
+        m_vPendingKeys.clear();
+        m_vRenderables.clear();
+        m_vTransforms.clear();
+        m_vSlotKeys.clear();
+        m_vFlags.clear();
+        m_vChangedSlots.clear();
+        m_vFreeSlots.clear();
+    }
+
+    // Committed keys, every one of them is drawn
+    uint32_t size() const { return static_cast<uint32_t>(m_vKeys.size()); }
+    const std::pmr::vector<SortKey>& getKeys() const { return m_vKeys; }
+
+private:
+    enum : uint8_t
+    {
+        FLAG_ALIVE     = 1u << 0,
+        FLAG_VISIBLE   = 1u << 1,
+        FLAG_COMMITTED = 1u << 2, // the slot's key is in m_vKeys or m_vPendingKeys
+        FLAG_CHANGED   = 1u << 3  // the slot is in m_vChangedSlots
+    };
+
+    static PipelineManager* m_pPipelineManager;
+
+    static void radixSort(std::pmr::vector<SortKey>& keys, std::pmr::vector<SortKey>& scratch);
+
+    void markChanged(Handle handle)
+    {
+        if (!(m_vFlags[handle] & FLAG_CHANGED))
+        {
+            m_vFlags[handle] |= FLAG_CHANGED;
+            m_vChangedSlots.push_back(handle);
+        }
+    }
+
+    // All arrays share one memory resource, swapping between them is only valid because of that
+    std::pmr::vector<SortKey> m_vKeys;        // committed, sorted, alive and visible entries only
+    std::pmr::vector<SortKey> m_vPendingKeys; // added or shown since the last sort(), unsorted
+    std::pmr::vector<SortKey> m_vScratch;     // ping-pong storage for the radix passes and the merge
+
+    // Per slot, a Handle is a slot index. Slots of removed entries are reused after the next sort().
+    std::pmr::vector<Renderable> m_vRenderables;
+    std::pmr::vector<glm::mat4> m_vTransforms;
+    std::pmr::vector<uint64_t> m_vSlotKeys;
+    std::pmr::vector<uint8_t> m_vFlags;
+    std::pmr::vector<Handle> m_vChangedSlots; // removed, shown or hidden since the last sort()
+    std::pmr::vector<Handle> m_vFreeSlots;
+
+    bool m_bInstancing = true;
+};
+
+#endif // DRAW_LIST_HPP
@@ -0,0 +1,122 @@
+#include "GeometryPool.hpp"
+#include "GeometryTable.hpp"
+
+#include <cassert>
+
+StaticBuffer GeometryPool::m_VertexBuffer;
+StaticBuffer GeometryPool::m_IndexBuffer;
+uint32_t GeometryPool::m_uVertexStride = 0u;
+uint32_t GeometryPool::m_uShortGeometry = 0u;
+uint32_t GeometryPool::m_uGeometry = 0u;
+
+std::mutex GeometryPool::m_Mutex;
+OffsetAllocator GeometryPool::m_VertexAllocator;
+OffsetAllocator GeometryPool::m_IndexAllocator;
+
+void GeometryPool::create(VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity, uint32_t vertexStride)
+{
+    assert(vertexStride > 0u && vertexCapacity / vertexStride <= INT32_MAX && indexCapacity / INDEX_WORD_SIZE < UINT32_MAX);
+
+    m_uVertexStride = vertexStride;
+    vertexCapacity = vertexCapacity / vertexStride * vertexStride;
+    indexCapacity = indexCapacity / INDEX_WORD_SIZE * INDEX_WORD_SIZE;
+
+    const VkBufferCreateInfo vertexBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = vertexCapacity,
+        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    const VkBufferCreateInfo indexBufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = indexCapacity,
+        .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    m_VertexBuffer.create(vertexBufferCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_IndexBuffer.create(indexBufferCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    m_uShortGeometry = GeometryTable::add(m_IndexBuffer.getBuffer(), m_VertexBuffer.getBuffer(), VK_INDEX_TYPE_UINT16);
+    m_uGeometry = GeometryTable::add(m_IndexBuffer.getBuffer(), m_VertexBuffer.getBuffer(), VK_INDEX_TYPE_UINT32);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_VertexAllocator.reset(static_cast<uint32_t>(vertexCapacity / vertexStride));
+    m_IndexAllocator.reset(static_cast<uint32_t>(indexCapacity / INDEX_WORD_SIZE));
+}
+
+void GeometryPool::destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    assert(m_VertexAllocator.getAllocationCount() == 0u && "Destroying the geometry pool while prototypes still use it!");
+
+    m_VertexBuffer.destroy();
+    m_IndexBuffer.destroy();
+    m_VertexAllocator.reset(0u);
+    m_IndexAllocator.reset(0u);
+}
+
+bool GeometryPool::allocate(VkDeviceSize vertexBytes, VkDeviceSize indexBytes, VkIndexType indexType, Allocation& allocation)
+{
+    assert(vertexBytes % m_uVertexStride == 0u && "Vertices of another stride than the pool's!");
+
+    const VkDeviceSize vertexCount = vertexBytes / m_uVertexStride;
+    const VkDeviceSize indexWords = (indexBytes + INDEX_WORD_SIZE - 1u) / INDEX_WORD_SIZE;
+    if (vertexCount > UINT32_MAX || indexWords > UINT32_MAX)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const uint32_t vertexBlock = m_VertexAllocator.allocate(static_cast<uint32_t>(vertexCount));
+    if (vertexBlock == OffsetAllocator::INVALID_OFFSET)
+        return false;
+
+    const uint32_t indexBlock = m_IndexAllocator.allocate(static_cast<uint32_t>(indexWords));
+    if (indexBlock == OffsetAllocator::INVALID_OFFSET)
+    {
+        m_VertexAllocator.free(vertexBlock);
+        return false;
+    }
+
+    const bool shortIndices = indexType == VK_INDEX_TYPE_UINT16;
+    allocation.m_uVertexBlock = vertexBlock;
+    allocation.m_uIndexBlock = indexBlock;
+    allocation.m_uGeometry = shortIndices ? m_uShortGeometry : m_uGeometry;
+    allocation.m_iVertexOffset = static_cast<int32_t>(vertexBlock);
+    allocation.m_uFirstIndex = shortIndices ? indexBlock * 2u : indexBlock;
+    return true;
+}
+
+void GeometryPool::free(Allocation& allocation)
+{
+    if (!allocation.isValid())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_VertexAllocator.free(allocation.m_uVertexBlock);
+    m_IndexAllocator.free(allocation.m_uIndexBlock);
+    allocation = {};
+}
+
+void GeometryPool::upload(const Allocation& allocation, const void* vertices, VkDeviceSize vertexBytes, const void* indices, VkDeviceSize indexBytes)
+{
+    assert(allocation.isValid());
+
+    if (vertexBytes > 0u)
+        m_VertexBuffer.uploadData(vertexBytes, vertices, static_cast<VkDeviceSize>(allocation.m_uVertexBlock) * m_uVertexStride);
+    if (indexBytes > 0u)
+        m_IndexBuffer.uploadData(indexBytes, indices, static_cast<VkDeviceSize>(allocation.m_uIndexBlock) * INDEX_WORD_SIZE);
+}
+
+VkDeviceSize GeometryPool::getVertexBytesFree()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<VkDeviceSize>(m_VertexAllocator.getFreeSize()) * m_uVertexStride;
+}
+
+VkDeviceSize GeometryPool::getIndexBytesFree()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<VkDeviceSize>(m_IndexAllocator.getFreeSize()) * INDEX_WORD_SIZE;
+}
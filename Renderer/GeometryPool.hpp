@@ -0,0 +1,65 @@
+#ifndef GEOMETRY_POOL_HPP
+#define GEOMETRY_POOL_HPP
+
+#include <cstdint>
+#include <mutex>
+
+#include <vulkan/vulkan.h>
+
+#include "../Buffer.hpp"
+#include "../OffsetAllocator.hpp"
+
+/**
+ * One device-local vertex buffer and one index buffer that every prototype's geometry is sub-allocated from,
+ * so the whole scene draws with a single vertex bind and one index bind per index type, and the number of
+ * device memory allocations does not grow with the number of assets.
+ *
+ * Vertices are allocated in whole vertices of the pool's stride, indices in 4 byte words, so 16 and 32 bit
+ * ranges share the index buffer. The pool registers one GeometryTable entry per index type over the two
+ * buffers; an allocation's offsets are what its renderables add to their vertexOffset and firstIndex.
+ *
+ * The capacity is fixed at create(). allocate() and free() may be called from the upload thread and the main
+ * thread at once, free() expects the GPU to be done with the range, like destroying a StaticBuffer does.
+ */
+class GeometryPool
+{
+public:
+    struct Allocation
+    {
+        uint32_t m_uVertexBlock = OffsetAllocator::INVALID_OFFSET; // in vertices
+        uint32_t m_uIndexBlock = OffsetAllocator::INVALID_OFFSET;  // in 4 byte words
+
+        uint32_t m_uGeometry = 0u; // GeometryTable handle of the pool for the allocation's index type
+        int32_t m_iVertexOffset = 0;
+        uint32_t m_uFirstIndex = 0u; // in indices of the allocation's type
+
+        bool isValid() const { return m_uVertexBlock != OffsetAllocator::INVALID_OFFSET; }
+    };
+
+    static void create(VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity, uint32_t vertexStride);
+    static void destroy();
+
+    // False when either buffer has no free range large enough
+    static bool allocate(VkDeviceSize vertexBytes, VkDeviceSize indexBytes, VkIndexType indexType, Allocation& allocation);
+    static void free(Allocation& allocation);
+
+    static void upload(const Allocation& allocation, const void* vertices, VkDeviceSize vertexBytes, const void* indices, VkDeviceSize indexBytes);
+
+    static VkDeviceSize getVertexBytesFree();
+    static VkDeviceSize getIndexBytesFree();
+
+private:
+    static constexpr VkDeviceSize INDEX_WORD_SIZE = sizeof(uint32_t);
+
+    static StaticBuffer m_VertexBuffer;
+    static StaticBuffer m_IndexBuffer;
+    static uint32_t m_uVertexStride;
+    static uint32_t m_uShortGeometry; // GeometryTable handles of the buffers with VK_INDEX_TYPE_UINT16
+    static uint32_t m_uGeometry;      // and VK_INDEX_TYPE_UINT32
+
+    static std::mutex m_Mutex;
+    static OffsetAllocator m_VertexAllocator;
+    static OffsetAllocator m_IndexAllocator;
+};
+
+#endif // GEOMETRY_POOL_HPP
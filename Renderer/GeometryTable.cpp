@@ -0,0 +1,9 @@
+#include "GeometryTable.hpp"
+
+std::vector<GeometryTable::Geometry> GeometryTable::m_vGeometries;
+
+uint32_t GeometryTable::add(VkBuffer indexBuffer, VkBuffer vertexBuffer, VkIndexType indexType)
+{
+    m_vGeometries.push_back({ indexBuffer, vertexBuffer, indexType });
+    return static_cast<uint32_t>(m_vGeometries.size() - 1u);
+}
@@ -0,0 +1,41 @@
+#ifndef GEOMETRY_TABLE_HPP
+#define GEOMETRY_TABLE_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+/**
+ * Maps the small integer handles stored in Renderable to the index/vertex buffers they draw from, so draw
+ * records stay trivially copyable and never point at the StaticBuffers owned by a ModelPrototype.
+ * Handles are stable for the lifetime of the table, geometry is registered once at load time.
+ */
+class GeometryTable
+{
+public:
+    struct Geometry
+    {
+        VkBuffer m_VkIndexBuffer;
+        VkBuffer m_VkVertexBuffer;
+        VkIndexType m_eIndexType;
+    };
+
+    static uint32_t add(VkBuffer indexBuffer, VkBuffer vertexBuffer, VkIndexType indexType);
+
+    static const Geometry& get(uint32_t handle)
+    {
+        assert(handle < m_vGeometries.size() && "Invalid geometry handle!");
+        return m_vGeometries[handle];
+    }
+
+    static uint32_t size() { return static_cast<uint32_t>(m_vGeometries.size()); }
+
+    static void clear() { m_vGeometries.clear(); }
+
+private:
+    static std::vector<Geometry> m_vGeometries;
+};
+
+#endif // GEOMETRY_TABLE_HPP
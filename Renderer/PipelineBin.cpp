@@ -1,21 +1,119 @@
+#include <cassert>
+#include <cstring>
 #include <iostream>
 
 #include "PipelineBin.hpp"
+#include "../Buffer.hpp"
 
 PipelineManager* PipelineBin::m_pPipelineManager = nullptr;
 
-void PipelineBin::render(VkCommandBuffer commandBuffer) const
+void PipelineBin::render(CommandRecorder& recorder) const
 {
     // bind pipeline
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pPipelineManager->getPipeline(m_eType));
+    recorder.bindPipeline(PipelineManager::resolvePipeline(m_pPipelineManager, m_eType));
 
-    for (const auto& [matId, renderables] : m_vRenderables)
+    for (const auto& [matId, materialBin] : *m_vRenderables)
     {
         // bind mat
 
-        for (const Renderable& renderable : renderables)
+        for (const InstanceGroup& group : materialBin.m_vGroups)
         {
-            renderable.render(commandBuffer);
+            const uint32_t instanceCount = static_cast<uint32_t>(group.m_vTransforms.size());
+
+            uint32_t firstInstance;
+            glm::mat4* instances = recorder.allocateInstances(instanceCount, firstInstance);
+            assert(instances != nullptr && "Per-frame instance buffer is full!");
+            if (instances == nullptr)
+                continue;
+
+            memcpy(instances, group.m_vTransforms.data(), instanceCount * sizeof(glm::mat4));
+            group.m_Renderable.render(recorder, instanceCount, firstInstance);
+        }
+    }
+}
+
+/**
+ * Writes one VkDrawIndexedIndirectCommand per instance group into the recorder's per-frame indirect buffer and
+ * issues a single indirect call per run of groups that share a material and index/vertex buffers.
+ * With VK_KHR_draw_indirect_count the draw count is read from the buffer as well, so a later GPU pass can
+ * shrink it in place. Runs that no longer fit into the indirect buffer fall back to direct draws, as does the
+ * whole bin when indirect commands cannot carry a firstInstance.
+ */
+void PipelineBin::renderIndirect(CommandRecorder& recorder) const
+{
+    LinearBuffer* indirectBuffer = recorder.getIndirectBuffer();
+    if (indirectBuffer == nullptr || !CommandRecorder::supportsDrawIndirectFirstInstance())
+    {
+        render(recorder);
+        return;
+    }
+
+    const bool useDrawCount = CommandRecorder::supportsDrawIndirectCount();
+
+    recorder.bindPipeline(PipelineManager::resolvePipeline(m_pPipelineManager, m_eType));
+
+    for (const auto& [matId, materialBin] : *m_vRenderables)
+    {
+        // bind mat
+
+        const std::pmr::vector<InstanceGroup>& groups = materialBin.m_vGroups;
+
+        size_t runBegin = 0;
+        while (runBegin < groups.size())
+        {
+            size_t runEnd = runBegin + 1;
+            while (runEnd < groups.size() && groups[runEnd].m_Renderable.sharesBuffers(groups[runBegin].m_Renderable))
+                ++runEnd;
+
+            const uint32_t drawCount = static_cast<uint32_t>(runEnd - runBegin);
+            const VkDeviceSize nbytes = drawCount * sizeof(VkDrawIndexedIndirectCommand);
+
+            // The count lives in the same allocation, right after the commands
+            const LinearBuffer::Allocation allocation = indirectBuffer->allocate(nbytes + (useDrawCount ? sizeof(uint32_t) : 0u), alignof(VkDrawIndexedIndirectCommand));
+
+            groups[runBegin].m_Renderable.bindBuffers(recorder);
+
+            VkDrawIndexedIndirectCommand* commands = static_cast<VkDrawIndexedIndirectCommand*>(allocation.m_pData);
+
+            for (size_t i = runBegin; i < runEnd; ++i)
+            {
+                const InstanceGroup& group = groups[i];
+                const uint32_t instanceCount = static_cast<uint32_t>(group.m_vTransforms.size());
+
+                uint32_t firstInstance;
+                glm::mat4* instances = recorder.allocateInstances(instanceCount, firstInstance);
+                assert(instances != nullptr && "Per-frame instance buffer is full!");
+
+                // Dropped groups stay in the run as empty draws so the command offsets remain contiguous
+                if (instances == nullptr)
+                {
+                    if (commands != nullptr)
+                        commands[i - runBegin] = group.m_Renderable.getIndirectCommand(0u, 0u);
+                    continue;
+                }
+
+                memcpy(instances, group.m_vTransforms.data(), instanceCount * sizeof(glm::mat4));
+
+                if (commands != nullptr)
+                    commands[i - runBegin] = group.m_Renderable.getIndirectCommand(instanceCount, firstInstance);
+                else
+                    group.m_Renderable.render(recorder, instanceCount, firstInstance);
+            }
+
+            if (commands != nullptr)
+            {
+                if (useDrawCount)
+                {
+                    *reinterpret_cast<uint32_t*>(commands + drawCount) = drawCount;
+                    recorder.drawIndexedIndirectCount(indirectBuffer->getBuffer(), allocation.m_uOffset, indirectBuffer->getBuffer(), allocation.m_uOffset + nbytes, drawCount);
+                }
+                else
+                {
+                    recorder.drawIndexedIndirect(indirectBuffer->getBuffer(), allocation.m_uOffset, drawCount);
+                }
+            }
+
+            runBegin = runEnd;
         }
     }
 }
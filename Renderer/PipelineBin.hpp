@@ -1,22 +1,48 @@
 #ifndef PIPELINE_BIN_HPP
 #define PIPELINE_BIN_HPP
 
+#include <memory_resource>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
 #include <vulkan/vulkan.h>
+#include <glm/mat4x4.hpp>
 
 #include "Types.hpp"
 #include "Renderable.hpp"
 #include "PipelineManager.hpp"
+#include "CommandRecorder.hpp"
 
 class PipelineBin
 {
 private:
     static PipelineManager* m_pPipelineManager;
 
+    // Every submission of the same primitive under one material, drawn as a single instanced draw
+    struct InstanceGroup
+    {
+        Renderable m_Renderable;
+        std::pmr::vector<glm::mat4> m_vTransforms;
+    };
+
+    struct MaterialBin
+    {
+        std::pmr::vector<InstanceGroup> m_vGroups;                       // in first submission order
+        std::pmr::unordered_map<uint32_t, uint32_t> m_PrimitiveToGroup;  // primitive -> index into m_vGroups
+
+        explicit MaterialBin(std::pmr::memory_resource* resource)
+            : m_vGroups{resource}, m_PrimitiveToGroup{resource}
+        {
+        }
+    };
+
+    using MaterialMap = std::pmr::unordered_map<uint32_t, MaterialBin>;
+
     PipelineType m_eType;
-    std::unordered_map<uint32_t, std::vector<Renderable>> m_vRenderables;
+
+    // Rebuilt on every reset() so all of a frame's nodes and arrays come from that frame's arena
+    std::optional<MaterialMap> m_vRenderables { std::in_place };
 
 public:
     static void initialize(PipelineManager* pipelineManager)
@@ -31,20 +57,31 @@ public:
     PipelineBin(PipelineType type)
         : m_eType{type}
     {
-        m_pPipelineManager->createPipeline(type);
+        // No manager when the render queue runs headless
+        if (m_pPipelineManager != nullptr)
+            m_pPipelineManager->createPipeline(type);
     }
 
-    void addRenderable(uint32_t matId, const Renderable &renderable)
+    void addRenderable(uint32_t matId, const Renderable &renderable, const glm::mat4& transform)
     {
-        m_vRenderables[matId].push_back(renderable);
+        std::pmr::memory_resource* resource = m_vRenderables->get_allocator().resource();
+        MaterialBin& materialBin = m_vRenderables->try_emplace(matId, resource).first->second;
+
+        const auto [iter, inserted] = materialBin.m_PrimitiveToGroup.try_emplace(renderable.primitive, static_cast<uint32_t>(materialBin.m_vGroups.size()));
+        if (inserted)
+            materialBin.m_vGroups.push_back({ renderable, std::pmr::vector<glm::mat4>{resource} });
+
+        materialBin.m_vGroups[iter->second].m_vTransforms.push_back(transform);
     }
 
-    void reset()
+    // Drops every submission, the following ones are allocated from resource (a FrameArena during a frame)
+    void reset(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
     {
-        m_vRenderables.clear();
+        m_vRenderables.emplace(resource);
     }
 
-    void render(VkCommandBuffer commandBuffer) const;
+    void render(CommandRecorder& recorder) const;
+    void renderIndirect(CommandRecorder& recorder) const;
 
     bool operator==(const PipelineBin &rhs) const { return m_eType == rhs.m_eType; }
 };
@@ -2,6 +2,7 @@
 
 #include "Defines.hpp"
 #include "PipelineManager.hpp"
+#include "VertexLayout.hpp"
 
 namespace
 {
@@ -115,22 +116,38 @@ namespace Default
                                                                                             .pName = "main",
                                                                                             .pSpecializationInfo = nullptr}}};
 
-        const std::array<VkVertexInputBindingDescription, 1> vertexInputBindingDescription{{{.binding = 0,
-                                                                                            .stride = sizeof(float) * 3,
-                                                                                            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX}}};
-
-        const std::array<VkVertexInputAttributeDescription, 1> vertexInputAttributeDescription{{
-            {.location = 0,
-            .binding = 0,
-            .format = VK_FORMAT_R32G32B32_SFLOAT,
+        // Binding 0 is laid out as MESH_VERTEX_LAYOUT says, binding 1 holds one model matrix per instance,
+        // a mat4 input takes four consecutive locations
+        const std::array<VkVertexInputBindingDescription, 2> vertexInputBindingDescription{{MESH_VERTEX_LAYOUT.getBindingDescription(0u),
+                                                                                            {.binding = 1,
+                                                                                            .stride = sizeof(float) * 16,
+                                                                                            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE}}};
+
+        std::array<VkVertexInputAttributeDescription, 4 + VertexLayout::MAX_ATTRIBUTE_COUNT> vertexInputAttributeDescription{{
+            {.location = 1,
+            .binding = 1,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
             .offset = 0},
+            {.location = 2,
+            .binding = 1,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = sizeof(float) * 4},
+            {.location = 3,
+            .binding = 1,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = sizeof(float) * 8},
+            {.location = 4,
+            .binding = 1,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = sizeof(float) * 12},
         }};
+        const uint32_t vertexInputAttributeCount = 4u + MESH_VERTEX_LAYOUT.getAttributeDescriptions(0u, vertexInputAttributeDescription.data() + 4);
 
         const VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
             .vertexBindingDescriptionCount = vertexInputBindingDescription.size(),
             .pVertexBindingDescriptions = vertexInputBindingDescription.data(),
-            .vertexAttributeDescriptionCount = vertexInputAttributeDescription.size(),
+            .vertexAttributeDescriptionCount = vertexInputAttributeCount,
             .pVertexAttributeDescriptions = vertexInputAttributeDescription.data()};
 
         const VkViewport viewport{
@@ -2,6 +2,7 @@
 #define PIPELINE_MANAGER_HPP
 
 #include <array>
+#include <cstdint>
 
 #include <vulkan/vulkan.h>
 
@@ -41,6 +42,13 @@ public:
         return m_vPipelines[type].m_VkPipeline;
     }
 
+    // Without a manager (headless benchmarks) every type maps to a distinct placeholder handle, so the command
+    // recorder still sees each pipeline change while nothing is ever created
+    static VkPipeline resolvePipeline(PipelineManager* manager, PipelineType type)
+    {
+        return manager != nullptr ? manager->getPipeline(type) : (VkPipeline)(uintptr_t)(type + 1u);
+    }
+
     void createPipeline(PipelineType type);
     void destroy();
 };
@@ -1,19 +1,38 @@
 #ifndef RENDER_MANAGER_HPP
 #define RENDER_MANAGER_HPP
 
+#include <memory_resource>
+#include <optional>
 #include <unordered_map>
 
 #include "Types.hpp"
 #include "SortBin.hpp"
 #include "PipelineBin.hpp"
+#include "DrawList.hpp"
 
 class RenderManager
 {
 private:
+    RenderMode m_eMode = RenderMode::BINNED;
+
     std::unordered_map<SortBinType, SortBin> m_vSortBins;
+
+    // Re-created from the frame's arena in beginFrame() unless the mode is RETAINED
+    std::optional<DrawList> m_DrawList { std::in_place };
+    bool m_bInstancing = true;
+    uint32_t m_uLastFrameDrawCount = 0u;
 public:
     RenderManager() = default;
 
+    void setMode(RenderMode mode)
+    {
+        reset();
+        m_eMode = mode;
+    }
+
+    RenderMode getMode() const { return m_eMode; }
+
+    // Sort bins are still registered in SORTED mode, they own the creation of their pipelines
     void addSortBin(SortBinType type, std::vector<PipelineType> pipelines)
     {
         m_vSortBins.emplace(std::make_pair(type, type));
@@ -22,24 +41,104 @@ public:
             m_vSortBins[type].addPipeline(pipeline);
     }
 
-    void addRenderable(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, Renderable renderable)
+    // Submissions of the same renderable primitive under the same pipeline/material are drawn instanced
+    void addRenderable(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, const Renderable& renderable, const glm::mat4& transform, float depth = 0.0f)
+    {
+        assert(m_eMode != RenderMode::RETAINED && "Use addPersistentRenderable() in RETAINED mode");
+
+        if (m_eMode == RenderMode::SORTED)
+            m_DrawList->addRenderable(sortBinType, pipelineType, matId, renderable, transform, depth);
+        else
+            m_vSortBins[sortBinType].addRenderable(pipelineType, matId, renderable, transform);
+    }
+
+    // RETAINED mode: the renderable is drawn every frame until it is removed, only changes need to be submitted
+    DrawList::Handle addPersistentRenderable(SortBinType sortBinType, PipelineType pipelineType, uint32_t matId, const Renderable& renderable, const glm::mat4& transform, float depth = 0.0f)
+    {
+        assert(m_eMode == RenderMode::RETAINED && "Persistent renderables require RETAINED mode");
+        return m_DrawList->addRenderable(sortBinType, pipelineType, matId, renderable, transform, depth);
+    }
+
+    void removeRenderable(DrawList::Handle handle) { m_DrawList->remove(handle); }
+    void setTransform(DrawList::Handle handle, const glm::mat4& transform) { m_DrawList->setTransform(handle, transform); }
+    void setVisible(DrawList::Handle handle, bool visible) { m_DrawList->setVisible(handle, visible); }
+
+    // SORTED/RETAINED only, the binned modes always instance
+    void setInstancing(bool instancing)
+    {
+        m_bInstancing = instancing;
+        m_DrawList->setInstancing(instancing);
+    }
+
+    bool usesDrawList() const { return m_eMode == RenderMode::SORTED || m_eMode == RenderMode::RETAINED; }
+
+    // Must be called once per frame after all renderables are added and before render()
+    void sort()
     {
-        m_vSortBins[sortBinType].addRenderable(pipelineType, matId, renderable); 
+        if (usesDrawList())
+            m_DrawList->sort();
     }
 
-    void render(VkCommandBuffer commandBuffer) const
+    void render(CommandRecorder& recorder) const
     {
+        if (usesDrawList())
+        {
+            m_DrawList->render(recorder);
+            return;
+        }
+
         for (const auto& [type, bin] : m_vSortBins)
         {
-            bin.render(commandBuffer);
+            if (m_eMode == RenderMode::INDIRECT)
+                bin.renderIndirect(recorder);
+            else
+                bin.render(recorder);
         }
     }
 
+    // Draw range recording is only supported by the flat draw list (SORTED/RETAINED mode)
+    void render(CommandRecorder& recorder, uint32_t begin, uint32_t end) const
+    {
+        assert(usesDrawList() && "Only the sorted draw list can be recorded in ranges");
+        m_DrawList->render(recorder, begin, end);
+    }
+
+    uint32_t getDrawCount() const { return m_DrawList->size(); }
+
+    // Called before the frame's submissions, once frameResource is safe to reuse (its frame's fence signaled).
+    // Immediate mode submissions of the frame are allocated from it, retained ones stay on the heap.
+    void beginFrame(std::pmr::memory_resource* frameResource)
+    {
+        if (m_eMode == RenderMode::RETAINED)
+            return;
+
+        m_DrawList.emplace(frameResource);
+        m_DrawList->setInstancing(m_bInstancing);
+        m_DrawList->reserve(m_uLastFrameDrawCount);
+
+        for (auto& [type, bin] : m_vSortBins)
+            bin.reset(frameResource);
+    }
+
+    // Called after every frame, drops the immediate mode submissions and keeps the retained ones
+    void endFrame()
+    {
+        if (m_eMode == RenderMode::RETAINED)
+            return;
+
+        m_uLastFrameDrawCount = m_DrawList->size();
+        reset();
+    }
+
+    // Drops every submission and detaches from any frame arena
     void reset()
     {
+        m_DrawList.emplace();
+        m_DrawList->setInstancing(m_bInstancing);
+
         for (auto& [type, bin] : m_vSortBins)
             bin.reset();
     }
 };
 
-#endif // RENDER_MANAGER_HPP
\ No newline at end of file
+#endif // RENDER_MANAGER_HPP
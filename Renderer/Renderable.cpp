@@ -1,13 +1,21 @@
 #include "Renderable.hpp"
+#include "GeometryTable.hpp"
 
 #include <iostream>
 
-void Renderable::render(VkCommandBuffer commandBuffer) const
+void Renderable::bindBuffers(CommandRecorder& recorder) const
+{
+    const GeometryTable::Geometry& geo = GeometryTable::get(geometry);
+
+    // Consecutive renderables of the same prototype share these buffers, the recorder drops the repeats
+    recorder.bindIndexBuffer(geo.m_VkIndexBuffer, 0u, geo.m_eIndexType);
+    recorder.bindVertexBuffer(0u, geo.m_VkVertexBuffer, 0u);
+}
+
+void Renderable::render(CommandRecorder& recorder, uint32_t instanceCount, uint32_t firstInstance) const
 {
     // bind obj data
 
-    static VkDeviceSize pOffsets = 0;
-    vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer.getBuffer(), 0u, VK_INDEX_TYPE_UINT32);
-    vkCmdBindVertexBuffers(commandBuffer, 0u, 1u, m_VertexBuffer.getBufferPointer(), &pOffsets);
-    vkCmdDrawIndexed(commandBuffer, indexCount, 1u, 0u, vertexOffset, 0u);
+    bindBuffers(recorder);
+    recorder.drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 }
\ No newline at end of file
@@ -1,30 +1,38 @@
 #ifndef RENDERABLE_HPP
 #define RENDERABLE_HPP
 
+#include <cstdint>
+#include <type_traits>
+
 #include <vulkan/vulkan.h>
 
-#include "../Buffer.hpp"
+#include "CommandRecorder.hpp"
 
+// Draw record, copied into the render queue every frame. Buffers are referenced through a GeometryTable handle
+// so the record stays small, trivially copyable and assignable (memcpy, sort and partition friendly).
 struct Renderable {
-    const StaticBuffer& m_IndexBuffer; // also stores index count
-    const StaticBuffer& m_VertexBuffer;
-
     VkDescriptorSet descriptorSet; // per draw data
 
+    uint32_t geometry;  // GeometryTable handle, index/vertex buffers and index type
+    uint32_t primitive; // unique per prototype primitive, renderables with equal ids can be instanced together
+
     uint32_t indexCount;
-    uint32_t instanceCount;
     uint32_t firstIndex;
     int32_t vertexOffset;
-    uint32_t firstInstance;
 
-    Renderable(const StaticBuffer& indexBuffer, const StaticBuffer& vertexBuffer)
-        : m_IndexBuffer { indexBuffer }
-        , m_VertexBuffer { vertexBuffer }
-    {}
+    // Renderables sharing buffers can be drawn from one indirect call
+    bool sharesBuffers(const Renderable& rhs) const { return geometry == rhs.geometry; }
 
-    void render(VkCommandBuffer commandBuffer) const;
-};
+    VkDrawIndexedIndirectCommand getIndirectCommand(uint32_t instanceCount = 1u, uint32_t firstInstance = 0u) const
+    {
+        return { indexCount, instanceCount, firstIndex, vertexOffset, firstInstance };
+    }
 
+    void bindBuffers(CommandRecorder& recorder) const;
+    void render(CommandRecorder& recorder, uint32_t instanceCount = 1u, uint32_t firstInstance = 0u) const;
+};
 
+static_assert(std::is_trivially_copyable_v<Renderable>, "Renderable must stay memcpy-able");
+static_assert(sizeof(Renderable) <= 32u, "Renderable should fit two per cache line");
 
-#endif // RENDERABLE_HPP
\ No newline at end of file
+#endif // RENDERABLE_HPP
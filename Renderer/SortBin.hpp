@@ -23,21 +23,27 @@ public:
 
     void addPipeline(PipelineType type);
 
-    void addRenderable(PipelineType type, uint32_t materialId, Renderable& renderable)
+    void addRenderable(PipelineType type, uint32_t materialId, const Renderable& renderable, const glm::mat4& transform)
     {
-        m_Pipelines[type].addRenderable(materialId, renderable);
+        m_Pipelines[type].addRenderable(materialId, renderable, transform);
     }
 
-    void render(VkCommandBuffer commandBuffer) const
+    void render(CommandRecorder& recorder) const
     {
         for (const auto& [type, bin] : m_Pipelines)
-            bin.render(commandBuffer);
+            bin.render(recorder);
     }
 
-    void reset()
+    void renderIndirect(CommandRecorder& recorder) const
+    {
+        for (const auto& [type, bin] : m_Pipelines)
+            bin.renderIndirect(recorder);
+    }
+
+    void reset(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
     {
         for (auto& [type, bin] : m_Pipelines)
-            bin.reset();
+            bin.reset(resource);
     }
 
     bool operator==(const SortBin& rhs) const { return m_eType == rhs.m_eType; }
@@ -0,0 +1,390 @@
+#include "Defines.hpp"
+#include "TexturePool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "../Buffer.hpp"
+#include "../Hash.hpp"
+
+VkDevice TexturePool::m_VkDevice = VK_NULL_HANDLE;
+VkPhysicalDeviceMemoryProperties TexturePool::m_VkMemoryProperties {};
+VkDeviceSize TexturePool::m_uBlockSize = 0u;
+
+std::mutex TexturePool::m_Mutex;
+std::vector<TexturePool::Block> TexturePool::m_vBlocks;
+std::unordered_map<Hash::Key128, std::weak_ptr<Texture>, Hash::Key128Hasher> TexturePool::m_Textures;
+
+namespace
+{
+    constexpr uint32_t TEXEL_SIZE = 4u; // RGBA8
+
+    uint32_t getMemoryTypeIndex(uint32_t memoryTypeBits, VkMemoryPropertyFlags flags, const VkPhysicalDeviceMemoryProperties& memoryProperties)
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+        {
+            if ((memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+                return i;
+        }
+
+        assert(false && "Could not find suitable memory type!");
+        return 0u;
+    }
+
+    VkImageMemoryBarrier getBarrier(VkImage image, uint32_t baseMip, uint32_t mipCount, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                    VkImageLayout oldLayout, VkImageLayout newLayout)
+    {
+        return VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = srcAccess,
+            .dstAccessMask = dstAccess,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseMip, mipCount, 0u, 1u },
+        };
+    }
+
+    // Level 0 from the staging buffer, then every level blitted from the one before it, which is moved to
+    // TRANSFER_SRC first. Leaves levels [0, mipCount - 1) in TRANSFER_SRC and the last one in TRANSFER_DST.
+    void recordMipChain(VkCommandBuffer commandBuffer, VkBuffer staging, VkDeviceSize stagingOffset, const Texture& texture)
+    {
+        const VkBufferImageCopy copy {
+            .bufferOffset = stagingOffset,
+            .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, 0u, 1u },
+            .imageExtent = { texture.m_uWidth, texture.m_uHeight, 1u },
+        };
+
+        vkCmdCopyBufferToImage(commandBuffer, staging, texture.m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &copy);
+
+        int32_t width = static_cast<int32_t>(texture.m_uWidth);
+        int32_t height = static_cast<int32_t>(texture.m_uHeight);
+
+        for (uint32_t mip = 1u; mip < texture.m_uMipCount; ++mip)
+        {
+            const VkImageMemoryBarrier source = getBarrier(texture.m_VkImage, mip - 1u, 1u, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0x0, 0u, nullptr, 0u, nullptr, 1u, &source);
+
+            const int32_t mipWidth = std::max(width / 2, 1);
+            const int32_t mipHeight = std::max(height / 2, 1);
+
+            const VkImageBlit blit {
+                .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - 1u, 0u, 1u },
+                .srcOffsets = { { 0, 0, 0 }, { width, height, 1 } },
+                .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0u, 1u },
+                .dstOffsets = { { 0, 0, 0 }, { mipWidth, mipHeight, 1 } },
+            };
+
+            // Filtering an SRGB image averages linear values, the chain stays gamma correct
+            vkCmdBlitImage(commandBuffer, texture.m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1u, &blit, VK_FILTER_LINEAR);
+
+            width = mipWidth;
+            height = mipHeight;
+        }
+    }
+}
+
+Texture::~Texture()
+{
+    if (m_VkImage != VK_NULL_HANDLE)
+        TexturePool::release(*this);
+}
+
+void TexturePool::create(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, VkDeviceSize blockSize)
+{
+    assert(blockSize >= PAGE_SIZE && blockSize / PAGE_SIZE < UINT32_MAX);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_VkDevice = device;
+    m_VkMemoryProperties = memoryProperties;
+    m_uBlockSize = blockSize / PAGE_SIZE * PAGE_SIZE;
+}
+
+void TexturePool::destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (Block& block : m_vBlocks)
+    {
+        assert(block.m_Allocator.getAllocationCount() == 0u && "Destroying the texture pool while prototypes still use it!");
+        if (block.m_VkMemory != VK_NULL_HANDLE)
+            vkFreeMemory(m_VkDevice, block.m_VkMemory, nullptr);
+    }
+
+    m_vBlocks.clear();
+    m_Textures.clear();
+}
+
+Hash::Key128 TexturePool::computeContentKey(const Image& image)
+{
+    Hash::Key128 key = Hash::SEED_128;
+    key = Hash::value(key, image.m_uWidth);
+    key = Hash::value(key, image.m_uHeight);
+    key = Hash::value(key, image.m_eFormat);
+    return Hash::bytes(key, image.m_pPixels, static_cast<size_t>(image.m_uWidth) * image.m_uHeight * TEXEL_SIZE);
+}
+
+uint32_t TexturePool::getMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t mipCount = 1u;
+    for (uint32_t size = std::max(width, height); size > 1u; size /= 2u)
+        ++mipCount;
+    return mipCount;
+}
+
+std::vector<std::shared_ptr<Texture>> TexturePool::upload(const std::vector<Image>& images)
+{
+    std::vector<std::shared_ptr<Texture>> textures(images.size());
+    std::vector<uint32_t> created; // images that got a new texture, in staging order
+    VkDeviceSize stagingBytes = 0u;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (uint32_t i = 0; i < images.size(); ++i)
+        {
+            const Image& image = images[i];
+
+            // Textures are registered as soon as they exist, duplicates within the batch find them here too
+            std::weak_ptr<Texture>& live = m_Textures[image.m_ContentKey];
+            if ((textures[i] = live.lock()) != nullptr)
+                continue;
+
+            textures[i] = std::make_shared<Texture>();
+            createTexture(image, *textures[i]);
+
+            live = textures[i];
+            created.push_back(i);
+            stagingBytes += static_cast<VkDeviceSize>(image.m_uWidth) * image.m_uHeight * TEXEL_SIZE;
+        }
+    }
+
+    if (created.empty())
+        return textures;
+
+    const VkBufferCreateInfo stagingCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = stagingBytes,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    StaticBuffer staging;
+    staging.create(stagingCreateInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Texel rows are tightly packed and 4 byte texels keep every offset a multiple of the texel size
+    std::vector<VkDeviceSize> stagingOffsets;
+    stagingOffsets.reserve(created.size());
+
+    unsigned char* mapped = static_cast<unsigned char*>(staging.map());
+    VkDeviceSize stagingOffset = 0u;
+    for (uint32_t i : created)
+    {
+        const VkDeviceSize bytes = static_cast<VkDeviceSize>(images[i].m_uWidth) * images[i].m_uHeight * TEXEL_SIZE;
+        memcpy(mapped + stagingOffset, images[i].m_pPixels, bytes);
+        stagingOffsets.push_back(stagingOffset);
+        stagingOffset += bytes;
+    }
+    staging.unmap();
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    barriers.reserve(created.size() * 2u);
+
+    const VkCommandBuffer commandBuffer = StagingBuffer::begin();
+
+    for (uint32_t i : created)
+    {
+        const Texture& texture = *textures[i];
+        barriers.push_back(getBarrier(texture.m_VkImage, 0u, texture.m_uMipCount, 0x0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0x0, 0u, nullptr, 0u, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    for (size_t c = 0; c < created.size(); ++c)
+        recordMipChain(commandBuffer, staging.getBuffer(), stagingOffsets[c], *textures[created[c]]);
+
+    // Every level ends up readable by fragment shaders, the last one was only ever written
+    barriers.clear();
+    for (uint32_t i : created)
+    {
+        const Texture& texture = *textures[i];
+        const uint32_t last = texture.m_uMipCount - 1u;
+
+        if (last > 0u)
+        {
+            barriers.push_back(getBarrier(texture.m_VkImage, 0u, last, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+        }
+        barriers.push_back(getBarrier(texture.m_VkImage, last, 1u, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0x0, 0u, nullptr, 0u, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    StagingBuffer::submit();
+    staging.destroy();
+
+    return textures;
+}
+
+void TexturePool::createTexture(const Image& image, Texture& texture)
+{
+    assert(image.m_uWidth > 0u && image.m_uHeight > 0u);
+
+    texture.m_eFormat = image.m_eFormat;
+    texture.m_uWidth = image.m_uWidth;
+    texture.m_uHeight = image.m_uHeight;
+    texture.m_uMipCount = getMipCount(image.m_uWidth, image.m_uHeight);
+    texture.m_ContentKey = image.m_ContentKey;
+
+    const VkImageCreateInfo imageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = image.m_eFormat,
+        .extent = { image.m_uWidth, image.m_uHeight, 1u },
+        .mipLevels = texture.m_uMipCount,
+        .arrayLayers = 1u,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VK_CHECK(vkCreateImage(m_VkDevice, &imageCreateInfo, nullptr, &texture.m_VkImage));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(m_VkDevice, texture.m_VkImage, &memoryRequirements);
+
+    // Blocks start page aligned, stricter alignments are met by padding the range
+    const uint32_t memoryType = getMemoryTypeIndex(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_VkMemoryProperties);
+    const VkDeviceSize alignment = std::max(memoryRequirements.alignment, PAGE_SIZE);
+    const VkDeviceSize pages = (memoryRequirements.size + PAGE_SIZE - 1u) / PAGE_SIZE + (alignment - PAGE_SIZE) / PAGE_SIZE;
+    assert(pages < UINT32_MAX);
+
+    // Every image is optimally tiled, so buffer-image granularity never separates neighbours
+    uint32_t block = UINT32_MAX;
+    uint32_t page = OffsetAllocator::INVALID_OFFSET;
+    for (uint32_t b = 0; b < m_vBlocks.size() && page == OffsetAllocator::INVALID_OFFSET; ++b)
+    {
+        if (m_vBlocks[b].m_VkMemory == VK_NULL_HANDLE || m_vBlocks[b].m_bDedicated || m_vBlocks[b].m_uMemoryType != memoryType)
+            continue;
+
+        page = m_vBlocks[b].m_Allocator.allocate(static_cast<uint32_t>(pages));
+        block = b;
+    }
+
+    if (page == OffsetAllocator::INVALID_OFFSET)
+    {
+        const bool dedicated = pages * PAGE_SIZE > m_uBlockSize;
+        const VkMemoryAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = dedicated ? pages * PAGE_SIZE : m_uBlockSize,
+            .memoryTypeIndex = memoryType,
+        };
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(m_VkDevice, &allocateInfo, nullptr, &memory) != VK_SUCCESS)
+        {
+            std::cerr << "Failed to allocate " << allocateInfo.allocationSize << " bytes of texture memory!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        // Reuses the slot of a freed dedicated block, handles of live textures stay valid
+        block = 0u;
+        while (block < m_vBlocks.size() && m_vBlocks[block].m_VkMemory != VK_NULL_HANDLE)
+            ++block;
+        if (block == m_vBlocks.size())
+            m_vBlocks.emplace_back();
+
+        Block& newBlock = m_vBlocks[block];
+        newBlock.m_VkMemory = memory;
+        newBlock.m_uMemoryType = memoryType;
+        newBlock.m_bDedicated = dedicated;
+        newBlock.m_Allocator.reset(static_cast<uint32_t>(allocateInfo.allocationSize / PAGE_SIZE));
+        page = newBlock.m_Allocator.allocate(static_cast<uint32_t>(pages));
+    }
+
+    texture.m_uBlock = block;
+    texture.m_uPage = page;
+
+    const VkDeviceSize offset = (static_cast<VkDeviceSize>(page) * PAGE_SIZE + alignment - 1u) / alignment * alignment;
+    VK_CHECK(vkBindImageMemory(m_VkDevice, texture.m_VkImage, m_vBlocks[block].m_VkMemory, offset));
+
+    const VkImageViewCreateInfo viewCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = texture.m_VkImage,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = image.m_eFormat,
+        .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0u, texture.m_uMipCount, 0u, 1u },
+    };
+
+    VK_CHECK(vkCreateImageView(m_VkDevice, &viewCreateInfo, nullptr, &texture.m_VkImageView));
+}
+
+void TexturePool::release(Texture& texture)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    vkDestroyImageView(m_VkDevice, texture.m_VkImageView, nullptr);
+    vkDestroyImage(m_VkDevice, texture.m_VkImage, nullptr);
+
+    Block& block = m_vBlocks[texture.m_uBlock];
+    block.m_Allocator.free(texture.m_uPage);
+    if (block.m_bDedicated && block.m_Allocator.getAllocationCount() == 0u)
+    {
+        vkFreeMemory(m_VkDevice, block.m_VkMemory, nullptr);
+        block = Block();
+    }
+
+    // Another upload may have registered a new texture under the key since this one expired
+    auto entry = m_Textures.find(texture.m_ContentKey);
+    if (entry != m_Textures.end() && entry->second.expired())
+        m_Textures.erase(entry);
+
+    texture.m_VkImage = VK_NULL_HANDLE;
+    texture.m_VkImageView = VK_NULL_HANDLE;
+}
+
+uint32_t TexturePool::getTextureCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t textureCount = 0u;
+    for (const Block& block : m_vBlocks)
+        textureCount += block.m_Allocator.getAllocationCount();
+    return textureCount;
+}
+
+uint32_t TexturePool::getBlockCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<uint32_t>(std::count_if(m_vBlocks.begin(), m_vBlocks.end(), [](const Block& block) { return block.m_VkMemory != VK_NULL_HANDLE; }));
+}
+
+VkDeviceSize TexturePool::getBytesAllocated()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VkDeviceSize bytes = 0u;
+    for (const Block& block : m_vBlocks)
+        bytes += static_cast<VkDeviceSize>(block.m_Allocator.getCapacity()) * PAGE_SIZE;
+    return bytes;
+}
+
+VkDeviceSize TexturePool::getBytesUsed()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VkDeviceSize bytes = 0u;
+    for (const Block& block : m_vBlocks)
+        bytes += static_cast<VkDeviceSize>(block.m_Allocator.getCapacity() - block.m_Allocator.getFreeSize()) * PAGE_SIZE;
+    return bytes;
+}
@@ -0,0 +1,112 @@
+#ifndef TEXTURE_POOL_HPP
+#define TEXTURE_POOL_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "../Hash.hpp"
+#include "../OffsetAllocator.hpp"
+
+/**
+ * Sampled image with its full mip chain in SHADER_READ_ONLY_OPTIMAL, created by TexturePool::upload() and
+ * shared by every material and prototype that uses the same pixels. Its memory goes back to the pool with
+ * the last reference, which must not be dropped while the GPU may still sample it.
+ */
+struct Texture
+{
+    Texture() = default;
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    ~Texture();
+
+    VkImage m_VkImage = VK_NULL_HANDLE;
+    VkImageView m_VkImageView = VK_NULL_HANDLE;
+    VkFormat m_eFormat = VK_FORMAT_UNDEFINED;
+    uint32_t m_uWidth = 0u;
+    uint32_t m_uHeight = 0u;
+    uint32_t m_uMipCount = 0u;
+
+    Hash::Key128 m_ContentKey {};
+
+    // Range of a TexturePool block, in the pool's pages
+    uint32_t m_uBlock = UINT32_MAX;
+    uint32_t m_uPage = OffsetAllocator::INVALID_OFFSET;
+};
+
+/**
+ * Device memory of every texture, sub-allocated from large blocks so the number of vkAllocateMemory calls
+ * does not grow with the number of images. Blocks are kept per memory type and managed by an OffsetAllocator in
+ * PAGE_SIZE pages; an image larger than a block gets a dedicated block that is freed with it.
+ *
+ * upload() takes decoded RGBA8 images, copies all of them into one staging buffer and records every copy,
+ * mip generation (a chain of linear vkCmdBlitImage, each level from the one before) and layout transition
+ * into one command buffer with a single submit. Images are deduplicated by a key over their pixels: against
+ * the textures that are alive and within the batch, so materials and files sharing an image share one texture.
+ * The 128 bit key is trusted, a hit is not compared against the live texture's pixels, which only exist on the GPU.
+ *
+ * Only R8G8B8A8_UNORM and R8G8B8A8_SRGB are used, for those the spec requires optimal tiling support for
+ * blits and linear filtering, so no format features are queried. upload() uses the StagingBuffer and must
+ * only be called from the thread that uploads buffers, textures may be released from any thread.
+ */
+class TexturePool
+{
+public:
+    static constexpr VkDeviceSize PAGE_SIZE = 4096u;
+
+    struct Image
+    {
+        const unsigned char* m_pPixels; // m_uWidth * m_uHeight RGBA8 texels, rows tightly packed
+        uint32_t m_uWidth;
+        uint32_t m_uHeight;
+        VkFormat m_eFormat; // R8G8B8A8_SRGB for color, R8G8B8A8_UNORM for data
+        Hash::Key128 m_ContentKey; // computeContentKey()
+    };
+
+    static void create(VkDevice device, const VkPhysicalDeviceMemoryProperties& memoryProperties, VkDeviceSize blockSize);
+    static void destroy();
+
+    // Size, format and pixels
+    static Hash::Key128 computeContentKey(const Image& image);
+
+    // Levels down to 1x1
+    static uint32_t getMipCount(uint32_t width, uint32_t height);
+
+    // One texture per image in the same order, images with the same content key share one
+    static std::vector<std::shared_ptr<Texture>> upload(const std::vector<Image>& images);
+
+    static uint32_t getTextureCount();
+    static uint32_t getBlockCount();
+    static VkDeviceSize getBytesAllocated(); // of every block
+    static VkDeviceSize getBytesUsed();
+
+private:
+    friend struct Texture;
+
+    struct Block
+    {
+        VkDeviceMemory m_VkMemory = VK_NULL_HANDLE;
+        uint32_t m_uMemoryType = 0u;
+        bool m_bDedicated = false;
+        OffsetAllocator m_Allocator;
+    };
+
+    // Creates the image and view and binds them to pool memory, called with m_Mutex held
+    static void createTexture(const Image& image, Texture& texture);
+    static void release(Texture& texture);
+
+    static VkDevice m_VkDevice;
+    static VkPhysicalDeviceMemoryProperties m_VkMemoryProperties;
+    static VkDeviceSize m_uBlockSize;
+
+    static std::mutex m_Mutex;
+    static std::vector<Block> m_vBlocks; // freed dedicated blocks leave a slot with no memory
+    static std::unordered_map<Hash::Key128, std::weak_ptr<Texture>, Hash::Key128Hasher> m_Textures; // by content key
+};
+
+#endif // TEXTURE_POOL_HPP
@@ -13,4 +13,12 @@ enum PipelineType
     PIPELINE_COUNT    = 1
 };
 
+enum class RenderMode
+{
+    BINNED = 0, // RenderManager -> SortBin -> PipelineBin hash maps
+    SORTED = 1, // flat DrawList, radix sorted by a packed 64-bit key
+    INDIRECT = 2, // same bins as BINNED, each material is drawn from a per-frame indirect command buffer
+    RETAINED = 3  // flat DrawList kept across frames, only changes are submitted
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "VertexLayout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+    // Box UNORM16X4 positions are spread across, flat axes get a size of 1 so nothing divides by zero
+    void getQuantizationBox(const Bounds& bounds, glm::vec3& min, glm::vec3& size)
+    {
+        min = bounds.m_v3Center - bounds.m_v3Extents;
+        size = bounds.m_v3Extents * 2.0f;
+        for (uint32_t axis = 0; axis < 3u; ++axis)
+        {
+            if (size[axis] <= 0.0f)
+                size[axis] = 1.0f;
+        }
+    }
+
+    uint16_t quantizeUnorm16(float value)
+    {
+        return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+    int8_t quantizeSnorm8(float value)
+    {
+        return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+    }
+
+    // Projects onto the octahedron |x| + |y| + |z| = 1 and folds its lower half over the upper one
+    void encodeOctahedral(const float* normal, int8_t* encoded)
+    {
+        const float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+        float x = length > 0.0f ? normal[0] / length : 0.0f;
+        float y = length > 0.0f ? normal[1] / length : 0.0f;
+
+        if (normal[2] < 0.0f)
+        {
+            const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+
+        encoded[0] = quantizeSnorm8(x);
+        encoded[1] = quantizeSnorm8(y);
+    }
+}
+
+VkVertexInputBindingDescription VertexLayout::getBindingDescription(uint32_t binding) const
+{
+    return { .binding = binding,
+             .stride = getStride(),
+             .inputRate = VK_VERTEX_INPUT_RATE_VERTEX };
+}
+
+uint32_t VertexLayout::getAttributeDescriptions(uint32_t binding, VkVertexInputAttributeDescription* descriptions) const
+{
+    static constexpr VkFormat positionFormats[] = { VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R16G16B16A16_UNORM };
+    static constexpr VkFormat normalFormats[] = { VK_FORMAT_UNDEFINED, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R8G8_SNORM };
+    static constexpr VkFormat texcoordFormats[] = { VK_FORMAT_UNDEFINED, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R16G16_SFLOAT };
+
+    uint32_t count = 0u;
+    descriptions[count++] = { .location = POSITION_LOCATION,
+                              .binding = binding,
+                              .format = positionFormats[static_cast<uint32_t>(m_ePosition)],
+                              .offset = 0u };
+
+    if (hasNormals())
+    {
+        descriptions[count++] = { .location = NORMAL_LOCATION,
+                                  .binding = binding,
+                                  .format = normalFormats[static_cast<uint32_t>(m_eNormal)],
+                                  .offset = getNormalOffset() };
+    }
+
+    if (hasTexcoords())
+    {
+        descriptions[count++] = { .location = TEXCOORD_LOCATION,
+                                  .binding = binding,
+                                  .format = texcoordFormats[static_cast<uint32_t>(m_eTexcoord)],
+                                  .offset = getTexcoordOffset() };
+    }
+
+    return count;
+}
+
+glm::mat4 VertexLayout::getPositionDecode(const Bounds& bounds) const
+{
+    switch (m_ePosition)
+    {
+    case PositionFormat::HALF4:
+        return glm::translate(glm::mat4(1.0f), bounds.m_v3Center);
+    case PositionFormat::UNORM16X4:
+    {
+        glm::vec3 min;
+        glm::vec3 size;
+        getQuantizationBox(bounds, min, size);
+        return glm::scale(glm::translate(glm::mat4(1.0f), min), size);
+    }
+    default:
+        return glm::mat4(1.0f);
+    }
+}
+
+void VertexLayout::encode(void* destination, const float* positions, const float* normals, const float* texcoords, uint32_t stride, uint32_t vertexCount,
+                          const Bounds& bounds) const
+{
+    unsigned char* vertex = static_cast<unsigned char*>(destination);
+    memset(vertex, 0, static_cast<size_t>(vertexCount) * getStride());
+
+    glm::vec3 min;
+    glm::vec3 size;
+    getQuantizationBox(bounds, min, size);
+
+    for (uint32_t v = 0; v < vertexCount; ++v, vertex += getStride())
+    {
+        const float* position = positions + static_cast<size_t>(v) * stride;
+        switch (m_ePosition)
+        {
+        case PositionFormat::FLOAT3:
+            memcpy(vertex, position, sizeof(float) * 3u);
+            break;
+        case PositionFormat::HALF4:
+        {
+            uint16_t encoded[4] = {};
+            for (uint32_t axis = 0; axis < 3u; ++axis)
+                encoded[axis] = glm::packHalf1x16(position[axis] - bounds.m_v3Center[axis]);
+            memcpy(vertex, encoded, sizeof(encoded));
+            break;
+        }
+        case PositionFormat::UNORM16X4:
+        {
+            uint16_t encoded[4] = {};
+            for (uint32_t axis = 0; axis < 3u; ++axis)
+                encoded[axis] = quantizeUnorm16((position[axis] - min[axis]) / size[axis]);
+            memcpy(vertex, encoded, sizeof(encoded));
+            break;
+        }
+        }
+
+        if (normals != nullptr)
+        {
+            const float* normal = normals + static_cast<size_t>(v) * stride;
+            if (m_eNormal == NormalFormat::FLOAT3)
+            {
+                memcpy(vertex + getNormalOffset(), normal, sizeof(float) * 3u);
+            }
+            else if (m_eNormal == NormalFormat::OCT_SNORM8)
+            {
+                int8_t encoded[2];
+                encodeOctahedral(normal, encoded);
+                memcpy(vertex + getNormalOffset(), encoded, sizeof(encoded));
+            }
+        }
+
+        if (texcoords != nullptr)
+        {
+            const float* texcoord = texcoords + static_cast<size_t>(v) * stride;
+            if (m_eTexcoord == TexcoordFormat::FLOAT2)
+            {
+                memcpy(vertex + getTexcoordOffset(), texcoord, sizeof(float) * 2u);
+            }
+            else if (m_eTexcoord == TexcoordFormat::HALF2)
+            {
+                const uint16_t encoded[2] = { glm::packHalf1x16(texcoord[0]), glm::packHalf1x16(texcoord[1]) };
+                memcpy(vertex + getTexcoordOffset(), encoded, sizeof(encoded));
+            }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef VERTEX_LAYOUT_HPP
+#define VERTEX_LAYOUT_HPP
+
+#include <cstdint>
+
+#include <glm/mat4x4.hpp>
+#include <vulkan/vulkan.h>
+
+#include "../Visibility/Bounds.hpp"
+
+enum class PositionFormat : uint8_t
+{
+    FLOAT3 = 0,    // R32G32B32_SFLOAT, model space
+    HALF4 = 1,     // R16G16B16A16_SFLOAT relative to the bounds center, 11 significant bits
+    UNORM16X4 = 2, // R16G16B16A16_UNORM across the bounding box, 1/65535 of its size per axis
+};
+
+enum class NormalFormat : uint8_t
+{
+    NONE = 0,
+    FLOAT3 = 1,     // R32G32B32_SFLOAT
+    OCT_SNORM8 = 2, // R8G8_SNORM octahedral mapping, padded to 4 bytes
+};
+
+enum class TexcoordFormat : uint8_t
+{
+    NONE = 0,
+    FLOAT2 = 1, // R32G32_SFLOAT
+    HALF2 = 2,  // R16G16_SFLOAT
+};
+
+/**
+ * How a mesh's vertices are stored in its vertex buffer. The loader encodes vertices with it and PipelineManager
+ * builds the pipeline's vertex input state from it, so the two cannot disagree. Attributes are packed in the order
+ * position, normal, texcoord at 4 byte aligned offsets, every one at a fixed shader location; the instance matrix
+ * of binding 1 takes locations 1-4 in between.
+ *
+ * Quantized positions are relative to the prototype's bounds. getPositionDecode() maps them back to model space and
+ * is folded into the draw transform (Model::m_m4DrawTransform), shaders read them like float positions. The 16 bit
+ * position formats have four components because Vulkan only guarantees vertex buffer support for those.
+ *
+ * Octahedral normals (Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors", 2014)
+ * have to be decoded by shaders reading NORMAL_LOCATION.
+ */
+struct VertexLayout
+{
+    PositionFormat m_ePosition;
+    NormalFormat m_eNormal;
+    TexcoordFormat m_eTexcoord;
+
+    static constexpr uint32_t POSITION_LOCATION = 0u;
+    static constexpr uint32_t NORMAL_LOCATION = 5u;
+    static constexpr uint32_t TEXCOORD_LOCATION = 6u;
+    static constexpr uint32_t MAX_ATTRIBUTE_COUNT = 3u;
+
+    static constexpr uint32_t getSize(PositionFormat format) { return format == PositionFormat::FLOAT3 ? 12u : 8u; }
+    static constexpr uint32_t getSize(NormalFormat format) { return format == NormalFormat::NONE ? 0u : format == NormalFormat::FLOAT3 ? 12u : 4u; }
+    static constexpr uint32_t getSize(TexcoordFormat format) { return format == TexcoordFormat::NONE ? 0u : format == TexcoordFormat::FLOAT2 ? 8u : 4u; }
+
+    constexpr bool hasNormals() const { return m_eNormal != NormalFormat::NONE; }
+    constexpr bool hasTexcoords() const { return m_eTexcoord != TexcoordFormat::NONE; }
+
+    constexpr uint32_t getNormalOffset() const { return getSize(m_ePosition); }
+    constexpr uint32_t getTexcoordOffset() const { return getNormalOffset() + getSize(m_eNormal); }
+    constexpr uint32_t getStride() const { return getTexcoordOffset() + getSize(m_eTexcoord); }
+
+    // Identifies the layout in cooked mesh files
+    constexpr uint32_t getKey() const
+    {
+        return static_cast<uint32_t>(m_ePosition) | (static_cast<uint32_t>(m_eNormal) << 8u) | (static_cast<uint32_t>(m_eTexcoord) << 16u);
+    }
+
+    VkVertexInputBindingDescription getBindingDescription(uint32_t binding) const;
+
+    // Writes up to MAX_ATTRIBUTE_COUNT descriptions, returns how many
+    uint32_t getAttributeDescriptions(uint32_t binding, VkVertexInputAttributeDescription* descriptions) const;
+
+    // Maps positions as the vertex shader reads them to model space, identity for FLOAT3
+    glm::mat4 getPositionDecode(const Bounds& bounds) const;
+
+    // Encodes vertexCount vertices of getStride() bytes. The sources are floats, stride floats apart from one vertex
+    // to the next. Normals and texcoords are written as zero when null, positions must lie within bounds.
+    void encode(void* destination, const float* positions, const float* normals, const float* texcoords, uint32_t stride, uint32_t vertexCount,
+                const Bounds& bounds) const;
+};
+
+// Every mesh the loader builds is encoded in this layout, and PIPELINE_DEFAULT reads it. default.vert only consumes
+// positions and multiplies them by the instance matrix, which is where quantized positions are decoded; a shader
+// that skips that matrix needs FLOAT3. Cooked meshes of another layout are decoded and cooked again.
+constexpr VertexLayout MESH_VERTEX_LAYOUT { PositionFormat::UNORM16X4, NormalFormat::NONE, TexcoordFormat::NONE };
+
+#endif // VERTEX_LAYOUT_HPP
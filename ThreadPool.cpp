@@ -0,0 +1,126 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_pBatch{nullptr}, m_bStopping{false}
+{
+    threadCount = std::max(threadCount, 1u);
+
+    m_vWorkers.reserve(threadCount - 1u);
+    for (uint32_t i = 1; i < threadCount; ++i)
+        m_vWorkers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bStopping = true;
+    }
+
+    m_BatchAvailable.notify_all();
+
+    for (std::thread& worker : m_vWorkers)
+        worker.join();
+}
+
+void ThreadPool::runBatch(Batch& batch)
+{
+    uint32_t jobIdx;
+    while ((jobIdx = batch.m_uNextJob.fetch_add(1u)) < batch.m_uJobCount)
+        batch.m_pfnInvoke(batch.m_pJob, jobIdx);
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        Batch* batch;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_BatchAvailable.wait(lock, [this] { return m_bStopping || hasBatchWork() || !m_Tasks.empty(); });
+
+            if (!hasBatchWork())
+            {
+                if (m_Tasks.empty())
+                    return; // stopping
+
+                std::function<void()> task = std::move(m_Tasks.front());
+                m_Tasks.pop_front();
+                lock.unlock();
+
+                task();
+                continue;
+            }
+
+            // Registered under the lock, the caller does not return before every registered worker left
+            batch = m_pBatch;
+            ++batch->m_uActiveWorkers;
+        }
+
+        runBatch(*batch);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            --batch->m_uActiveWorkers;
+        }
+
+        m_BatchDone.notify_one();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    if (m_vWorkers.empty())
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        assert(!m_bStopping && "ThreadPool::submit during destruction!");
+        m_Tasks.push_back(std::move(task));
+    }
+
+    // Every worker waits on the same condition, the woken one may also have been waiting for a batch
+    m_BatchAvailable.notify_one();
+}
+
+void ThreadPool::dispatch(uint32_t jobCount, void (*invoke)(void* job, uint32_t jobIdx), void* job)
+{
+    if (jobCount == 0)
+        return;
+
+    if (jobCount == 1 || m_vWorkers.empty())
+    {
+        for (uint32_t jobIdx = 0; jobIdx < jobCount; ++jobIdx)
+            invoke(job, jobIdx);
+        return;
+    }
+
+    Batch batch;
+    batch.m_pfnInvoke = invoke;
+    batch.m_pJob = job;
+    batch.m_uJobCount = jobCount;
+    batch.m_uNextJob.store(0u);
+    batch.m_uActiveWorkers = 0u;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        assert(m_pBatch == nullptr && "ThreadPool::parallelFor is not reentrant!");
+        m_pBatch = &batch;
+    }
+
+    m_BatchAvailable.notify_all();
+
+    // The calling thread claims jobs as well, once it runs out every unfinished job belongs to an active worker
+    runBatch(batch);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_BatchDone.wait(lock, [&] { return batch.m_uActiveWorkers == 0u; });
+    m_pBatch = nullptr;
+}
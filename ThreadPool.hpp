@@ -0,0 +1,91 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed set of worker threads that help the calling thread through parallelFor() batches.
+ *
+ * getThreadCount() includes the calling thread: parallelFor() runs jobs on the caller as well as the
+ * workers, so a pool created with N threads spawns N - 1 workers. A batch is handed to the workers by
+ * pointer and job indices are claimed with an atomic counter, so dispatching makes no heap allocations.
+ *
+ * submit() queues independent long-running tasks (file loading) that the caller does not wait for. Workers
+ * pick up parallelFor() batches before tasks, and a worker busy with a task simply does not join a batch,
+ * so a parallelFor() never waits for a task to finish.
+ */
+class ThreadPool
+{
+private:
+    struct Batch
+    {
+        void (*m_pfnInvoke)(void* job, uint32_t jobIdx);
+        void* m_pJob;
+        uint32_t m_uJobCount;
+        std::atomic<uint32_t> m_uNextJob;
+        uint32_t m_uActiveWorkers; // guarded by m_Mutex
+    };
+
+    std::vector<std::thread> m_vWorkers;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_BatchAvailable;
+    std::condition_variable m_BatchDone;
+    Batch* m_pBatch; // guarded by m_Mutex, only set while a parallelFor() is running
+    std::deque<std::function<void()>> m_Tasks; // guarded by m_Mutex
+    bool m_bStopping;
+
+    void workerLoop();
+    bool hasBatchWork() const { return m_pBatch != nullptr && m_pBatch->m_uNextJob.load() < m_pBatch->m_uJobCount; }
+
+    static void runBatch(Batch& batch);
+    void dispatch(uint32_t jobCount, void (*invoke)(void* job, uint32_t jobIdx), void* job);
+    void enqueue(std::function<void()> task);
+
+public:
+    explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(m_vWorkers.size()) + 1u; }
+
+    // Runs job(jobIdx) for every jobIdx in [0, jobCount) and blocks until all of them have finished.
+    // Each job index runs exactly once, on exactly one thread. Not reentrant: jobs must not call parallelFor().
+    template <typename Job>
+    void parallelFor(uint32_t jobCount, Job&& job)
+    {
+        using JobType = std::remove_reference_t<Job>;
+
+        dispatch(jobCount, [](void* jobPtr, uint32_t jobIdx) { (*static_cast<JobType*>(jobPtr))(jobIdx); },
+                 const_cast<void*>(static_cast<const void*>(&job)));
+    }
+
+    // Runs task() on a worker and returns its result through the future, exceptions included. Tasks run in
+    // submission order as workers become free, all queued tasks finish before the pool is destroyed. Without
+    // workers the task runs on the calling thread before submit() returns. Tasks may submit further tasks.
+    template <typename Task>
+    std::future<std::invoke_result_t<std::decay_t<Task>>> submit(Task&& task)
+    {
+        using Result = std::invoke_result_t<std::decay_t<Task>>;
+
+        // std::function needs a copyable target, packaged_task is move-only
+        auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+        std::future<Result> future = packagedTask->get_future();
+
+        enqueue([packagedTask]() { (*packagedTask)(); });
+        return future;
+    }
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,100 @@
+#include "Bounds.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BOUNDS_X86 1
+#include <immintrin.h>
+#else
+#define BOUNDS_X86 0
+#endif
+
+Aabb Aabb::fromPositions(const float* positions, uint32_t count, uint32_t stride)
+{
+    Aabb aabb;
+    if (count == 0u)
+        return aabb;
+
+    uint32_t i = 0u;
+
+#if BOUNDS_X86
+    // One position per register, the fourth lane reads the next position's x and is ignored. The last
+    // position is left to the scalar loop so the load never runs past the end of the buffer.
+    __m128 minimum = _mm_set1_ps(FLT_MAX);
+    __m128 maximum = _mm_set1_ps(-FLT_MAX);
+
+    for (; i + 1u < count; ++i)
+    {
+        const __m128 position = _mm_loadu_ps(positions + static_cast<size_t>(i) * stride);
+        minimum = _mm_min_ps(minimum, position);
+        maximum = _mm_max_ps(maximum, position);
+    }
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, minimum);
+    aabb.m_v3Min = glm::vec3(lanes[0], lanes[1], lanes[2]);
+    _mm_store_ps(lanes, maximum);
+    aabb.m_v3Max = glm::vec3(lanes[0], lanes[1], lanes[2]);
+#endif
+
+    for (; i < count; ++i)
+    {
+        const float* position = positions + static_cast<size_t>(i) * stride;
+        aabb.m_v3Min = glm::vec3(std::min(aabb.m_v3Min.x, position[0]), std::min(aabb.m_v3Min.y, position[1]), std::min(aabb.m_v3Min.z, position[2]));
+        aabb.m_v3Max = glm::vec3(std::max(aabb.m_v3Max.x, position[0]), std::max(aabb.m_v3Max.y, position[1]), std::max(aabb.m_v3Max.z, position[2]));
+    }
+
+    return aabb;
+}
+
+Bounds Bounds::fromPositions(const Aabb& aabb, const float* positions, uint32_t count, uint32_t stride)
+{
+    Bounds bounds = fromAabb(aabb);
+
+    float maxDistanceSquared = 0.0f;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const float* position = positions + static_cast<size_t>(i) * stride;
+        const float dx = position[0] - bounds.m_v3Center.x;
+        const float dy = position[1] - bounds.m_v3Center.y;
+        const float dz = position[2] - bounds.m_v3Center.z;
+        maxDistanceSquared = std::max(maxDistanceSquared, dx * dx + dy * dy + dz * dz);
+    }
+
+    // Never looser than the sphere around the box, accessor min/max may be slightly off the actual vertices
+    bounds.m_fRadius = std::min(bounds.m_fRadius, std::sqrt(maxDistanceSquared));
+    return bounds;
+}
+
+Bounds Bounds::fromAabb(const Aabb& aabb)
+{
+    Bounds bounds;
+    if (aabb.isEmpty())
+        return bounds;
+
+    bounds.m_v3Center = glm::vec3((aabb.m_v3Min.x + aabb.m_v3Max.x) * 0.5f, (aabb.m_v3Min.y + aabb.m_v3Max.y) * 0.5f, (aabb.m_v3Min.z + aabb.m_v3Max.z) * 0.5f);
+    bounds.m_v3Extents = glm::vec3((aabb.m_v3Max.x - aabb.m_v3Min.x) * 0.5f, (aabb.m_v3Max.y - aabb.m_v3Min.y) * 0.5f, (aabb.m_v3Max.z - aabb.m_v3Min.z) * 0.5f);
+    bounds.m_fRadius = std::sqrt(bounds.m_v3Extents.x * bounds.m_v3Extents.x + bounds.m_v3Extents.y * bounds.m_v3Extents.y + bounds.m_v3Extents.z * bounds.m_v3Extents.z);
+    return bounds;
+}
+
+Bounds Bounds::transformed(const glm::mat4& transform) const
+{
+    Bounds bounds;
+
+    for (int row = 0; row < 3; ++row)
+    {
+        bounds.m_v3Center[row] = transform[0][row] * m_v3Center.x + transform[1][row] * m_v3Center.y + transform[2][row] * m_v3Center.z + transform[3][row];
+        bounds.m_v3Extents[row] = std::abs(transform[0][row]) * m_v3Extents.x + std::abs(transform[1][row]) * m_v3Extents.y + std::abs(transform[2][row]) * m_v3Extents.z;
+    }
+
+    float maxScaleSquared = 0.0f;
+    for (int column = 0; column < 3; ++column)
+    {
+        const glm::vec4& axis = transform[column];
+        maxScaleSquared = std::max(maxScaleSquared, axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+    }
+
+    bounds.m_fRadius = m_fRadius * std::sqrt(maxScaleSquared);
+    return bounds;
+}
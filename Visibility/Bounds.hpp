@@ -0,0 +1,54 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+struct Aabb
+{
+    glm::vec3 m_v3Min { FLT_MAX, FLT_MAX, FLT_MAX };
+    glm::vec3 m_v3Max { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    bool isEmpty() const { return m_v3Min.x > m_v3Max.x || m_v3Min.y > m_v3Max.y || m_v3Min.z > m_v3Max.z; }
+
+    void expand(const Aabb& rhs)
+    {
+        m_v3Min = glm::vec3(std::min(m_v3Min.x, rhs.m_v3Min.x), std::min(m_v3Min.y, rhs.m_v3Min.y), std::min(m_v3Min.z, rhs.m_v3Min.z));
+        m_v3Max = glm::vec3(std::max(m_v3Max.x, rhs.m_v3Max.x), std::max(m_v3Max.y, rhs.m_v3Max.y), std::max(m_v3Max.z, rhs.m_v3Max.z));
+    }
+
+    void expand(const glm::vec3& point)
+    {
+        m_v3Min = glm::vec3(std::min(m_v3Min.x, point.x), std::min(m_v3Min.y, point.y), std::min(m_v3Min.z, point.z));
+        m_v3Max = glm::vec3(std::max(m_v3Max.x, point.x), std::max(m_v3Max.y, point.y), std::max(m_v3Max.z, point.z));
+    }
+
+    // Min/max over count positions of three floats each, stride is in floats. SSE on x86-64.
+    static Aabb fromPositions(const float* positions, uint32_t count, uint32_t stride);
+};
+
+/**
+ * Box plus a bounding sphere around the same center, the two volumes FrustumCuller tests at once.
+ * The sphere is fitted to the actual vertices, so for elongated or rotated objects it is often the tighter one.
+ */
+struct Bounds
+{
+    glm::vec3 m_v3Center { 0.0f, 0.0f, 0.0f };
+    glm::vec3 m_v3Extents { 0.0f, 0.0f, 0.0f }; // half size of the box
+    float m_fRadius = 0.0f;
+
+    // Radius is the distance from the box center to the farthest of the positions (same layout as Aabb::fromPositions)
+    static Bounds fromPositions(const Aabb& aabb, const float* positions, uint32_t count, uint32_t stride);
+
+    // Sphere bounding the box itself, for when only the box is known
+    static Bounds fromAabb(const Aabb& aabb);
+
+    // Box of the transformed box (Arvo), the radius grows with the largest axis scale
+    Bounds transformed(const glm::mat4& transform) const;
+};
+
+#endif // BOUNDS_HPP
@@ -0,0 +1,97 @@
+#include "ClusterCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    // Column lengths may differ by this factor and columns may be this far from orthogonal (cosine)
+    constexpr float SIMILARITY_TOLERANCE = 1e-3f;
+
+    // Rotation times uniform scale, the only transforms that keep the angles the cones are made of
+    bool isSimilarity(const glm::mat4& transform)
+    {
+        const glm::vec3 x(transform[0]);
+        const glm::vec3 y(transform[1]);
+        const glm::vec3 z(transform[2]);
+
+        const float xx = glm::dot(x, x);
+        const float yy = glm::dot(y, y);
+        const float zz = glm::dot(z, z);
+        const float tolerance = SIMILARITY_TOLERANCE * xx;
+
+        return std::fabs(yy - xx) <= 2.0f * tolerance && std::fabs(zz - xx) <= 2.0f * tolerance &&
+               std::fabs(glm::dot(x, y)) <= tolerance && std::fabs(glm::dot(x, z)) <= tolerance && std::fabs(glm::dot(y, z)) <= tolerance &&
+               glm::dot(glm::cross(x, y), z) > 0.0f;
+    }
+}
+
+void ClusterCuller::begin(const glm::mat4& viewProjection)
+{
+    m_Frustum = Frustum::fromViewProjection(viewProjection);
+    m_v4Camera = glm::inverse(viewProjection) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    m_Stats = {};
+}
+
+uint32_t ClusterCuller::cull(const Meshlet* meshlets, uint32_t meshletCount, const glm::mat4& transform, uint32_t* visible)
+{
+    const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                                             glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+                                             glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])) }));
+
+    // Camera in local space, either a point or the direction the camera looks in
+    const bool coneTest = isSimilarity(transform);
+    const glm::vec4 camera = coneTest ? glm::inverse(transform) * m_v4Camera : glm::vec4(0.0f);
+    const bool cameraAtInfinity = std::fabs(camera.w) <= 1e-6f * std::max({ std::fabs(camera.x), std::fabs(camera.y), std::fabs(camera.z) });
+    const glm::vec3 cameraPosition = cameraAtInfinity ? glm::vec3(0.0f) : glm::vec3(camera) / camera.w;
+    const glm::vec3 viewDirection = cameraAtInfinity ? glm::normalize(glm::vec3(camera)) : glm::vec3(0.0f);
+
+    uint32_t visibleCount = 0u;
+    for (uint32_t m = 0; m < meshletCount; ++m)
+    {
+        const Meshlet& meshlet = meshlets[m];
+        const uint32_t triangleCount = meshlet.m_uIndexCount / 3u;
+        m_Stats.m_uTriangles += triangleCount;
+
+        const glm::vec3 center = glm::vec3(transform * glm::vec4(meshlet.m_v3Center, 1.0f));
+        const float radius = meshlet.m_fRadius * scale;
+
+        bool inside = true;
+        for (const glm::vec4& plane : m_Frustum.m_vPlanes)
+            inside &= glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+
+        if (!inside)
+        {
+            ++m_Stats.m_uFrustumCulled;
+            continue;
+        }
+
+        if (coneTest && meshlet.m_fConeCutoff < 1.0f)
+        {
+            bool backfacing;
+            if (cameraAtInfinity)
+            {
+                backfacing = glm::dot(viewDirection, meshlet.m_v3ConeAxis) >= meshlet.m_fConeCutoff;
+            }
+            else
+            {
+                const glm::vec3 view = meshlet.m_v3Center - cameraPosition;
+                backfacing = glm::dot(view, meshlet.m_v3ConeAxis) >= meshlet.m_fConeCutoff * glm::length(view) + meshlet.m_fRadius;
+            }
+
+            if (backfacing)
+            {
+                ++m_Stats.m_uBackfaceCulled;
+                continue;
+            }
+        }
+
+        m_Stats.m_uVisibleTriangles += triangleCount;
+        visible[visibleCount++] = m;
+    }
+
+    m_Stats.m_uMeshlets += meshletCount;
+    return visibleCount;
+}
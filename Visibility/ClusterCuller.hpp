@@ -0,0 +1,51 @@
+#ifndef CLUSTER_CULLER_HPP
+#define CLUSTER_CULLER_HPP
+
+#include <cstdint>
+
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "Frustum.hpp"
+#include "../Geometry/MeshletBuilder.hpp"
+
+/**
+ * Per-meshlet culling on the CPU, for the models that are drawn at full detail and survived the per-model
+ * culling. A meshlet is dropped when its sphere is outside the frustum or its normal cone says every one of its
+ * triangles faces away from the camera; the surviving index ranges are then submitted like any renderable, so
+ * it works on any hardware and with every RenderMode that takes per-frame submissions.
+ *
+ * The camera is taken from the view-projection itself: the clip space point (0, 0, 1, 0) maps back to the eye,
+ * or to the view direction for orthographic projections. The cone test runs in the model's local space and is
+ * skipped for transforms that are not a rotation with uniform scale, which would bend the cones, or that mirror.
+ *
+ * No Vulkan dependency, see Bench/ClusterCullBench.cpp.
+ */
+class ClusterCuller
+{
+public:
+    struct Stats
+    {
+        uint32_t m_uMeshlets = 0u;
+        uint32_t m_uFrustumCulled = 0u;
+        uint32_t m_uBackfaceCulled = 0u;
+        uint32_t m_uTriangles = 0u;        // of every meshlet tested
+        uint32_t m_uVisibleTriangles = 0u; // of the ones that passed
+    };
+
+    // Frustum and camera of the frame, resets the stats
+    void begin(const glm::mat4& viewProjection);
+
+    // visible must have room for meshletCount indices into meshlets, returns how many were written. transform
+    // takes the meshlets' local space to world space.
+    uint32_t cull(const Meshlet* meshlets, uint32_t meshletCount, const glm::mat4& transform, uint32_t* visible);
+
+    const Stats& getStats() const { return m_Stats; }
+
+private:
+    Frustum m_Frustum;
+    glm::vec4 m_v4Camera { 0.0f }; // homogeneous, w = 0 for a camera at infinity
+    Stats m_Stats;
+};
+
+#endif // CLUSTER_CULLER_HPP
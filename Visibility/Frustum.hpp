@@ -0,0 +1,63 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <array>
+#include <cmath>
+
+#include <glm/mat4x4.hpp>
+
+/**
+ * Six world-space planes (x, y, z = inward normal, w = distance) extracted from a view-projection matrix.
+ * A point p is inside a plane when dot(normal, p) + w >= 0. The normals are unit length, so the same value
+ * is the signed distance used by the bounding volume tests.
+ */
+struct Frustum
+{
+    enum
+    {
+        PLANE_LEFT = 0,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        PLANE_COUNT
+    };
+
+    std::array<glm::vec4, PLANE_COUNT> m_vPlanes;
+
+    // Gribb/Hartmann extraction, the matrix maps world space to clip space
+    static Frustum fromViewProjection(const glm::mat4& viewProjection)
+    {
+        const auto row = [&viewProjection](int r) {
+            return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+        };
+
+        const glm::vec4 row0 = row(0);
+        const glm::vec4 row1 = row(1);
+        const glm::vec4 row2 = row(2);
+        const glm::vec4 row3 = row(3);
+
+        Frustum frustum;
+        frustum.m_vPlanes[PLANE_LEFT] = row3 + row0;
+        frustum.m_vPlanes[PLANE_RIGHT] = row3 - row0;
+        frustum.m_vPlanes[PLANE_BOTTOM] = row3 + row1;
+        frustum.m_vPlanes[PLANE_TOP] = row3 - row1;
+#ifdef GLM_FORCE_DEPTH_ZERO_TO_ONE
+        frustum.m_vPlanes[PLANE_NEAR] = row2;
+#else
+        frustum.m_vPlanes[PLANE_NEAR] = row3 + row2;
+#endif
+        frustum.m_vPlanes[PLANE_FAR] = row3 - row2;
+
+        for (glm::vec4& plane : frustum.m_vPlanes)
+        {
+            const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+            plane = glm::vec4(plane.x / length, plane.y / length, plane.z / length, plane.w / length);
+        }
+
+        return frustum;
+    }
+};
+
+#endif // FRUSTUM_HPP
@@ -0,0 +1,365 @@
+#include "FrustumCuller.hpp"
+#include "../ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRUSTUM_CULLER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define FRUSTUM_CULLER_X86 0
+#endif
+
+// The AVX2 kernel is compiled for AVX2 regardless of the target flags and only called after a runtime check
+#if FRUSTUM_CULLER_X86 && (defined(__GNUC__) || defined(__clang__))
+#define FRUSTUM_CULLER_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define FRUSTUM_CULLER_AVX2_TARGET
+#endif
+
+namespace
+{
+    struct SoaBounds
+    {
+        const float* m_pCenterX;
+        const float* m_pCenterY;
+        const float* m_pCenterZ;
+        const float* m_pExtentX;
+        const float* m_pExtentY;
+        const float* m_pExtentZ;
+        const float* m_pRadius;
+    };
+
+    // Plane normals and their absolute values, the latter project the box extents onto the normal
+    struct Planes
+    {
+        float m_vNormalX[Frustum::PLANE_COUNT];
+        float m_vNormalY[Frustum::PLANE_COUNT];
+        float m_vNormalZ[Frustum::PLANE_COUNT];
+        float m_vDistance[Frustum::PLANE_COUNT];
+        float m_vAbsNormalX[Frustum::PLANE_COUNT];
+        float m_vAbsNormalY[Frustum::PLANE_COUNT];
+        float m_vAbsNormalZ[Frustum::PLANE_COUNT];
+
+        explicit Planes(const Frustum& frustum)
+        {
+            for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p)
+            {
+                const glm::vec4& plane = frustum.m_vPlanes[p];
+                m_vNormalX[p] = plane.x;
+                m_vNormalY[p] = plane.y;
+                m_vNormalZ[p] = plane.z;
+                m_vDistance[p] = plane.w;
+                m_vAbsNormalX[p] = std::abs(plane.x);
+                m_vAbsNormalY[p] = std::abs(plane.y);
+                m_vAbsNormalZ[p] = std::abs(plane.z);
+            }
+        }
+    };
+
+    uint32_t cullScalar(const SoaBounds& bounds, const Planes& planes, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        uint32_t visibleCount = 0u;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            bool inside = true;
+            for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p)
+            {
+                // Same operation order as the SSE kernel, so both agree on objects touching a plane
+                float distance = planes.m_vNormalX[p] * bounds.m_pCenterX[i] + planes.m_vDistance[p];
+                distance = planes.m_vNormalY[p] * bounds.m_pCenterY[i] + distance;
+                distance = planes.m_vNormalZ[p] * bounds.m_pCenterZ[i] + distance;
+
+                float boxRadius = planes.m_vAbsNormalX[p] * bounds.m_pExtentX[i];
+                boxRadius = planes.m_vAbsNormalY[p] * bounds.m_pExtentY[i] + boxRadius;
+                boxRadius = planes.m_vAbsNormalZ[p] * bounds.m_pExtentZ[i] + boxRadius;
+
+                inside &= distance + std::min(bounds.m_pRadius[i], boxRadius) >= 0.0f;
+            }
+
+            // Branchless compaction, the slot is overwritten by the next object when this one is culled
+            visible[visibleCount] = i;
+            visibleCount += inside ? 1u : 0u;
+        }
+
+        return visibleCount;
+    }
+
+#if FRUSTUM_CULLER_X86
+    uint32_t cullSse(const SoaBounds& bounds, const Planes& planes, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        constexpr uint32_t LANES = 4u;
+        const uint32_t simdEnd = begin + ((end - begin) / LANES) * LANES;
+
+        uint32_t visibleCount = 0u;
+        for (uint32_t i = begin; i < simdEnd; i += LANES)
+        {
+            const __m128 centerX = _mm_loadu_ps(bounds.m_pCenterX + i);
+            const __m128 centerY = _mm_loadu_ps(bounds.m_pCenterY + i);
+            const __m128 centerZ = _mm_loadu_ps(bounds.m_pCenterZ + i);
+            const __m128 extentX = _mm_loadu_ps(bounds.m_pExtentX + i);
+            const __m128 extentY = _mm_loadu_ps(bounds.m_pExtentY + i);
+            const __m128 extentZ = _mm_loadu_ps(bounds.m_pExtentZ + i);
+            const __m128 radius = _mm_loadu_ps(bounds.m_pRadius + i);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_vNormalX[p]), centerX), _mm_set1_ps(planes.m_vDistance[p]));
+                distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_vNormalY[p]), centerY), distance);
+                distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_vNormalZ[p]), centerZ), distance);
+
+                __m128 boxRadius = _mm_mul_ps(_mm_set1_ps(planes.m_vAbsNormalX[p]), extentX);
+                boxRadius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_vAbsNormalY[p]), extentY), boxRadius);
+                boxRadius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.m_vAbsNormalZ[p]), extentZ), boxRadius);
+
+                // distance + min(radius, boxRadius) >= 0
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, _mm_min_ps(radius, boxRadius)), _mm_setzero_ps()));
+            }
+
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+            if (mask == 0u)
+                continue;
+
+            for (uint32_t lane = 0; lane < LANES; ++lane)
+            {
+                visible[visibleCount] = i + lane;
+                visibleCount += (mask >> lane) & 1u;
+            }
+        }
+
+        return visibleCount + cullScalar(bounds, planes, simdEnd, end, visible + visibleCount);
+    }
+
+    FRUSTUM_CULLER_AVX2_TARGET
+    uint32_t cullAvx2(const SoaBounds& bounds, const Planes& planes, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        constexpr uint32_t LANES = 8u;
+        const uint32_t simdEnd = begin + ((end - begin) / LANES) * LANES;
+
+        uint32_t visibleCount = 0u;
+        for (uint32_t i = begin; i < simdEnd; i += LANES)
+        {
+            const __m256 centerX = _mm256_loadu_ps(bounds.m_pCenterX + i);
+            const __m256 centerY = _mm256_loadu_ps(bounds.m_pCenterY + i);
+            const __m256 centerZ = _mm256_loadu_ps(bounds.m_pCenterZ + i);
+            const __m256 extentX = _mm256_loadu_ps(bounds.m_pExtentX + i);
+            const __m256 extentY = _mm256_loadu_ps(bounds.m_pExtentY + i);
+            const __m256 extentZ = _mm256_loadu_ps(bounds.m_pExtentZ + i);
+            const __m256 radius = _mm256_loadu_ps(bounds.m_pRadius + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (uint32_t p = 0; p < Frustum::PLANE_COUNT; ++p)
+            {
+                __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.m_vNormalX[p]), centerX, _mm256_set1_ps(planes.m_vDistance[p]));
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.m_vNormalY[p]), centerY, distance);
+                distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.m_vNormalZ[p]), centerZ, distance);
+
+                __m256 boxRadius = _mm256_mul_ps(_mm256_set1_ps(planes.m_vAbsNormalX[p]), extentX);
+                boxRadius = _mm256_fmadd_ps(_mm256_set1_ps(planes.m_vAbsNormalY[p]), extentY, boxRadius);
+                boxRadius = _mm256_fmadd_ps(_mm256_set1_ps(planes.m_vAbsNormalZ[p]), extentZ, boxRadius);
+
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, _mm256_min_ps(radius, boxRadius)), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+            if (mask == 0u)
+                continue;
+
+            for (uint32_t lane = 0; lane < LANES; ++lane)
+            {
+                visible[visibleCount] = i + lane;
+                visibleCount += (mask >> lane) & 1u;
+            }
+        }
+
+        return visibleCount + cullScalar(bounds, planes, simdEnd, end, visible + visibleCount);
+    }
+
+    bool cpuSupportsAvx2()
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return false;
+#endif
+    }
+#endif
+}
+
+FrustumCuller::Path FrustumCuller::getBestPath()
+{
+    static const Path bestPath = isPathSupported(Path::AVX2) ? Path::AVX2 : (isPathSupported(Path::SSE) ? Path::SSE : Path::SCALAR);
+    return bestPath;
+}
+
+bool FrustumCuller::isPathSupported(Path path)
+{
+    switch (path)
+    {
+    case Path::SCALAR:
+        return true;
+#if FRUSTUM_CULLER_X86
+    case Path::SSE:
+        return true;
+    case Path::AVX2:
+    {
+        static const bool avx2 = cpuSupportsAvx2();
+        return avx2;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* FrustumCuller::getPathName(Path path)
+{
+    switch (path)
+    {
+    case Path::SCALAR: return "scalar";
+    case Path::SSE: return "sse";
+    case Path::AVX2: return "avx2";
+    }
+
+    return "unknown";
+}
+
+uint32_t FrustumCuller::add(const glm::vec3& center, const glm::vec3& extents, float radius)
+{
+    const uint32_t index = size();
+
+    m_vCenterX.push_back(center.x);
+    m_vCenterY.push_back(center.y);
+    m_vCenterZ.push_back(center.z);
+    m_vExtentX.push_back(extents.x);
+    m_vExtentY.push_back(extents.y);
+    m_vExtentZ.push_back(extents.z);
+    m_vRadius.push_back(radius);
+
+    return index;
+}
+
+void FrustumCuller::set(uint32_t index, const glm::vec3& center, const glm::vec3& extents, float radius)
+{
+    assert(index < size() && "Invalid culling object index!");
+
+    m_vCenterX[index] = center.x;
+    m_vCenterY[index] = center.y;
+    m_vCenterZ[index] = center.z;
+    m_vExtentX[index] = extents.x;
+    m_vExtentY[index] = extents.y;
+    m_vExtentZ[index] = extents.z;
+    m_vRadius[index] = radius;
+}
+
+uint32_t FrustumCuller::addUnbounded()
+{
+    // A quarter of FLT_MAX per axis keeps the projected box extent finite, so no plane test can produce a NaN
+    return add(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(FLT_MAX / 4.0f, FLT_MAX / 4.0f, FLT_MAX / 4.0f), FLT_MAX);
+}
+
+void FrustumCuller::reserve(uint32_t count)
+{
+    m_vCenterX.reserve(count);
+    m_vCenterY.reserve(count);
+    m_vCenterZ.reserve(count);
+    m_vExtentX.reserve(count);
+    m_vExtentY.reserve(count);
+    m_vExtentZ.reserve(count);
+    m_vRadius.reserve(count);
+}
+
+void FrustumCuller::clear()
+{
+    m_vCenterX.clear();
+    m_vCenterY.clear();
+    m_vCenterZ.clear();
+    m_vExtentX.clear();
+    m_vExtentY.clear();
+    m_vExtentZ.clear();
+    m_vRadius.clear();
+}
+
+uint32_t FrustumCuller::cull(const Frustum& frustum, uint32_t* visible, Path path) const
+{
+    return cullRange(frustum, 0u, size(), visible, path);
+}
+
+uint32_t FrustumCuller::cullRange(const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* visible, Path path) const
+{
+    assert(isPathSupported(path) && "Culling path is not supported on this CPU!");
+    assert(begin <= end && end <= size());
+
+    const SoaBounds bounds { m_vCenterX.data(), m_vCenterY.data(), m_vCenterZ.data(), m_vExtentX.data(), m_vExtentY.data(), m_vExtentZ.data(), m_vRadius.data() };
+    const Planes planes { frustum };
+
+    switch (path)
+    {
+#if FRUSTUM_CULLER_X86
+    case Path::AVX2:
+        return cullAvx2(bounds, planes, begin, end, visible);
+    case Path::SSE:
+        return cullSse(bounds, planes, begin, end, visible);
+#endif
+    default:
+        return cullScalar(bounds, planes, begin, end, visible);
+    }
+}
+
+uint32_t FrustumCuller::cull(const Frustum& frustum, uint32_t* visible, ThreadPool& threadPool, ParallelScratch& scratch, uint32_t chunkSize, Path path) const
+{
+    assert(chunkSize > 0u && chunkSize % CACHE_LINE_OBJECTS == 0u && "Chunks must cover whole cache lines!");
+
+    const uint32_t objectCount = size();
+    const uint32_t chunkCount = (objectCount + chunkSize - 1u) / chunkSize;
+
+    if (chunkCount <= 1u || threadPool.getThreadCount() == 1u)
+        return cull(frustum, visible, path);
+
+    if (scratch.m_vChunkVisible.size() < objectCount)
+        scratch.m_vChunkVisible.resize(objectCount);
+
+    if (scratch.m_vChunkCounts.size() < chunkCount)
+    {
+        scratch.m_vChunkCounts.resize(chunkCount);
+        scratch.m_vChunkOffsets.resize(chunkCount);
+    }
+
+    threadPool.parallelFor(chunkCount, [&](uint32_t chunk) {
+        const uint32_t begin = chunk * chunkSize;
+        const uint32_t end = std::min(begin + chunkSize, objectCount);
+        scratch.m_vChunkCounts[chunk] = cullRange(frustum, begin, end, scratch.m_vChunkVisible.data() + begin, path);
+    });
+
+    uint32_t visibleCount = 0u;
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        scratch.m_vChunkOffsets[chunk] = visibleCount;
+        visibleCount += scratch.m_vChunkCounts[chunk];
+    }
+
+    threadPool.parallelFor(chunkCount, [&](uint32_t chunk) {
+        memcpy(visible + scratch.m_vChunkOffsets[chunk], scratch.m_vChunkVisible.data() + chunk * chunkSize, scratch.m_vChunkCounts[chunk] * sizeof(uint32_t));
+    });
+
+    return visibleCount;
+}
@@ -0,0 +1,105 @@
+#ifndef FRUSTUM_CULLER_HPP
+#define FRUSTUM_CULLER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+#include "../AlignedAllocator.hpp"
+
+class ThreadPool;
+
+/**
+ * Brute-force frustum culling over linear arrays ("Culling the Battlefield", see Notes.txt).
+ *
+ * Every object is a world-space AABB (center + half extents) plus a bounding sphere around the same center,
+ * stored as structure of arrays so one SIMD lane tests one object. Both volumes are tested against a plane
+ * at once: the object is behind the plane when its center distance is below -min(sphere radius, projected
+ * box extent), so a rotated object gets the tighter of the two. No hierarchy and no early-outs, the cost is
+ * a fixed handful of multiply-adds per object and plane.
+ *
+ * cull() writes the indices of the objects that intersect the frustum in ascending order. Object indices are
+ * assigned by add() in submission order and never change, callers keep their own arrays parallel to them.
+ *
+ * The parallel cull() splits the objects into chunks of a multiple of a cache line worth of floats, so no two
+ * threads ever read or write the same line. Each chunk is culled into its own slice of a scratch list, then an
+ * exclusive prefix sum over the per-chunk counts gives every chunk its offset in the output, and the slices
+ * are copied there in parallel. No locks, no atomics besides the pool's job counter, same output as cull().
+ */
+class FrustumCuller
+{
+public:
+    // Objects per cache line of each SoA array, chunk boundaries are multiples of it
+    static constexpr uint32_t CACHE_LINE_OBJECTS = static_cast<uint32_t>(CACHE_LINE_SIZE / sizeof(float));
+
+    // Large enough to amortize the job dispatch, small enough for the pool's atomic job index to balance the load
+    static constexpr uint32_t DEFAULT_CHUNK_SIZE = 256u * CACHE_LINE_OBJECTS;
+
+    // Per-caller storage of the parallel cull, only grows
+    struct ParallelScratch
+    {
+        CacheAlignedVector<uint32_t> m_vChunkVisible; // chunk c writes from c * chunkSize
+        std::vector<uint32_t> m_vChunkCounts;
+        std::vector<uint32_t> m_vChunkOffsets;
+    };
+
+    enum class Path
+    {
+        SCALAR = 0,
+        SSE    = 1, // SSE2, always available on x86-64
+        AVX2   = 2, // selected at runtime when the CPU supports it
+    };
+
+    // Fastest path the running CPU supports, the default for cull()
+    static Path getBestPath();
+    static bool isPathSupported(Path path);
+    static const char* getPathName(Path path);
+
+    uint32_t add(const glm::vec3& center, const glm::vec3& extents, float radius);
+    void set(uint32_t index, const glm::vec3& center, const glm::vec3& extents, float radius);
+
+    uint32_t add(const Bounds& bounds) { return add(bounds.m_v3Center, bounds.m_v3Extents, bounds.m_fRadius); }
+    void set(uint32_t index, const Bounds& bounds) { set(index, bounds.m_v3Center, bounds.m_v3Extents, bounds.m_fRadius); }
+
+    // Bounds that pass every frustum test, for objects whose extent is not known
+    uint32_t addUnbounded();
+
+    void reserve(uint32_t count);
+    void clear();
+
+    uint32_t size() const { return static_cast<uint32_t>(m_vCenterX.size()); }
+
+    Bounds getBounds(uint32_t index) const
+    {
+        Bounds bounds;
+        bounds.m_v3Center = glm::vec3(m_vCenterX[index], m_vCenterY[index], m_vCenterZ[index]);
+        bounds.m_v3Extents = glm::vec3(m_vExtentX[index], m_vExtentY[index], m_vExtentZ[index]);
+        bounds.m_fRadius = m_vRadius[index];
+        return bounds;
+    }
+
+    // visible must have room for size() indices, returns how many were written
+    uint32_t cull(const Frustum& frustum, uint32_t* visible) const { return cull(frustum, visible, getBestPath()); }
+    uint32_t cull(const Frustum& frustum, uint32_t* visible, Path path) const;
+
+    // Objects [begin, end) only, visible must have room for end - begin indices
+    uint32_t cullRange(const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* visible, Path path) const;
+
+    // Same result as cull(), split across threadPool. Runs serially when the objects fit into a single chunk.
+    uint32_t cull(const Frustum& frustum, uint32_t* visible, ThreadPool& threadPool, ParallelScratch& scratch,
+                  uint32_t chunkSize = DEFAULT_CHUNK_SIZE, Path path = getBestPath()) const;
+
+private:
+    CacheAlignedVector<float> m_vCenterX;
+    CacheAlignedVector<float> m_vCenterY;
+    CacheAlignedVector<float> m_vCenterZ;
+    CacheAlignedVector<float> m_vExtentX;
+    CacheAlignedVector<float> m_vExtentY;
+    CacheAlignedVector<float> m_vExtentZ;
+    CacheAlignedVector<float> m_vRadius;
+};
+
+#endif // FRUSTUM_CULLER_HPP
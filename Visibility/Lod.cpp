@@ -0,0 +1,45 @@
+#include "Lod.hpp"
+
+#include <cfloat>
+#include <cmath>
+
+float Lod::getScreenSize(const glm::mat4& viewProjection, const Bounds& bounds)
+{
+    const glm::vec3& center = bounds.m_v3Center;
+
+    // Clip w is the view depth, the length of the y row is the projection's y scale (the view is a rigid transform)
+    const float w = viewProjection[0][3] * center.x + viewProjection[1][3] * center.y + viewProjection[2][3] * center.z + viewProjection[3][3];
+    if (w <= bounds.m_fRadius)
+        return FLT_MAX;
+
+    const float scaleY = std::sqrt(viewProjection[0][1] * viewProjection[0][1] + viewProjection[1][1] * viewProjection[1][1] + viewProjection[2][1] * viewProjection[2][1]);
+
+    // Clip space spans 2 units of height, so radius / w in NDC is already diameter / viewport height
+    return bounds.m_fRadius * scaleY / w;
+}
+
+float Lod::getMinScreenSize(uint32_t lod, uint32_t lodCount)
+{
+    if (lod + 1u >= lodCount)
+        return 0.0f;
+
+    return std::ldexp(LOD_FIRST_SCREEN_SIZE, -static_cast<int>(lod));
+}
+
+uint32_t Lod::select(float screenSize, uint32_t currentLod, uint32_t lodCount)
+{
+    if (currentLod < lodCount)
+    {
+        const float lower = getMinScreenSize(currentLod, lodCount) * (1.0f - LOD_HYSTERESIS);
+        const float upper = currentLod == 0u ? FLT_MAX : getMinScreenSize(currentLod - 1u, lodCount) * (1.0f + LOD_HYSTERESIS);
+
+        if (screenSize >= lower && screenSize < upper)
+            return currentLod;
+    }
+
+    uint32_t lod = 0u;
+    while (screenSize < getMinScreenSize(lod, lodCount))
+        ++lod;
+
+    return lod;
+}
@@ -0,0 +1,35 @@
+#ifndef LOD_HPP
+#define LOD_HPP
+
+#include <cstdint>
+
+#include <glm/mat4x4.hpp>
+
+#include "Bounds.hpp"
+
+/**
+ * Screen-size LOD selection for the simplified index ranges the loader generates.
+ *
+ * LOD 0 is drawn while the bounding sphere covers at least LOD_FIRST_SCREEN_SIZE of the viewport height, every
+ * further LOD takes over at half the size of the previous one. The loader halves the triangle count per LOD and
+ * doubles the allowed error, so triangles per pixel and error in pixels stay roughly constant.
+ *
+ * A model only leaves its current LOD once its size is LOD_HYSTERESIS beyond the band of that LOD, so a model
+ * sitting on a threshold does not switch every frame.
+ */
+namespace Lod
+{
+    constexpr float LOD_FIRST_SCREEN_SIZE = 0.25f;
+    constexpr float LOD_HYSTERESIS = 0.1f;
+
+    // Diameter of the bounding sphere relative to the viewport height, FLT_MAX when the camera is inside it
+    float getScreenSize(const glm::mat4& viewProjection, const Bounds& bounds);
+
+    // Smallest size at which lod is still selected, 0 for the last one
+    float getMinScreenSize(uint32_t lod, uint32_t lodCount);
+
+    // currentLod is the LOD of the last frame, anything >= lodCount when there was none
+    uint32_t select(float screenSize, uint32_t currentLod, uint32_t lodCount);
+}
+
+#endif // LOD_HPP
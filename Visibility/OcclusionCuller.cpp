@@ -0,0 +1,410 @@
+#include "OcclusionCuller.hpp"
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OCCLUSION_CULLER_X86 1
+#include <immintrin.h>
+#else
+#define OCCLUSION_CULLER_X86 0
+#endif
+
+namespace
+{
+    // Nothing rasterized, never hides anything
+    constexpr float DEPTH_CLEAR = FLT_MAX;
+
+    // Signed distance to the near plane in clip space, >= 0 in front of it
+    inline float getNearDistance(const glm::vec4& clip)
+    {
+#ifdef GLM_FORCE_DEPTH_ZERO_TO_ONE
+        return clip.z;
+#else
+        return clip.z + clip.w;
+#endif
+    }
+
+    // Pixel (x, y) covers [x, x + 1) x [y, y + 1), z is the compared depth
+    inline glm::vec3 toScreen(const glm::vec4& clip)
+    {
+        const float invW = 1.0f / clip.w;
+        return glm::vec3((clip.x * invW * 0.5f + 0.5f) * static_cast<float>(OcclusionCuller::WIDTH),
+                         (clip.y * invW * 0.5f + 0.5f) * static_cast<float>(OcclusionCuller::HEIGHT),
+                         clip.z * invW);
+    }
+
+#if OCCLUSION_CULLER_X86
+    inline float getHorizontalMin(__m128 v)
+    {
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    inline float getHorizontalMax(__m128 v)
+    {
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+#endif
+
+    // a * x + b * y + c, >= 0 on the inner side of an edge or the depth at (x, y)
+    struct PlaneEquation
+    {
+        float a;
+        float b;
+        float c;
+    };
+
+    // Positive on the left of from->to when the triangle winds counter-clockwise in pixel space
+    inline PlaneEquation makeEdge(const glm::vec3& from, const glm::vec3& to)
+    {
+        const float a = from.y - to.y;
+        const float b = to.x - from.x;
+        return { a, b, -(a * from.x + b * from.y) };
+    }
+}
+
+OcclusionCuller::OcclusionCuller()
+{
+    for (uint32_t level = 0; level < LEVEL_COUNT; ++level)
+        m_vLevels[level].assign(getLevelWidth(level) * getLevelHeight(level), DEPTH_CLEAR);
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection)
+{
+    m_m4ViewProjection = viewProjection;
+    m_uTriangleCount = 0u;
+
+    std::fill(m_vLevels[0].begin(), m_vLevels[0].end(), DEPTH_CLEAR);
+}
+
+void OcclusionCuller::rasterize(const OccluderMesh& mesh, const glm::mat4& transform)
+{
+    rasterize(mesh.m_vPositions.data(), static_cast<uint32_t>(mesh.m_vPositions.size()), mesh.m_vIndices.data(), static_cast<uint32_t>(mesh.m_vIndices.size()), transform);
+}
+
+void OcclusionCuller::rasterize(const glm::vec3* positions, uint32_t positionCount, const uint32_t* indices, uint32_t indexCount, const glm::mat4& transform)
+{
+    assert(indexCount % 3u == 0u);
+
+    if (m_vClipPositions.size() < positionCount)
+        m_vClipPositions.resize(positionCount);
+
+    const glm::mat4 modelViewProjection = m_m4ViewProjection * transform;
+    for (uint32_t i = 0; i < positionCount; ++i)
+        m_vClipPositions[i] = modelViewProjection * glm::vec4(positions[i], 1.0f);
+
+    for (uint32_t i = 0; i < indexCount; i += 3u)
+    {
+        assert(indices[i] < positionCount && indices[i + 1u] < positionCount && indices[i + 2u] < positionCount);
+
+        const glm::vec4& v0 = m_vClipPositions[indices[i]];
+        const glm::vec4& v1 = m_vClipPositions[indices[i + 1u]];
+        const glm::vec4& v2 = m_vClipPositions[indices[i + 2u]];
+
+        // Entirely outside one side plane, these half-spaces hold for any w so no division is needed
+        if ((v0.x > v0.w && v1.x > v1.w && v2.x > v2.w) || (v0.x < -v0.w && v1.x < -v1.w && v2.x < -v2.w) ||
+            (v0.y > v0.w && v1.y > v1.w && v2.y > v2.w) || (v0.y < -v0.w && v1.y < -v1.w && v2.y < -v2.w))
+            continue;
+
+        const float d0 = getNearDistance(v0);
+        const float d1 = getNearDistance(v1);
+        const float d2 = getNearDistance(v2);
+
+        if (d0 < 0.0f && d1 < 0.0f && d2 < 0.0f)
+            continue;
+
+        if (d0 >= 0.0f && d1 >= 0.0f && d2 >= 0.0f)
+            rasterizeTriangle(v0, v1, v2);
+        else
+            rasterizeClipped(v0, v1, v2);
+    }
+}
+
+void OcclusionCuller::rasterizeClipped(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    // Sutherland-Hodgman against the near plane only, one triangle in, a triangle or a quad out
+    const glm::vec4 in[3] = { v0, v1, v2 };
+    const float distances[3] = { getNearDistance(v0), getNearDistance(v1), getNearDistance(v2) };
+
+    glm::vec4 out[4];
+    uint32_t outCount = 0u;
+
+    for (uint32_t i = 0; i < 3u; ++i)
+    {
+        const uint32_t j = (i + 1u) % 3u;
+
+        if (distances[i] >= 0.0f)
+            out[outCount++] = in[i];
+
+        if ((distances[i] >= 0.0f) != (distances[j] >= 0.0f))
+        {
+            const float t = distances[i] / (distances[i] - distances[j]);
+            out[outCount++] = in[i] + (in[j] - in[i]) * t;
+        }
+    }
+
+    for (uint32_t i = 1; i + 1u < outCount; ++i)
+        rasterizeTriangle(out[0], out[i], out[i + 1u]);
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    glm::vec3 p0 = toScreen(v0);
+    glm::vec3 p1 = toScreen(v1);
+    glm::vec3 p2 = toScreen(v2);
+
+    // Occluders are two-sided, the winding is only made consistent for the edge functions
+    float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+    if (!(std::abs(area) > 1e-6f))
+        return;
+
+    if (area < 0.0f)
+    {
+        std::swap(p1, p2);
+        area = -area;
+    }
+
+    // Pixels whose center lies within the triangle's bounding box, clamped in float before the conversion
+    const float minXf = std::max(std::min({ p0.x, p1.x, p2.x }) - 0.5f, 0.0f);
+    const float maxXf = std::min(std::max({ p0.x, p1.x, p2.x }) - 0.5f, static_cast<float>(WIDTH - 1u));
+    const float minYf = std::max(std::min({ p0.y, p1.y, p2.y }) - 0.5f, 0.0f);
+    const float maxYf = std::min(std::max({ p0.y, p1.y, p2.y }) - 0.5f, static_cast<float>(HEIGHT - 1u));
+
+    if (minXf > maxXf || minYf > maxYf)
+        return;
+
+    const int32_t minX = static_cast<int32_t>(std::ceil(minXf));
+    const int32_t maxX = static_cast<int32_t>(maxXf);
+    const int32_t minY = static_cast<int32_t>(std::ceil(minYf));
+    const int32_t maxY = static_cast<int32_t>(maxYf);
+
+    if (minX > maxX || minY > maxY)
+        return;
+
+    ++m_uTriangleCount;
+
+    // Each edge function is the area opposite to one vertex, so edge / area is that vertex's barycentric
+    const PlaneEquation e0 = makeEdge(p1, p2);
+    const PlaneEquation e1 = makeEdge(p2, p0);
+    const PlaneEquation e2 = makeEdge(p0, p1);
+
+    const float invArea = 1.0f / area;
+    const PlaneEquation z {
+        (e0.a * p0.z + e1.a * p1.z + e2.a * p2.z) * invArea,
+        (e0.b * p0.z + e1.b * p1.z + e2.b * p2.z) * invArea,
+        (e0.c * p0.z + e1.c * p1.z + e2.c * p2.z) * invArea,
+    };
+
+    float* depth = m_vLevels[0].data();
+
+    // Rows start on a multiple of 4 pixels so every load and store is aligned
+    const int32_t startX = minX & ~3;
+
+#if OCCLUSION_CULLER_X86
+    const __m128 laneX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 startXs = _mm_add_ps(_mm_set1_ps(static_cast<float>(startX)), laneX);
+
+    const __m128 e0Step = _mm_set1_ps(e0.a * 4.0f);
+    const __m128 e1Step = _mm_set1_ps(e1.a * 4.0f);
+    const __m128 e2Step = _mm_set1_ps(e2.a * 4.0f);
+    const __m128 zStep = _mm_set1_ps(z.a * 4.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int32_t y = minY; y <= maxY; ++y)
+    {
+        const float centerY = static_cast<float>(y) + 0.5f;
+
+        __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0.a), startXs), _mm_set1_ps(e0.b * centerY + e0.c));
+        __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1.a), startXs), _mm_set1_ps(e1.b * centerY + e1.c));
+        __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2.a), startXs), _mm_set1_ps(e2.b * centerY + e2.c));
+        __m128 depths = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(z.a), startXs), _mm_set1_ps(z.b * centerY + z.c));
+
+        float* row = depth + y * static_cast<int32_t>(WIDTH);
+
+        for (int32_t x = startX; x <= maxX; x += 4)
+        {
+            const __m128 inside = _mm_cmpge_ps(_mm_min_ps(w0, _mm_min_ps(w1, w2)), zero);
+
+            if (_mm_movemask_ps(inside) != 0)
+            {
+                const __m128 current = _mm_load_ps(row + x);
+                const __m128 nearest = _mm_min_ps(current, depths);
+                _mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+
+            w0 = _mm_add_ps(w0, e0Step);
+            w1 = _mm_add_ps(w1, e1Step);
+            w2 = _mm_add_ps(w2, e2Step);
+            depths = _mm_add_ps(depths, zStep);
+        }
+    }
+#else
+    for (int32_t y = minY; y <= maxY; ++y)
+    {
+        const float centerY = static_cast<float>(y) + 0.5f;
+        float* row = depth + y * static_cast<int32_t>(WIDTH);
+
+        for (int32_t x = startX; x <= maxX; ++x)
+        {
+            const float centerX = static_cast<float>(x) + 0.5f;
+            const float w0 = e0.a * centerX + e0.b * centerY + e0.c;
+            const float w1 = e1.a * centerX + e1.b * centerY + e1.c;
+            const float w2 = e2.a * centerX + e2.b * centerY + e2.c;
+
+            if (std::min(w0, std::min(w1, w2)) >= 0.0f)
+                row[x] = std::min(row[x], z.a * centerX + z.b * centerY + z.c);
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::end()
+{
+    for (uint32_t level = 1; level < LEVEL_COUNT; ++level)
+    {
+        const float* src = m_vLevels[level - 1u].data();
+        const uint32_t srcWidth = getLevelWidth(level - 1u);
+        const uint32_t srcHeight = getLevelHeight(level - 1u);
+
+        float* dst = m_vLevels[level].data();
+        const uint32_t width = getLevelWidth(level);
+        const uint32_t height = getLevelHeight(level);
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const float* row0 = src + (2u * y) * srcWidth;
+            const float* row1 = src + std::min(2u * y + 1u, srcHeight - 1u) * srcWidth;
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t x0 = 2u * x;
+                const uint32_t x1 = std::min(x0 + 1u, srcWidth - 1u);
+                dst[y * width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const glm::vec3& center, const glm::vec3& extents) const
+{
+    // Corners are the projected center plus or minus the projected axes
+    const glm::vec4 clipCenter = m_m4ViewProjection * glm::vec4(center, 1.0f);
+    const glm::vec4 axisX = m_m4ViewProjection[0] * extents.x;
+    const glm::vec4 axisY = m_m4ViewProjection[1] * extents.y;
+    const glm::vec4 axisZ = m_m4ViewProjection[2] * extents.z;
+
+    // Normalized device coordinates first, the conversion to pixels is monotonic
+    float minX;
+    float minY;
+    float minZ;
+    float maxX;
+    float maxY;
+
+#if OCCLUSION_CULLER_X86
+    // All eight corners at once, lanes hold corners 0-3 (-z axis) and 4-7 (+z axis), one register per component
+    const __m128 signX = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    const __m128 signY = _mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+
+    __m128 low[4];
+    __m128 high[4];
+    for (int32_t component = 0; component < 4; ++component)
+    {
+        const __m128 base = _mm_add_ps(_mm_set1_ps(clipCenter[component]),
+                                       _mm_add_ps(_mm_mul_ps(signX, _mm_set1_ps(axisX[component])), _mm_mul_ps(signY, _mm_set1_ps(axisY[component]))));
+        const __m128 offsetZ = _mm_set1_ps(axisZ[component]);
+        low[component] = _mm_sub_ps(base, offsetZ);
+        high[component] = _mm_add_ps(base, offsetZ);
+    }
+
+#ifdef GLM_FORCE_DEPTH_ZERO_TO_ONE
+    const __m128 nearLow = low[2];
+    const __m128 nearHigh = high[2];
+#else
+    const __m128 nearLow = _mm_add_ps(low[2], low[3]);
+    const __m128 nearHigh = _mm_add_ps(high[2], high[3]);
+#endif
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 behind = _mm_or_ps(_mm_or_ps(_mm_cmple_ps(nearLow, zero), _mm_cmple_ps(nearHigh, zero)),
+                                    _mm_or_ps(_mm_cmple_ps(low[3], zero), _mm_cmple_ps(high[3], zero)));
+    if (_mm_movemask_ps(behind) != 0)
+        return true;
+
+    const __m128 invWLow = _mm_div_ps(_mm_set1_ps(1.0f), low[3]);
+    const __m128 invWHigh = _mm_div_ps(_mm_set1_ps(1.0f), high[3]);
+
+    const __m128 xLow = _mm_mul_ps(low[0], invWLow);
+    const __m128 xHigh = _mm_mul_ps(high[0], invWHigh);
+    const __m128 yLow = _mm_mul_ps(low[1], invWLow);
+    const __m128 yHigh = _mm_mul_ps(high[1], invWHigh);
+
+    minX = getHorizontalMin(_mm_min_ps(xLow, xHigh));
+    maxX = getHorizontalMax(_mm_max_ps(xLow, xHigh));
+    minY = getHorizontalMin(_mm_min_ps(yLow, yHigh));
+    maxY = getHorizontalMax(_mm_max_ps(yLow, yHigh));
+    minZ = getHorizontalMin(_mm_min_ps(_mm_mul_ps(low[2], invWLow), _mm_mul_ps(high[2], invWHigh)));
+#else
+    minX = minY = minZ = FLT_MAX;
+    maxX = maxY = -FLT_MAX;
+
+    for (uint32_t corner = 0; corner < 8u; ++corner)
+    {
+        const glm::vec4 clip = clipCenter + ((corner & 1u) ? axisX : -axisX) + ((corner & 2u) ? axisY : -axisY) + ((corner & 4u) ? axisZ : -axisZ);
+
+        if (getNearDistance(clip) <= 0.0f || clip.w <= 0.0f)
+            return true;
+
+        const float invW = 1.0f / clip.w;
+        minX = std::min(minX, clip.x * invW);
+        maxX = std::max(maxX, clip.x * invW);
+        minY = std::min(minY, clip.y * invW);
+        maxY = std::max(maxY, clip.y * invW);
+        minZ = std::min(minZ, clip.z * invW);
+    }
+#endif
+
+    minX = (minX * 0.5f + 0.5f) * static_cast<float>(WIDTH);
+    maxX = (maxX * 0.5f + 0.5f) * static_cast<float>(WIDTH);
+    minY = (minY * 0.5f + 0.5f) * static_cast<float>(HEIGHT);
+    maxY = (maxY * 0.5f + 0.5f) * static_cast<float>(HEIGHT);
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(WIDTH) || minY >= static_cast<float>(HEIGHT))
+        return true;
+
+    // Every pixel the rectangle touches
+    const uint32_t pixelMinX = static_cast<uint32_t>(std::max(minX, 0.0f));
+    const uint32_t pixelMaxX = static_cast<uint32_t>(std::min(maxX, static_cast<float>(WIDTH - 1u)));
+    const uint32_t pixelMinY = static_cast<uint32_t>(std::max(minY, 0.0f));
+    const uint32_t pixelMaxY = static_cast<uint32_t>(std::min(maxY, static_cast<float>(HEIGHT - 1u)));
+
+    // Smallest level where the rectangle spans at most 2x2 texels
+    uint32_t level = 0u;
+    while (level + 1u < LEVEL_COUNT && ((pixelMaxX >> level) - (pixelMinX >> level) > 1u || (pixelMaxY >> level) - (pixelMinY >> level) > 1u))
+        ++level;
+
+    const float* depth = m_vLevels[level].data();
+    const uint32_t width = getLevelWidth(level);
+
+    for (uint32_t y = pixelMinY >> level; y <= (pixelMaxY >> level); ++y)
+    {
+        for (uint32_t x = pixelMinX >> level; x <= (pixelMaxX >> level); ++x)
+        {
+            if (minZ <= depth[y * width + x])
+                return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t OcclusionCuller::cull(const FrustumCuller& culler, uint32_t* visible, uint32_t visibleCount) const
+{
+    return cullBy([&culler](uint32_t index) { return culler.getBounds(index); }, visible, visibleCount);
+}
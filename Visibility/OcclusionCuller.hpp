@@ -0,0 +1,109 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "Bounds.hpp"
+#include "../AlignedAllocator.hpp"
+
+class FrustumCuller;
+
+// Triangle list kept on the CPU for rasterization, usually a simplified stand-in for the rendered mesh
+struct OccluderMesh
+{
+    std::vector<glm::vec3> m_vPositions;
+    std::vector<uint32_t> m_vIndices;
+
+    bool isEmpty() const { return m_vIndices.empty(); }
+};
+
+/**
+ * Software occlusion culling, the prepass from Notes.txt done on the CPU.
+ *
+ * Occluder triangles are rasterized into a small depth buffer that keeps the nearest depth per pixel, four
+ * pixels at a time with SSE. end() then builds a hierarchy on top of it where every texel holds the farthest
+ * depth of the four below, so a texel says "everything behind this depth is hidden over my whole area".
+ * An occludee is projected to its screen-space rectangle and nearest depth, and is hidden when that depth is
+ * behind every texel of the smallest level where the rectangle covers at most 2x2 texels.
+ *
+ * Depth is clip z / w of the same view-projection as the frustum, only compared, never interpreted, so both
+ * depth ranges work. Occluder pixels are covered when their center is inside a triangle, like on the GPU, the
+ * rest errs on the visible side: boxes crossing the near plane or off the screen are visible, uncovered
+ * pixels are infinitely far.
+ *
+ * Meant to run after frustum culling on the surviving objects, occluders are usually taken from them as well.
+ * No Vulkan dependency, see Bench/OcclusionCullBench.cpp.
+ */
+class OcclusionCuller
+{
+public:
+    static constexpr uint32_t WIDTH = 256u;
+    static constexpr uint32_t HEIGHT = 128u;
+
+    // 256x128 down to 1x1
+    static constexpr uint32_t LEVEL_COUNT = 9u;
+
+    static constexpr uint32_t getLevelWidth(uint32_t level) { return (WIDTH >> level) > 0u ? (WIDTH >> level) : 1u; }
+    static constexpr uint32_t getLevelHeight(uint32_t level) { return (HEIGHT >> level) > 0u ? (HEIGHT >> level) : 1u; }
+
+    OcclusionCuller();
+
+    // Clears the depth buffer, occluders and occludees of this frame are projected with viewProjection
+    void begin(const glm::mat4& viewProjection);
+
+    // Between begin() and end(), transform takes the mesh to world space
+    void rasterize(const OccluderMesh& mesh, const glm::mat4& transform);
+    void rasterize(const glm::vec3* positions, uint32_t positionCount, const uint32_t* indices, uint32_t indexCount, const glm::mat4& transform);
+
+    // Builds the max-depth hierarchy, the tests below are valid until the next begin()
+    void end();
+
+    // False only when the whole box is behind occluders, center and extents are world space
+    bool isVisible(const glm::vec3& center, const glm::vec3& extents) const;
+    bool isVisible(const Bounds& bounds) const { return isVisible(bounds.m_v3Center, bounds.m_v3Extents); }
+
+    // Removes the occluded entries of visible (culler indices, e.g. the frustum culling result) in place,
+    // keeps the order and returns how many are left
+    uint32_t cull(const FrustumCuller& culler, uint32_t* visible, uint32_t visibleCount) const;
+
+    // Same for any ids, getBounds(id) returns the world-space Bounds of id
+    template <typename GetBounds>
+    uint32_t cullBy(GetBounds&& getBounds, uint32_t* visible, uint32_t visibleCount) const
+    {
+        uint32_t remaining = 0u;
+        for (uint32_t i = 0; i < visibleCount; ++i)
+        {
+            const uint32_t id = visible[i];
+            visible[remaining] = id;
+            remaining += isVisible(getBounds(id)) ? 1u : 0u;
+        }
+
+        return remaining;
+    }
+
+    // Row-major getLevelWidth(level) x getLevelHeight(level) depths, level 0 is the rasterized buffer
+    const float* getDepth(uint32_t level) const { return m_vLevels[level].data(); }
+
+    // Triangles that reached the rasterizer since begin(), after near plane clipping
+    uint32_t getTriangleCount() const { return m_uTriangleCount; }
+
+private:
+    void rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+    void rasterizeClipped(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+    glm::mat4 m_m4ViewProjection { 1.0f };
+    uint32_t m_uTriangleCount = 0u;
+
+    std::array<CacheAlignedVector<float>, LEVEL_COUNT> m_vLevels;
+
+    // Clip-space positions of the occluder being rasterized, only grows
+    std::vector<glm::vec4> m_vClipPositions;
+};
+
+#endif // OCCLUSION_CULLER_HPP
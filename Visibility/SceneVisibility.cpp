@@ -0,0 +1,32 @@
+#include "SceneVisibility.hpp"
+
+uint32_t SceneVisibility::addDynamic(uint32_t id, const Bounds& bounds)
+{
+    m_vDynamicIds.push_back(id);
+    return m_DynamicCuller.add(bounds);
+}
+
+uint32_t SceneVisibility::cull(const Frustum& frustum, uint32_t* visible) const
+{
+    const uint32_t staticCount = m_StaticBvh.cull(frustum, visible);
+    const uint32_t dynamicCount = m_DynamicCuller.cull(frustum, visible + staticCount);
+
+    return staticCount + remapDynamic(visible + staticCount, dynamicCount);
+}
+
+uint32_t SceneVisibility::cull(const Frustum& frustum, uint32_t* visible, ThreadPool& threadPool, FrustumCuller::ParallelScratch& scratch) const
+{
+    // The tree walk is short next to the dynamic arrays, it stays on the calling thread
+    const uint32_t staticCount = m_StaticBvh.cull(frustum, visible);
+    const uint32_t dynamicCount = m_DynamicCuller.cull(frustum, visible + staticCount, threadPool, scratch);
+
+    return staticCount + remapDynamic(visible + staticCount, dynamicCount);
+}
+
+uint32_t SceneVisibility::remapDynamic(uint32_t* visible, uint32_t count) const
+{
+    for (uint32_t i = 0; i < count; ++i)
+        visible[i] = m_vDynamicIds[visible[i]];
+
+    return count;
+}
@@ -0,0 +1,48 @@
+#ifndef SCENE_VISIBILITY_HPP
+#define SCENE_VISIBILITY_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+#include "FrustumCuller.hpp"
+#include "StaticBvh.hpp"
+
+class ThreadPool;
+
+/**
+ * Every object of the scene, split by how it is culled.
+ *
+ * Static objects (level geometry) go into a StaticBvh once after loading, most of them are rejected or
+ * accepted a whole subtree at a time. Dynamic objects live in the brute-force FrustumCuller arrays, where
+ * moving one is a single set() and culling them scales across threads.
+ *
+ * Both report the same ids (e.g. model indices), cull() writes the visible static ids followed by the
+ * visible dynamic ones.
+ */
+class SceneVisibility
+{
+public:
+    StaticBvh m_StaticBvh;
+
+    // Returns the dynamic index for setDynamic()
+    uint32_t addDynamic(uint32_t id, const Bounds& bounds);
+    void setDynamic(uint32_t dynamicIndex, const Bounds& bounds) { m_DynamicCuller.set(dynamicIndex, bounds); }
+
+    uint32_t getDynamicCount() const { return m_DynamicCuller.size(); }
+    uint32_t size() const { return m_StaticBvh.getObjectCount() + m_DynamicCuller.size(); }
+
+    // visible must have room for size() ids, returns how many were written
+    uint32_t cull(const Frustum& frustum, uint32_t* visible) const;
+    uint32_t cull(const Frustum& frustum, uint32_t* visible, ThreadPool& threadPool, FrustumCuller::ParallelScratch& scratch) const;
+
+private:
+    // Dynamic indices written by the culler are mapped to ids in place
+    uint32_t remapDynamic(uint32_t* visible, uint32_t count) const;
+
+    FrustumCuller m_DynamicCuller;
+    std::vector<uint32_t> m_vDynamicIds;
+};
+
+#endif // SCENE_VISIBILITY_HPP
@@ -0,0 +1,453 @@
+#include "StaticBvh.hpp"
+#include "../Hash.hpp"
+#include "../ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t INVALID_INDEX = ~0u;
+
+    // Ranges of at most max(MIN_JOB_SIZE, count / (threads * JOBS_PER_THREAD)) objects are built as one job,
+    // a few jobs per thread so one lopsided split does not leave the other threads idle
+    constexpr uint32_t MIN_JOB_SIZE = 4096u;
+    constexpr uint32_t JOBS_PER_THREAD = 4u;
+
+    constexpr uint32_t FILE_MAGIC = 0x31485642u; // "BVH1"
+    constexpr uint32_t FILE_VERSION = 1u;
+
+    struct FileHeader
+    {
+        uint32_t m_uMagic;
+        uint32_t m_uVersion;
+        uint64_t m_uSourceKey;
+        uint32_t m_uObjectCount;
+        uint32_t m_uNodeCount; // including the sentinel
+    };
+
+    struct BuildNode
+    {
+        Aabb m_Bounds;
+        uint32_t m_uBegin;
+        uint32_t m_uEnd;
+        uint32_t m_uLeft = INVALID_INDEX; // both children are INVALID_INDEX for leaves
+        uint32_t m_uRight = INVALID_INDEX;
+        uint32_t m_uJob = INVALID_INDEX;  // top of the tree only, the subtree below is built by this job
+    };
+
+    struct BuildJob
+    {
+        uint32_t m_uBegin;
+        uint32_t m_uEnd;
+    };
+
+    struct BuildInput
+    {
+        const Aabb* m_pBoxes;
+        const glm::vec3* m_pCentroids;
+        uint32_t* m_pOrder; // object indices, partitioned in place while splitting
+    };
+
+    float getHalfArea(const Aabb& box)
+    {
+        const glm::vec3 size = box.m_v3Max - box.m_v3Min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    uint32_t getBin(float centroid, float binMin, float binScale)
+    {
+        return std::min(static_cast<uint32_t>((centroid - binMin) * binScale), StaticBvh::BIN_COUNT - 1u);
+    }
+
+    // Partitions [begin, end) along the cheapest SAH split and returns where the right half starts, begin for a leaf
+    uint32_t split(const BuildInput& input, uint32_t begin, uint32_t end, const Aabb& bounds, const Aabb& centroidBounds)
+    {
+        const uint32_t count = end - begin;
+        if (count <= StaticBvh::MIN_LEAF_SIZE)
+            return begin;
+
+        struct Bin
+        {
+            Aabb m_Bounds;
+            uint32_t m_uCount = 0u;
+        };
+
+        // All three axes binned in one pass, an axis without extent keeps everything in its first bin
+        Bin bins[3][StaticBvh::BIN_COUNT];
+        float binScales[3];
+        for (int32_t axis = 0; axis < 3; ++axis)
+        {
+            const float extent = centroidBounds.m_v3Max[axis] - centroidBounds.m_v3Min[axis];
+            binScales[axis] = extent > 0.0f ? static_cast<float>(StaticBvh::BIN_COUNT) / extent : 0.0f;
+        }
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const uint32_t object = input.m_pOrder[i];
+            const glm::vec3& centroid = input.m_pCentroids[object];
+
+            for (int32_t axis = 0; axis < 3; ++axis)
+            {
+                Bin& bin = bins[axis][getBin(centroid[axis], centroidBounds.m_v3Min[axis], binScales[axis])];
+                bin.m_Bounds.expand(input.m_pBoxes[object]);
+                ++bin.m_uCount;
+            }
+        }
+
+        float bestCost = FLT_MAX;
+        int32_t bestAxis = -1;
+        uint32_t bestBin = 0u;
+
+        for (int32_t axis = 0; axis < 3; ++axis)
+        {
+            if (binScales[axis] == 0.0f)
+                continue;
+
+            // Right to left stores the right side of every plane, left to right then completes the costs
+            float rightArea[StaticBvh::BIN_COUNT];
+            uint32_t rightCount[StaticBvh::BIN_COUNT];
+
+            Aabb accumulated;
+            uint32_t accumulatedCount = 0u;
+            for (uint32_t bin = StaticBvh::BIN_COUNT - 1u; bin > 0u; --bin)
+            {
+                accumulated.expand(bins[axis][bin].m_Bounds);
+                accumulatedCount += bins[axis][bin].m_uCount;
+                rightArea[bin] = getHalfArea(accumulated);
+                rightCount[bin] = accumulatedCount;
+            }
+
+            accumulated = Aabb();
+            accumulatedCount = 0u;
+            for (uint32_t bin = 0; bin + 1u < StaticBvh::BIN_COUNT; ++bin)
+            {
+                accumulated.expand(bins[axis][bin].m_Bounds);
+                accumulatedCount += bins[axis][bin].m_uCount;
+
+                if (accumulatedCount == 0u || rightCount[bin + 1u] == 0u)
+                    continue;
+
+                const float cost = getHalfArea(accumulated) * accumulatedCount + rightArea[bin + 1u] * rightCount[bin + 1u];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                }
+            }
+        }
+
+        // Every centroid in one point, nothing to split on but the count
+        if (bestAxis < 0)
+            return count <= StaticBvh::MAX_LEAF_SIZE ? begin : begin + count / 2u;
+
+        // One traversal step plus the expected object tests of both children against testing every object here
+        const float splitCost = 1.0f + bestCost / std::max(getHalfArea(bounds), FLT_MIN);
+        if (count <= StaticBvh::MAX_LEAF_SIZE && splitCost >= static_cast<float>(count))
+            return begin;
+
+        const float binMin = centroidBounds.m_v3Min[bestAxis];
+        const float binScale = binScales[bestAxis];
+
+        uint32_t* middle = std::partition(input.m_pOrder + begin, input.m_pOrder + end, [&](uint32_t object) {
+            return getBin(input.m_pCentroids[object][bestAxis], binMin, binScale) <= bestBin;
+        });
+
+        const uint32_t mid = static_cast<uint32_t>(middle - input.m_pOrder);
+        assert(mid > begin && mid < end);
+        return mid;
+    }
+
+    // jobs != nullptr builds the top of the tree, ranges of at most jobSize objects become jobs instead of subtrees
+    uint32_t buildNode(const BuildInput& input, std::vector<BuildNode>& nodes, std::vector<BuildJob>* jobs, uint32_t jobSize, uint32_t begin, uint32_t end)
+    {
+        const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+
+        Aabb bounds;
+        Aabb centroidBounds;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const uint32_t object = input.m_pOrder[i];
+            bounds.expand(input.m_pBoxes[object]);
+            centroidBounds.expand(input.m_pCentroids[object]);
+        }
+
+        nodes[nodeIndex].m_Bounds = bounds;
+        nodes[nodeIndex].m_uBegin = begin;
+        nodes[nodeIndex].m_uEnd = end;
+
+        if (jobs != nullptr && end - begin <= jobSize)
+        {
+            nodes[nodeIndex].m_uJob = static_cast<uint32_t>(jobs->size());
+            jobs->push_back({ begin, end });
+            return nodeIndex;
+        }
+
+        const uint32_t mid = split(input, begin, end, bounds, centroidBounds);
+        if (mid != begin)
+        {
+            const uint32_t left = buildNode(input, nodes, jobs, jobSize, begin, mid);
+            const uint32_t right = buildNode(input, nodes, jobs, jobSize, mid, end);
+
+            nodes[nodeIndex].m_uLeft = left;
+            nodes[nodeIndex].m_uRight = right;
+        }
+
+        return nodeIndex;
+    }
+
+    // Depth-first, a job node is replaced by the root of the job's subtree
+    void flatten(const std::vector<BuildNode>& nodes, uint32_t nodeIndex, const std::vector<std::vector<BuildNode>>& jobNodes, std::vector<StaticBvh::Node>& flatNodes)
+    {
+        const BuildNode& node = nodes[nodeIndex];
+
+        if (node.m_uJob != INVALID_INDEX)
+        {
+            flatten(jobNodes[node.m_uJob], 0u, jobNodes, flatNodes);
+            return;
+        }
+
+        const uint32_t flatIndex = static_cast<uint32_t>(flatNodes.size());
+        flatNodes.push_back({ node.m_Bounds.m_v3Min, node.m_uBegin, node.m_Bounds.m_v3Max, 0u });
+
+        if (node.m_uLeft != INVALID_INDEX)
+        {
+            flatten(nodes, node.m_uLeft, jobNodes, flatNodes);
+            flatten(nodes, node.m_uRight, jobNodes, flatNodes);
+        }
+
+        flatNodes[flatIndex].m_uSkip = static_cast<uint32_t>(flatNodes.size());
+    }
+
+    // Same combined sphere/box test as FrustumCuller
+    bool intersects(const Frustum& frustum, const Bounds& bounds)
+    {
+        for (const glm::vec4& plane : frustum.m_vPlanes)
+        {
+            const float distance = plane.x * bounds.m_v3Center.x + plane.y * bounds.m_v3Center.y + plane.z * bounds.m_v3Center.z + plane.w;
+            const float boxRadius = std::abs(plane.x) * bounds.m_v3Extents.x + std::abs(plane.y) * bounds.m_v3Extents.y + std::abs(plane.z) * bounds.m_v3Extents.z;
+
+            if (distance + std::min(bounds.m_fRadius, boxRadius) < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+void StaticBvh::build(const Bounds* bounds, const uint32_t* ids, uint32_t count, ThreadPool* threadPool)
+{
+    clear();
+
+    if (count == 0u)
+        return;
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+
+    std::vector<Aabb> boxes(count);
+    std::vector<glm::vec3> centroids(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        boxes[i].m_v3Min = bounds[i].m_v3Center - bounds[i].m_v3Extents;
+        boxes[i].m_v3Max = bounds[i].m_v3Center + bounds[i].m_v3Extents;
+        centroids[i] = bounds[i].m_v3Center;
+    }
+
+    const BuildInput input { boxes.data(), centroids.data(), order.data() };
+
+    const uint32_t threadCount = threadPool != nullptr ? threadPool->getThreadCount() : 1u;
+    const uint32_t jobSize = std::max(MIN_JOB_SIZE, count / (threadCount * JOBS_PER_THREAD));
+
+    std::vector<BuildNode> topNodes;
+    std::vector<BuildJob> jobs;
+    buildNode(input, topNodes, &jobs, jobSize, 0u, count);
+
+    // Jobs own disjoint ranges of order, so they partition it without stepping on each other
+    std::vector<std::vector<BuildNode>> jobNodes(jobs.size());
+    const auto buildJob = [&](uint32_t jobIdx) {
+        const BuildJob& job = jobs[jobIdx];
+        jobNodes[jobIdx].reserve(2u * ((job.m_uEnd - job.m_uBegin) / MAX_LEAF_SIZE + 1u));
+        buildNode(input, jobNodes[jobIdx], nullptr, 0u, job.m_uBegin, job.m_uEnd);
+    };
+
+    if (threadPool != nullptr && jobs.size() > 1u)
+    {
+        threadPool->parallelFor(static_cast<uint32_t>(jobs.size()), buildJob);
+    }
+    else
+    {
+        for (uint32_t jobIdx = 0; jobIdx < jobs.size(); ++jobIdx)
+            buildJob(jobIdx);
+    }
+
+    size_t nodeCount = topNodes.size();
+    for (const std::vector<BuildNode>& nodes : jobNodes)
+        nodeCount += nodes.size();
+
+    m_vNodes.reserve(nodeCount + 1u);
+    flatten(topNodes, 0u, jobNodes, m_vNodes);
+    m_vNodes.push_back({ glm::vec3(0.0f), count, glm::vec3(0.0f), INVALID_INDEX });
+
+    m_vIds.resize(count);
+    m_vBounds.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_vIds[i] = ids[order[i]];
+        m_vBounds[i] = bounds[order[i]];
+    }
+}
+
+void StaticBvh::clear()
+{
+    m_vNodes.clear();
+    m_vIds.clear();
+    m_vBounds.clear();
+}
+
+uint32_t StaticBvh::cull(const Frustum& frustum, uint32_t* visible) const
+{
+    const uint32_t nodeCount = getNodeCount();
+
+    uint32_t visibleCount = 0u;
+    uint32_t nodeIndex = 0u;
+
+    while (nodeIndex < nodeCount)
+    {
+        const Node& node = m_vNodes[nodeIndex];
+        const glm::vec3 center = (node.m_v3Min + node.m_v3Max) * 0.5f;
+        const glm::vec3 extents = (node.m_v3Max - node.m_v3Min) * 0.5f;
+
+        bool outside = false;
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.m_vPlanes)
+        {
+            const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            const float radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+
+            if (distance + radius < 0.0f)
+            {
+                outside = true;
+                break;
+            }
+
+            inside &= distance - radius >= 0.0f;
+        }
+
+        if (outside)
+        {
+            nodeIndex = node.m_uSkip;
+            continue;
+        }
+
+        const uint32_t firstObject = node.m_uFirstObject;
+        const uint32_t endObject = m_vNodes[node.m_uSkip].m_uFirstObject;
+
+        if (inside)
+        {
+            memcpy(visible + visibleCount, m_vIds.data() + firstObject, (endObject - firstObject) * sizeof(uint32_t));
+            visibleCount += endObject - firstObject;
+            nodeIndex = node.m_uSkip;
+            continue;
+        }
+
+        if (node.m_uSkip == nodeIndex + 1u)
+        {
+            for (uint32_t object = firstObject; object < endObject; ++object)
+            {
+                visible[visibleCount] = m_vIds[object];
+                visibleCount += intersects(frustum, m_vBounds[object]) ? 1u : 0u;
+            }
+        }
+
+        // First child, or past the leaf
+        ++nodeIndex;
+    }
+
+    return visibleCount;
+}
+
+uint64_t StaticBvh::computeSourceKey(const Bounds* bounds, const uint32_t* ids, uint32_t count)
+{
+    uint64_t key = Hash::SEED;
+    key = Hash::value(key, count);
+    key = Hash::bytes(key, bounds, count * sizeof(Bounds));
+    key = Hash::bytes(key, ids, count * sizeof(uint32_t));
+    return key;
+}
+
+bool StaticBvh::save(const char* filename, uint64_t sourceKey) const
+{
+    FILE* f = fopen(filename, "wb");
+    if (f == nullptr)
+        return false;
+
+    const FileHeader header { FILE_MAGIC, FILE_VERSION, sourceKey, getObjectCount(), static_cast<uint32_t>(m_vNodes.size()) };
+
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1u;
+    written = written && fwrite(m_vNodes.data(), sizeof(Node), m_vNodes.size(), f) == m_vNodes.size();
+    written = written && fwrite(m_vIds.data(), sizeof(uint32_t), m_vIds.size(), f) == m_vIds.size();
+    written = written && fwrite(m_vBounds.data(), sizeof(Bounds), m_vBounds.size(), f) == m_vBounds.size();
+
+    written = (fclose(f) == 0) && written;
+    if (!written)
+        remove(filename);
+
+    return written;
+}
+
+bool StaticBvh::load(const char* filename, uint64_t sourceKey)
+{
+    clear();
+
+    FILE* f = fopen(filename, "rb");
+    if (f == nullptr)
+        return false;
+
+    FileHeader header {};
+    bool valid = fread(&header, sizeof(header), 1, f) == 1u;
+    valid = valid && header.m_uMagic == FILE_MAGIC && header.m_uVersion == FILE_VERSION && header.m_uSourceKey == sourceKey;
+
+    // The counts decide the allocations below, so they have to agree with the file size first
+    if (valid)
+    {
+        const long expectedSize = static_cast<long>(sizeof(FileHeader) + header.m_uNodeCount * sizeof(Node) +
+                                                    header.m_uObjectCount * (sizeof(uint32_t) + sizeof(Bounds)));
+        valid = fseek(f, 0, SEEK_END) == 0 && ftell(f) == expectedSize && fseek(f, sizeof(FileHeader), SEEK_SET) == 0;
+        valid = valid && header.m_uNodeCount > 0u;
+    }
+
+    if (valid)
+    {
+        m_vNodes.resize(header.m_uNodeCount);
+        m_vIds.resize(header.m_uObjectCount);
+        m_vBounds.resize(header.m_uObjectCount);
+
+        valid = fread(m_vNodes.data(), sizeof(Node), m_vNodes.size(), f) == m_vNodes.size();
+        valid = valid && fread(m_vIds.data(), sizeof(uint32_t), m_vIds.size(), f) == m_vIds.size();
+        valid = valid && fread(m_vBounds.data(), sizeof(Bounds), m_vBounds.size(), f) == m_vBounds.size();
+        valid = valid && m_vNodes.back().m_uFirstObject == header.m_uObjectCount;
+
+        // cull() trusts the skip links and object ranges
+        const uint32_t nodeCount = header.m_uNodeCount - 1u;
+        for (uint32_t i = 0; valid && i < nodeCount; ++i)
+        {
+            const Node& node = m_vNodes[i];
+            valid = node.m_uSkip > i && node.m_uSkip <= nodeCount && node.m_uFirstObject <= m_vNodes[node.m_uSkip].m_uFirstObject;
+        }
+    }
+
+    fclose(f);
+
+    if (!valid)
+        clear();
+
+    return valid;
+}
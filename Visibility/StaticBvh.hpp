@@ -0,0 +1,77 @@
+#ifndef STATIC_BVH_HPP
+#define STATIC_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+
+class ThreadPool;
+
+/**
+ * Bounding volume hierarchy over objects that never move, built once at load time.
+ *
+ * The build splits with the surface area heuristic over BIN_COUNT centroid bins per axis. The top of the tree is
+ * split on the calling thread until every remaining range is small enough to be one job, the subtrees are then
+ * built in parallel and stitched together.
+ *
+ * The result is a flat array of nodes in depth-first order. The first child of an internal node is the next
+ * node and m_uSkip is the node after the whole subtree, so cull() walks the array front to back without a stack
+ * and jumps over rejected subtrees. Objects are stored in leaf order, so every subtree owns a contiguous range
+ * of them and a subtree that is entirely inside the frustum is copied out without further tests.
+ *
+ * save()/load() write the arrays as they are (native endianness), tagged with a key of the input, so a level
+ * only pays the build once and a stale file is detected instead of used.
+ */
+class StaticBvh
+{
+public:
+    // Two per cache line
+    struct Node
+    {
+        glm::vec3 m_v3Min;
+        uint32_t m_uFirstObject; // the subtree's objects are [m_uFirstObject, nodes[m_uSkip].m_uFirstObject)
+        glm::vec3 m_v3Max;
+        uint32_t m_uSkip;        // index + 1 for leaves
+    };
+
+    static_assert(sizeof(Node) == 32u, "Node is expected to fill half a cache line");
+
+    static constexpr uint32_t BIN_COUNT = 16u;
+
+    // Ranges up to MIN_LEAF_SIZE objects are always leaves, up to MAX_LEAF_SIZE when SAH prefers it
+    static constexpr uint32_t MIN_LEAF_SIZE = 4u;
+    static constexpr uint32_t MAX_LEAF_SIZE = 8u;
+
+    // ids are what cull() reports (e.g. model indices), bounds are world space
+    void build(const Bounds* bounds, const uint32_t* ids, uint32_t count, ThreadPool* threadPool = nullptr);
+    void clear();
+
+    // visible must have room for getObjectCount() ids, returns how many were written. Order is the leaf order.
+    uint32_t cull(const Frustum& frustum, uint32_t* visible) const;
+
+    // Identifies the input of build(), changes with any bound or id
+    static uint64_t computeSourceKey(const Bounds* bounds, const uint32_t* ids, uint32_t count);
+
+    bool save(const char* filename, uint64_t sourceKey) const;
+    // False and left empty when the file is missing, damaged or was saved for another sourceKey
+    bool load(const char* filename, uint64_t sourceKey);
+
+    uint32_t getObjectCount() const { return static_cast<uint32_t>(m_vIds.size()); }
+    uint32_t getNodeCount() const { return m_vNodes.empty() ? 0u : static_cast<uint32_t>(m_vNodes.size()) - 1u; }
+
+    const std::vector<Node>& getNodes() const { return m_vNodes; }
+
+private:
+    // Ends with a sentinel whose m_uFirstObject is the object count, so m_uSkip can always be dereferenced
+    std::vector<Node> m_vNodes;
+
+    // Leaf order
+    std::vector<uint32_t> m_vIds;
+    std::vector<Bounds> m_vBounds;
+};
+
+#endif // STATIC_BVH_HPP
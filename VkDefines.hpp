@@ -36,11 +36,14 @@ struct VulkanResources
     VkQueue m_VkGraphicsQueue;
 
     VkPhysicalDeviceMemoryProperties m_VkPhysicalDeviceMemProps;
+    bool m_bMultiDrawIndirect;
+    bool m_bDrawIndirectFirstInstance;
 
     PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR;
     PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR;
     PFN_vkQueueSubmit2KHR vkQueueSubmit2KHR;
     PFN_vkCmdPipelineBarrier2KHR vkCmdPipelineBarrier2KHR;
+    PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR; // nullptr without VK_KHR_draw_indirect_count
 };
 
 #endif // VK_DEFINES_HPP
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "VkFrame.hpp"
 #include "VkRuntime.hpp"
 #include "VkDefines.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
 
 VulkanResources* VkFrame::m_pVkResources = nullptr; 
 
@@ -17,7 +20,7 @@ VkFrame::VkFrame()
     m_VkCommandBufferIsExecutableFence = VK_NULL_HANDLE;
 }
 
-void VkFrame::init()
+void VkFrame::init(uint32_t recordingThreadCount)
 {
     for (uint32_t i = 0; i < m_VkCommandPools.size(); ++i)
     {
@@ -25,6 +28,19 @@ void VkFrame::init()
         m_VkCommandBuffers[i] = createCommandBuffer(m_pVkResources->m_VkDevice, m_VkCommandPools[i]);
     }
 
+    m_vVkSecondaryCommandPools.resize(recordingThreadCount);
+    m_vVkSecondaryCommandBuffers.resize(recordingThreadCount);
+    m_vSecondaryRecordStats.resize(recordingThreadCount);
+
+    for (uint32_t i = 0; i < recordingThreadCount; ++i)
+    {
+        m_vVkSecondaryCommandPools[i] = createCommandPool(m_pVkResources->m_VkDevice, m_pVkResources->m_uGraphicsQueueFamilyIndex);
+        m_vVkSecondaryCommandBuffers[i] = createCommandBuffer(m_pVkResources->m_VkDevice, m_vVkSecondaryCommandPools[i], VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+    }
+
+    m_IndirectBuffer.create(INDIRECT_BUFFER_SIZE, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    m_InstanceBuffer.create(INSTANCE_BUFFER_SIZE, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
     m_VkAcquireCompleteSemaphore = createSemaphore(m_pVkResources->m_VkDevice);
     m_VkRenderCompleteSemaphore = createSemaphore(m_pVkResources->m_VkDevice);
     m_VkCommandBufferIsExecutableFence = createFence(m_pVkResources->m_VkDevice, true);
@@ -35,6 +51,15 @@ void VkFrame::cleanup()
     for (VkCommandPool commandPool : m_VkCommandPools)
         vkDestroyCommandPool(m_pVkResources->m_VkDevice, commandPool, nullptr);
 
+    for (VkCommandPool commandPool : m_vVkSecondaryCommandPools)
+        vkDestroyCommandPool(m_pVkResources->m_VkDevice, commandPool, nullptr);
+
+    m_vVkSecondaryCommandPools.clear();
+    m_vVkSecondaryCommandBuffers.clear();
+
+    m_IndirectBuffer.destroy();
+    m_InstanceBuffer.destroy();
+
     vkDestroySemaphore(m_pVkResources->m_VkDevice, m_VkAcquireCompleteSemaphore, nullptr);
     vkDestroySemaphore(m_pVkResources->m_VkDevice, m_VkRenderCompleteSemaphore, nullptr);
     vkDestroyFence(m_pVkResources->m_VkDevice, m_VkCommandBufferIsExecutableFence, nullptr);
@@ -49,6 +74,12 @@ void VkFrame::resetCommandPools()
 {
     for (VkCommandPool commandPool : m_VkCommandPools)
         vkResetCommandPool(m_pVkResources->m_VkDevice, commandPool, 0x0);
+
+    for (VkCommandPool commandPool : m_vVkSecondaryCommandPools)
+        vkResetCommandPool(m_pVkResources->m_VkDevice, commandPool, 0x0);
+
+    m_IndirectBuffer.reset();
+    m_InstanceBuffer.reset();
 }
 
 void VkFrame::transitionAttachmentsStartOfFrame()
@@ -125,18 +156,8 @@ void VkFrame::transitionAttachmentsEndOfFrame()
 
 
 
-VkCommandBuffer VkFrame::render(const RenderManager& renderer)
+void VkFrame::beginRendering(VkRenderingFlagsKHR flags)
 {
-    resetCommandPools();
-
-    static const VkCommandBufferBeginInfo commandBufferBeginInfo{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-    VK_CHECK(vkBeginCommandBuffer(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], &commandBufferBeginInfo));
-
-    transitionAttachmentsStartOfFrame();
-
     static VkClearValue clearColor{
         .color = {0.14f, 0.68f, 0.23f, 1.0f}};
 
@@ -159,7 +180,7 @@ VkCommandBuffer VkFrame::render(const RenderManager& renderer)
     const VkRenderingInfoKHR renderingInfo{
         .sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
         .pNext = nullptr,
-        .flags = 0x0,
+        .flags = flags,
         .renderArea = renderArea,
         .layerCount = 1u,
         .viewMask = 0,
@@ -170,8 +191,80 @@ VkCommandBuffer VkFrame::render(const RenderManager& renderer)
     };
 
     m_pVkResources->vkCmdBeginRenderingKHR(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], &renderingInfo);
+}
+
+void VkFrame::beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    // Secondaries executed inside a dynamic rendering scope inherit the attachment formats instead of a render pass
+    const VkCommandBufferInheritanceRenderingInfoKHR inheritanceRenderingInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR,
+        .pNext = nullptr,
+        .flags = 0x0,
+        .viewMask = 0,
+        .colorAttachmentCount = 1u,
+        .pColorAttachmentFormats = &m_pVkResources->m_VkSwapchainImageFormat,
+        .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT};
+
+    const VkCommandBufferInheritanceInfo inheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &inheritanceRenderingInfo,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0u,
+        .framebuffer = VK_NULL_HANDLE};
+
+    const VkCommandBufferBeginInfo commandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo};
 
-    renderer.render(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER]);
+    VK_CHECK(vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
+}
+
+uint32_t VkFrame::cull(const SceneVisibility& visibility, const Frustum& frustum)
+{
+    // Only grows, so once it has seen the scene's object count culling never allocates
+    if (m_vVisibleObjects.size() < visibility.size())
+        m_vVisibleObjects.resize(visibility.size());
+
+    m_uVisibleObjectCount = visibility.cull(frustum, m_vVisibleObjects.data());
+    return m_uVisibleObjectCount;
+}
+
+uint32_t VkFrame::cull(const SceneVisibility& visibility, const Frustum& frustum, ThreadPool& threadPool)
+{
+    if (m_vVisibleObjects.size() < visibility.size())
+        m_vVisibleObjects.resize(visibility.size());
+
+    m_uVisibleObjectCount = visibility.cull(frustum, m_vVisibleObjects.data(), threadPool, m_CullScratch);
+    return m_uVisibleObjectCount;
+}
+
+uint32_t VkFrame::cullOccluded(const OcclusionCuller& occlusionCuller, const std::vector<Model>& models)
+{
+    m_uVisibleObjectCount = occlusionCuller.cullBy([&models](uint32_t model) -> const Bounds& { return models[model].m_WorldBounds; },
+                                                   m_vVisibleObjects.data(), m_uVisibleObjectCount);
+    return m_uVisibleObjectCount;
+}
+
+VkCommandBuffer VkFrame::render(const RenderManager& renderer)
+{
+    resetCommandPools();
+
+    static const VkCommandBufferBeginInfo commandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+    VK_CHECK(vkBeginCommandBuffer(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], &commandBufferBeginInfo));
+
+    transitionAttachmentsStartOfFrame();
+
+    beginRendering(0x0);
+
+    CommandRecorder recorder { m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], &m_InstanceBuffer, &m_IndirectBuffer };
+    renderer.render(recorder);
+    m_RecordStats = recorder.getStats();
 
     // {
     //     vkCmdBindPipeline(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
@@ -190,6 +283,76 @@ VkCommandBuffer VkFrame::render(const RenderManager& renderer)
     // }
 
 
+    m_pVkResources->vkCmdEndRenderingKHR(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER]);
+
+    transitionAttachmentsEndOfFrame();
+
+    VK_CHECK(vkEndCommandBuffer(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER]));
+
+    return m_VkCommandBuffers[COMMMAND_BUFFER_RENDER];
+}
+
+/**
+ * Parallel variant of render(). The sorted draw list is split into contiguous ranges, each recorded by a
+ * ThreadPool job into its own secondary command buffer (allocated from a per-job pool), and the primary only
+ * executes them inside the dynamic rendering scope. Requires init() with a non-zero recordingThreadCount.
+ */
+VkCommandBuffer VkFrame::render(const RenderManager& renderer, ThreadPool& threadPool)
+{
+    assert(!m_vVkSecondaryCommandBuffers.empty() && "VkFrame was initialized without recording threads!");
+
+    resetCommandPools();
+
+    static const VkCommandBufferBeginInfo commandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+    VK_CHECK(vkBeginCommandBuffer(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], &commandBufferBeginInfo));
+
+    transitionAttachmentsStartOfFrame();
+
+    beginRendering(VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR);
+
+    // Only the flat draw list can be split at arbitrary draws, the binned path is recorded as a single job
+    const uint32_t drawCount = renderer.getDrawCount();
+    uint32_t jobCount = 1u;
+
+    if (renderer.usesDrawList())
+    {
+        const uint32_t maxJobs = std::min(static_cast<uint32_t>(m_vVkSecondaryCommandBuffers.size()), threadPool.getThreadCount());
+        jobCount = std::clamp((drawCount + MIN_DRAWS_PER_RECORDING_JOB - 1u) / MIN_DRAWS_PER_RECORDING_JOB, 1u, maxJobs);
+    }
+
+    threadPool.parallelFor(jobCount, [&](uint32_t jobIdx) {
+        VkCommandBuffer commandBuffer = m_vVkSecondaryCommandBuffers[jobIdx];
+
+        beginSecondaryCommandBuffer(commandBuffer);
+
+        // Secondaries inherit no bound state, every job starts with a fresh tracker
+        CommandRecorder recorder { commandBuffer, &m_InstanceBuffer, &m_IndirectBuffer };
+
+        if (renderer.usesDrawList())
+        {
+            const uint32_t begin = static_cast<uint32_t>((static_cast<uint64_t>(drawCount) * jobIdx) / jobCount);
+            const uint32_t end = static_cast<uint32_t>((static_cast<uint64_t>(drawCount) * (jobIdx + 1u)) / jobCount);
+            renderer.render(recorder, begin, end);
+        }
+        else
+        {
+            renderer.render(recorder);
+        }
+
+        m_vSecondaryRecordStats[jobIdx] = recorder.getStats();
+
+        VK_CHECK(vkEndCommandBuffer(commandBuffer));
+    });
+
+    m_RecordStats = {};
+    for (uint32_t jobIdx = 0; jobIdx < jobCount; ++jobIdx)
+        m_RecordStats += m_vSecondaryRecordStats[jobIdx];
+
+    vkCmdExecuteCommands(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER], jobCount, m_vVkSecondaryCommandBuffers.data());
+
     m_pVkResources->vkCmdEndRenderingKHR(m_VkCommandBuffers[COMMMAND_BUFFER_RENDER]);
 
     transitionAttachmentsEndOfFrame();
@@ -2,13 +2,20 @@
 #define VK_FRAME_HPP
 
 #include <array>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
 #include "Model.hpp"
+#include "Buffer.hpp"
+#include "FrameArena.hpp"
 #include "Renderer/RenderManager.hpp"
+#include "Visibility/Frustum.hpp"
+#include "Visibility/OcclusionCuller.hpp"
+#include "Visibility/SceneVisibility.hpp"
 
 class VulkanResources;
+class ThreadPool;
 
 class VkFrame
 {
@@ -25,9 +32,20 @@ private:
         COMMMAND_BUFFER_RENDER = 0,
     };
 
+    // Below this many draws per secondary command buffer the per-buffer overhead outweighs the parallelism
+    static constexpr uint32_t MIN_DRAWS_PER_RECORDING_JOB = 256u;
+
+    // 64k VkDrawIndexedIndirectCommands per frame, runs that do not fit are drawn directly
+    static constexpr VkDeviceSize INDIRECT_BUFFER_SIZE = 65536u * sizeof(VkDrawIndexedIndirectCommand);
+
+    // 64k model matrices per frame
+    static constexpr VkDeviceSize INSTANCE_BUFFER_SIZE = 65536u * sizeof(glm::mat4);
+
     void resetCommandPools();
     void transitionAttachmentsStartOfFrame();
     void transitionAttachmentsEndOfFrame();
+    void beginRendering(VkRenderingFlagsKHR flags);
+    void beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
 
 public:
     static void setResources(VulkanResources* resources) { m_pVkResources = resources; }
@@ -35,16 +53,45 @@ public:
     VkFrame();
     // ~VkFrame();
 
-    void init();
+    // recordingThreadCount secondary command pools/buffers are created for render(renderer, threadPool)
+    void init(uint32_t recordingThreadCount = 0u);
     void cleanup();
 
     void setColorAttachment(VkImage image);
-    void cull();
+    // Fills m_vVisibleObjects with the ids of the objects inside frustum, returns their count
+    uint32_t cull(const SceneVisibility& visibility, const Frustum& frustum);
+    uint32_t cull(const SceneVisibility& visibility, const Frustum& frustum, ThreadPool& threadPool);
+    // Removes the models occlusionCuller hides from m_vVisibleObjects (ids are model indices),
+    // call after cull() and OcclusionCuller::end()
+    uint32_t cullOccluded(const OcclusionCuller& occlusionCuller, const std::vector<Model>& models);
     VkCommandBuffer render(const RenderManager& renderer);
+    VkCommandBuffer render(const RenderManager& renderer, ThreadPool& threadPool);
 
     std::array<VkCommandPool, 1> m_VkCommandPools;
     std::array<VkCommandBuffer, 1> m_VkCommandBuffers;
 
+    // One pool per recording job so no two threads ever record from the same pool
+    std::vector<VkCommandPool> m_vVkSecondaryCommandPools;
+    std::vector<VkCommandBuffer> m_vVkSecondaryCommandBuffers;
+    std::vector<CommandRecorder::Stats> m_vSecondaryRecordStats;
+
+    // Binds issued/elided and draws recorded by the last render()
+    CommandRecorder::Stats m_RecordStats;
+
+    // Indirect commands written while recording, only read by the GPU after this frame's fence was waited on
+    LinearBuffer m_IndirectBuffer;
+
+    // Per-instance model matrices gathered while recording, same lifetime as m_IndirectBuffer
+    LinearBuffer m_InstanceBuffer;
+
+    // Result of the last cull(), only the first m_uVisibleObjectCount entries are valid
+    std::vector<uint32_t> m_vVisibleObjects;
+    uint32_t m_uVisibleObjectCount = 0u;
+    FrustumCuller::ParallelScratch m_CullScratch;
+
+    // CPU side transient storage (render queue, sort keys) of the frame, reset once the fence signaled
+    FrameArena m_FrameArena;
+
     std::array<VkImage, 1> m_VkImageAttachments;
 
     VkSemaphore m_VkAcquireCompleteSemaphore;
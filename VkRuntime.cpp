@@ -24,12 +24,12 @@ VkCommandPool createCommandPool(VkDevice device, uint32_t graphicsQueueFamilyInd
     return commandPool;
 }
 
-VkCommandBuffer createCommandBuffer(VkDevice device, VkCommandPool pool)
+VkCommandBuffer createCommandBuffer(VkDevice device, VkCommandPool pool, VkCommandBufferLevel level)
 {
     const VkCommandBufferAllocateInfo commandBufferAllocateInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .commandPool = pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .level = level,
         .commandBufferCount = 1,
     };
 
@@ -5,7 +5,7 @@
 
 VkCommandPool createCommandPool(VkDevice device, uint32_t graphicsQueueFamilyIndex);
 
-VkCommandBuffer createCommandBuffer(VkDevice device, VkCommandPool pool);
+VkCommandBuffer createCommandBuffer(VkDevice device, VkCommandPool pool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
 VkFence createFence(VkDevice device, bool signaled = false);
 
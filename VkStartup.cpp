@@ -2,6 +2,9 @@
 #include "Buffer.hpp"
 #include "VkFrame.hpp"
 
+#include <algorithm>
+#include <string.h>
+
 namespace
 {
     VkInstance createInstance(const std::vector<const char *> &extensions, const std::vector<const char *> &layers)
@@ -35,22 +38,31 @@ namespace
         return surface;
     }
 
-    VkPhysicalDevice selectPhysicalDevice(VkInstance instance)
+    VkPhysicalDevice selectPhysicalDevice(VkInstance instance, const char *preferredDeviceName)
     {
         uint32_t numPhysicalDevices = 0;
         vkEnumeratePhysicalDevices(instance, &numPhysicalDevices, nullptr);
         VkPhysicalDevice *physicalDevices = new VkPhysicalDevice[numPhysicalDevices];
         vkEnumeratePhysicalDevices(instance, &numPhysicalDevices, physicalDevices);
 
+        assert(numPhysicalDevices > 0 && "no physical devices found");
+
+        uint32_t physDevIndex = std::min(2u, numPhysicalDevices - 1u);
+
         std::cout << "# Physical Devices: " << numPhysicalDevices << '\n';
         for (uint32_t i = 0; i < numPhysicalDevices; ++i)
         {
             VkPhysicalDeviceProperties props;
             vkGetPhysicalDeviceProperties(physicalDevices[i], &props);
             std::cout << i << " : " << props.deviceName << '\n';
+
+            if (preferredDeviceName != nullptr && strstr(props.deviceName, preferredDeviceName) != nullptr)
+            {
+                physDevIndex = i;
+                preferredDeviceName = nullptr;
+            }
         }
 
-        const uint32_t physDevIndex = 2u;
         std::cout << "\nUsing Physical Device " << physDevIndex << '\n';
 
         VkPhysicalDevice physicalDevice = physicalDevices[physDevIndex];
@@ -89,7 +101,24 @@ namespace
         return graphicsQueueFamilyIndex;
     }
 
-    VkDevice createDevice(VkPhysicalDevice physicalDevice, uint32_t graphicsQueueFamilyIndex, const std::vector<const char *> &deviceExtensions)
+    bool isDeviceExtensionSupported(VkPhysicalDevice physicalDevice, const char *extensionName)
+    {
+        uint32_t extensionCount = 0u;
+        VK_CHECK(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr));
+
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        VK_CHECK(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data()));
+
+        for (const VkExtensionProperties &extension : extensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    VkDevice createDevice(VkPhysicalDevice physicalDevice, uint32_t graphicsQueueFamilyIndex, const std::vector<const char *> &deviceExtensions, const VkPhysicalDeviceFeatures &enabledFeatures)
     {
 
         const float queuePriority = 1.0f;
@@ -119,7 +148,7 @@ namespace
             .ppEnabledLayerNames = nullptr,
             .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
             .ppEnabledExtensionNames = deviceExtensions.data(),
-            .pEnabledFeatures = nullptr};
+            .pEnabledFeatures = &enabledFeatures};
 
         VkDevice device;
         VK_CHECK(vkCreateDevice(physicalDevice, &createInfo, nullptr, &device));
@@ -331,9 +360,25 @@ void vulkanInit(const VulkanInitParams& initParams, VulkanResources& vkResources
     vkResources.m_VkSwapchainExtent = {initParams.m_uWindowWidth, initParams.m_uWindowHeight};
     vkResources.m_VkInstance = createInstance(initParams.m_vInstanceExtensions, initParams.m_vInstanceLayers);
     vkResources.m_VkSurface = createSurface(vkResources.m_VkInstance, initParams.m_Window);
-    vkResources.m_VkPhysicalDevice = selectPhysicalDevice(vkResources.m_VkInstance);
+    vkResources.m_VkPhysicalDevice = selectPhysicalDevice(vkResources.m_VkInstance, initParams.m_pPreferredDeviceName);
     vkResources.m_uGraphicsQueueFamilyIndex = selectGraphicsQueueFamilyIndex(vkResources.m_VkPhysicalDevice, vkResources.m_VkSurface);
-    vkResources.m_VkDevice = createDevice(vkResources.m_VkPhysicalDevice, vkResources.m_uGraphicsQueueFamilyIndex, initParams.m_vDeviceExtensions);
+
+    // The indirect draw path only uses these when present, they are never required
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(vkResources.m_VkPhysicalDevice, &supportedFeatures);
+
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+    std::vector<const char *> deviceExtensions = initParams.m_vDeviceExtensions;
+    const bool drawIndirectCount = isDeviceExtensionSupported(vkResources.m_VkPhysicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    if (drawIndirectCount)
+        deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+    vkResources.m_VkDevice = createDevice(vkResources.m_VkPhysicalDevice, vkResources.m_uGraphicsQueueFamilyIndex, deviceExtensions, enabledFeatures);
+    vkResources.m_bMultiDrawIndirect = (enabledFeatures.multiDrawIndirect == VK_TRUE);
+    vkResources.m_bDrawIndirectFirstInstance = (enabledFeatures.drawIndirectFirstInstance == VK_TRUE);
     vkResources.m_VkGraphicsQueue = createGraphicsQueue(vkResources.m_VkDevice, vkResources.m_uGraphicsQueueFamilyIndex);
     vkResources.m_VkSwapchain = createSwapchain(vkResources.m_VkPhysicalDevice, vkResources.m_VkSurface, vkResources.m_VkDevice, initParams.m_uRequestedSwapchainImageCount, vkResources.m_VkSwapchainImageFormat, vkResources.m_VkSwapchainExtent, initParams.m_VkPresentMode);
     getSwapchainImages(vkResources.m_VkDevice, vkResources.m_VkSwapchain, vkResources.m_VkSwapchainImages);
@@ -345,6 +390,7 @@ void vulkanInit(const VulkanInitParams& initParams, VulkanResources& vkResources
     vkResources.vkCmdEndRenderingKHR = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(vkResources.m_VkDevice, "vkCmdEndRenderingKHR"));
     vkResources.vkQueueSubmit2KHR = reinterpret_cast<PFN_vkQueueSubmit2KHR>(vkGetDeviceProcAddr(vkResources.m_VkDevice, "vkQueueSubmit2KHR"));
     vkResources.vkCmdPipelineBarrier2KHR = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(vkResources.m_VkDevice, "vkCmdPipelineBarrier2KHR"));
+    vkResources.vkCmdDrawIndexedIndirectCountKHR = drawIndirectCount ? reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(vkResources.m_VkDevice, "vkCmdDrawIndexedIndirectCountKHR")) : nullptr;
 
     StaticBuffer::init(&vkResources.m_VkDevice, &vkResources.m_VkPhysicalDeviceMemProps);
     StagingBuffer::init(&vkResources.m_VkDevice, vkResources.m_VkGraphicsQueue, vkResources.m_uGraphicsQueueFamilyIndex);
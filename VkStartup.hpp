@@ -21,6 +21,9 @@ struct VulkanInitParams
 
     uint32_t m_uRequestedSwapchainImageCount;
     VkPresentModeKHR m_VkPresentMode;
+
+    // Optional substring of the physical device name to use (e.g. "llvmpipe" for lavapipe)
+    const char *m_pPreferredDeviceName;
 };
 
 void vulkanInit(const VulkanInitParams& initParams, VulkanResources& vulkanResources);
@@ -1,4 +1,8 @@
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstdlib>
+#include <numeric>
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
@@ -8,10 +12,110 @@
 #include "VkDefines.hpp"
 #include "Loader.hpp"
 #include "Model.hpp"
+#include "AllocationCounter.hpp"
+#include "Visibility/Lod.hpp"
+#include "Renderer/GeometryPool.hpp"
+#include "Renderer/TexturePool.hpp"
+#include "Renderer/VertexLayout.hpp"
 
 
 #include "Renderer/RenderManager.hpp"
 
+namespace
+{
+    // Print the command recorder bind statistics every N frames, 0 disables it
+    constexpr uint32_t RECORD_STATS_INTERVAL = 600u;
+
+    // Frames until every frame arena and render queue array reached its steady-state size, after that
+    // submitting and sorting the render queue must not allocate (checked in debug builds)
+    constexpr uint32_t ALLOCATION_CHECK_WARMUP_FRAMES = 8u;
+
+    // Static BVH of the loaded models, rebuilt and rewritten whenever they change
+    constexpr const char* STATIC_BVH_CACHE = "static_bvh.bin";
+
+    // Every prototype's vertices and indices live in these two buffers, loading more than fits is fatal
+    constexpr VkDeviceSize GEOMETRY_POOL_VERTEX_BYTES = 64u << 20;
+    constexpr VkDeviceSize GEOMETRY_POOL_INDEX_BYTES = 32u << 20;
+
+    // Texture memory is allocated in blocks of this size, larger images get a block of their own
+    constexpr VkDeviceSize TEXTURE_POOL_BLOCK_BYTES = 64u << 20;
+
+    // RETAINED mode: hides the LOD 0 draws of a model, whole renderables or the meshlets shown in their place
+    void hideFullDetail(RenderManager& renderer, Model& model)
+    {
+        const ModelPrototype& prototype = *model.m_pPrototype;
+        for (uint32_t r = 0; r < prototype.m_Renderables.size(); ++r)
+        {
+            if (model.m_vSplitRenderables[r] == 0u)
+            {
+                renderer.setVisible(model.m_vDrawHandles[r], false);
+                continue;
+            }
+
+            for (uint32_t m = prototype.m_vFirstMeshlets[r]; m < prototype.m_vFirstMeshlets[r + 1u]; ++m)
+            {
+                if (model.m_vMeshletVisible[m] != 0u)
+                    renderer.setVisible(model.m_vMeshletHandles[m], false);
+                model.m_vMeshletVisible[m] = 0u;
+            }
+            model.m_vSplitRenderables[r] = 0u;
+        }
+    }
+
+    // RETAINED mode: hides the draws of the model's current LOD
+    void hideModel(RenderManager& renderer, Model& model)
+    {
+        if (model.m_uLod == 0u)
+        {
+            hideFullDetail(renderer, model);
+            return;
+        }
+
+        const uint32_t renderableCount = static_cast<uint32_t>(model.m_pPrototype->m_Renderables.size());
+        for (uint32_t r = 0; r < renderableCount; ++r)
+            renderer.setVisible(model.m_vDrawHandles[model.m_uLod * renderableCount + r], false);
+    }
+
+    // RETAINED mode, for a model shown at LOD 0: a renderable stays one draw while all of its meshlets pass the
+    // cluster culler, otherwise only the passing meshlets are drawn. Only handles whose visibility changed are touched.
+    void updateFullDetail(RenderManager& renderer, ClusterCuller& clusterCuller, Model& model, uint32_t* visibleMeshlets)
+    {
+        const ModelPrototype& prototype = *model.m_pPrototype;
+        for (uint32_t r = 0; r < prototype.m_Renderables.size(); ++r)
+        {
+            const uint32_t firstMeshlet = prototype.m_vFirstMeshlets[r];
+            const uint32_t meshletCount = prototype.getMeshletCount(r);
+            const uint32_t visibleMeshletCount = clusterCuller.cull(prototype.getMeshlets(r), meshletCount, model.m_m4Transform, visibleMeshlets);
+
+            const bool wasSplit = model.m_vSplitRenderables[r] != 0u;
+            const bool split = visibleMeshletCount != meshletCount;
+            if (split != wasSplit)
+                renderer.setVisible(model.m_vDrawHandles[r], !split);
+            model.m_vSplitRenderables[r] = split ? 1u : 0u;
+
+            if (!split && !wasSplit)
+                continue;
+
+            // Passing meshlets are shown and marked 2, then one pass hides the shown ones that did not pass
+            for (uint32_t m = 0; split && m < visibleMeshletCount; ++m)
+            {
+                uint8_t& state = model.m_vMeshletVisible[firstMeshlet + visibleMeshlets[m]];
+                if (state == 0u)
+                    renderer.setVisible(model.m_vMeshletHandles[firstMeshlet + visibleMeshlets[m]], true);
+                state = 2u;
+            }
+
+            for (uint32_t m = firstMeshlet; m < firstMeshlet + meshletCount; ++m)
+            {
+                uint8_t& state = model.m_vMeshletVisible[m];
+                if (state == 1u)
+                    renderer.setVisible(model.m_vMeshletHandles[m], false);
+                state = state == 2u ? 1u : 0u;
+            }
+        }
+    }
+}
+
 void appInit(AppResources &appResources, VulkanResources &vulkanResources)
 {
     glfwInit();
@@ -40,11 +144,19 @@ void appInit(AppResources &appResources, VulkanResources &vulkanResources)
 
     vulkanInitParams.m_uRequestedSwapchainImageCount = 2u;
     vulkanInitParams.m_VkPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    vulkanInitParams.m_pPreferredDeviceName = getenv("APP_DEVICE");
 
     vulkanInit(vulkanInitParams, vulkanResources);
 
+    CommandRecorder::initialize(vulkanResources.m_bMultiDrawIndirect, vulkanResources.m_bDrawIndirectFirstInstance, vulkanResources.vkCmdDrawIndexedIndirectCountKHR);
+    GeometryPool::create(GEOMETRY_POOL_VERTEX_BYTES, GEOMETRY_POOL_INDEX_BYTES, MESH_VERTEX_LAYOUT.getStride());
+    TexturePool::create(vulkanResources.m_VkDevice, vulkanResources.m_VkPhysicalDeviceMemProps, TEXTURE_POOL_BLOCK_BYTES);
+
+    // APP_SERIAL_RECORDING=1 records every draw on the main thread into the primary command buffer
+    appResources.m_bParallelRecording = (getenv("APP_SERIAL_RECORDING") == nullptr);
+
     for (VkFrame &frame : appResources.m_Frames)
-        frame.init();
+        frame.init(appResources.m_bParallelRecording ? appResources.m_ThreadPool.getThreadCount() : 0u);
 }
 
 void run(AppResources &appResources, VulkanResources &vulkanResources)
@@ -52,6 +164,19 @@ void run(AppResources &appResources, VulkanResources &vulkanResources)
     SceneResources sceneResources { vulkanResources.m_VkDevice, vulkanResources.m_VkSwapchainExtent, vulkanResources.m_VkSwapchainImageFormat };
 
     PipelineBin::initialize(&sceneResources.pipelineManger);
+    DrawList::initialize(&sceneResources.pipelineManger);
+
+    // Models are registered once and kept across frames by default, full detail ones switch between whole primitives
+    // and their visible meshlets.
+    // APP_INDIRECT_DRAWS=1 draws the pipeline bins through per-frame indirect command buffers,
+    // APP_IMMEDIATE_SUBMIT=1 resubmits every renderable into the sorted draw list each frame.
+    RenderMode renderMode = RenderMode::RETAINED;
+    if (getenv("APP_INDIRECT_DRAWS") != nullptr)
+        renderMode = RenderMode::INDIRECT;
+    else if (getenv("APP_IMMEDIATE_SUBMIT") != nullptr)
+        renderMode = RenderMode::SORTED;
+
+    sceneResources.renderer.setMode(renderMode);
 
     sceneResources.renderer.addSortBin(SortBinType::OPAQUE, { PIPELINE_DEFAULT } );
 
@@ -59,11 +184,115 @@ void run(AppResources &appResources, VulkanResources &vulkanResources)
 
 
 
-    std::vector<Model> models = processGLTF("../models/SimplePlane.gltf");
-    std::move(models.begin(), models.end(), std::back_inserter(sceneResources.m_vModels));
-    models.clear();
-    models = processGLTF("../models/Plane.gltf");
-    std::move(models.begin(), models.end(), std::back_inserter(sceneResources.m_vModels));
+    // Files decode in parallel on the pool, models are appended in list order. Compare the time of the first run
+    // (cooks every file) with the next ones (warm, read from the cooked files).
+    {
+        const auto loadStart = std::chrono::steady_clock::now();
+
+        GLTFBatchLoader loader(appResources.m_ThreadPool);
+        std::vector<std::future<std::vector<Model>>> loads = loader.load({ "../models/SimplePlane.gltf", "../models/Plane.gltf" });
+
+        for (std::future<std::vector<Model>>& load : loads)
+        {
+            std::vector<Model> models = load.get();
+            std::move(models.begin(), models.end(), std::back_inserter(sceneResources.m_vModels));
+        }
+
+        const std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+        std::cout << "Loaded " << sceneResources.m_vModels.size() << " models from " << loads.size() << " files in " << loadTime.count() << " ms" << std::endl;
+        std::cout << "Geometry pool: " << (GEOMETRY_POOL_VERTEX_BYTES - GeometryPool::getVertexBytesFree()) << " vertex and "
+                  << (GEOMETRY_POOL_INDEX_BYTES - GeometryPool::getIndexBytesFree()) << " index bytes used" << std::endl;
+        std::cout << "Texture pool: " << TexturePool::getTextureCount() << " textures, " << TexturePool::getBytesUsed() << " of "
+                  << TexturePool::getBytesAllocated() << " bytes in " << TexturePool::getBlockCount() << " blocks" << std::endl;
+    }
+
+    // Dynamic models go straight into the brute-force arrays, the static ones into the BVH,
+    // which is only rebuilt when the cache file was written for different models
+    std::vector<Bounds> staticBounds;
+    std::vector<uint32_t> staticModels;
+    for (uint32_t i = 0; i < sceneResources.m_vModels.size(); ++i)
+    {
+        const Model& model = sceneResources.m_vModels[i];
+        if (model.m_bDynamic)
+        {
+            sceneResources.visibility.addDynamic(i, model.m_WorldBounds);
+        }
+        else
+        {
+            staticBounds.push_back(model.m_WorldBounds);
+            staticModels.push_back(i);
+        }
+    }
+
+    StaticBvh& staticBvh = sceneResources.visibility.m_StaticBvh;
+    const uint64_t staticKey = StaticBvh::computeSourceKey(staticBounds.data(), staticModels.data(), static_cast<uint32_t>(staticModels.size()));
+    if (!staticBvh.load(STATIC_BVH_CACHE, staticKey))
+    {
+        staticBvh.build(staticBounds.data(), staticModels.data(), static_cast<uint32_t>(staticModels.size()), &appResources.m_ThreadPool);
+        if (!staticBvh.save(STATIC_BVH_CACHE, staticKey))
+            std::cerr << "Could not write " << STATIC_BVH_CACHE << std::endl;
+    }
+
+    // Per-frame scratch, reused so the visibility update does not allocate. modelVisibility marks the visible models
+    // and is cleared again by the same frame.
+    std::vector<uint8_t> modelVisibility(sceneResources.m_vModels.size(), 0u);
+
+    // RETAINED mode: the models shown last frame, every model starts out registered and shown
+    std::vector<uint32_t> shownModels(sceneResources.m_vModels.size());
+    std::iota(shownModels.begin(), shownModels.end(), 0u);
+    std::vector<uint32_t> modelLods(sceneResources.m_vModels.size(), 0u);
+
+    uint32_t maxMeshletCount = 0u;
+    for (const Model& model : sceneResources.m_vModels)
+    {
+        for (uint32_t r = 0; r < model.m_pPrototype->m_Renderables.size(); ++r)
+            maxMeshletCount = std::max(maxMeshletCount, model.m_pPrototype->getMeshletCount(r));
+    }
+    std::vector<uint32_t> visibleMeshlets(maxMeshletCount);
+
+    // Triangles of the visible models at their selected LOD and at LOD 0, for the stats print
+    uint32_t triangleCount = 0u;
+    uint32_t fullDetailTriangleCount = 0u;
+    uint32_t clusterCulledTriangleCount = 0u;
+
+    if (renderMode == RenderMode::RETAINED)
+    {
+        // Every LOD is registered up front, switching LODs is then only a visibility change
+        for (Model& model : sceneResources.m_vModels)
+        {
+            const ModelPrototype& prototype = *model.m_pPrototype;
+            for (uint32_t lod = 0; lod < prototype.getLodCount(); ++lod)
+            {
+                for (const Renderable& renderable : prototype.getRenderables(lod))
+                {
+                    const DrawList::Handle handle = sceneResources.renderer.addPersistentRenderable(SortBinType::OPAQUE, PIPELINE_DEFAULT, 0u, renderable, model.m_m4DrawTransform);
+                    if (lod != model.m_uLod)
+                        sceneResources.renderer.setVisible(handle, false);
+
+                    model.m_vDrawHandles.push_back(handle);
+                }
+            }
+
+            // LOD 0 can also be drawn per meshlet, those draws start hidden
+            for (uint32_t r = 0; r < prototype.m_Renderables.size(); ++r)
+            {
+                const Meshlet* meshlets = prototype.getMeshlets(r);
+                for (uint32_t m = 0; m < prototype.getMeshletCount(r); ++m)
+                {
+                    const Renderable renderable = prototype.getMeshletRenderable(r, meshlets[m]);
+                    const DrawList::Handle handle = sceneResources.renderer.addPersistentRenderable(SortBinType::OPAQUE, PIPELINE_DEFAULT, 0u, renderable, model.m_m4DrawTransform);
+                    sceneResources.renderer.setVisible(handle, false);
+
+                    model.m_vMeshletHandles.push_back(handle);
+                }
+            }
+
+            model.m_vMeshletVisible.assign(model.m_vMeshletHandles.size(), 0u);
+            model.m_vSplitRenderables.assign(prototype.m_Renderables.size(), 0u);
+        }
+    }
+
+    uint32_t frameCount = 0u;
 
     while (!glfwWindowShouldClose(appResources.m_Window))
     {
@@ -78,19 +307,163 @@ void run(AppResources &appResources, VulkanResources &vulkanResources)
 
         frame.setColorAttachment(vulkanResources.m_VkSwapchainImages[vulkanResources.m_uSwapchainImageIdx]);
 
-        // Cull - everything passes rn
-        for (const Model& model : sceneResources.m_vModels)
+        // The GPU is done with this frame, so is everything recorded from its arena
+        frame.m_FrameArena.reset();
+
+        const bool checkAllocations = frameCount >= ALLOCATION_CHECK_WARMUP_FRAMES;
+
         {
-            for (const Renderable& renderable : model.m_pPrototype->m_Renderables)
+            AllocationCounter::ScopedCheck allocationCheck { checkAllocations };
+
+            sceneResources.renderer.beginFrame(&frame.m_FrameArena);
+
+            const Frustum frustum = Frustum::fromViewProjection(sceneResources.m_m4ViewProjection);
+            frame.cull(sceneResources.visibility, frustum, appResources.m_ThreadPool);
+
+            // Visible occluders go into the depth buffer, then everything that passed the frustum is tested against it
+            OcclusionCuller& occlusionCuller = sceneResources.occlusionCuller;
+            occlusionCuller.begin(sceneResources.m_m4ViewProjection);
+            for (uint32_t i = 0; i < frame.m_uVisibleObjectCount; ++i)
             {
-                sceneResources.renderer.addRenderable(SortBinType::OPAQUE, PIPELINE_DEFAULT, 0u, renderable);
+                const Model& model = sceneResources.m_vModels[frame.m_vVisibleObjects[i]];
+                if (!model.m_pPrototype->m_Occluder.isEmpty())
+                    occlusionCuller.rasterize(model.m_pPrototype->m_Occluder, model.m_m4Transform);
             }
+            occlusionCuller.end();
+
+            const uint32_t visibleCount = frame.cullOccluded(occlusionCuller, sceneResources.m_vModels);
+
+            // LODs of the visible models, hidden models keep theirs until they show up again
+            triangleCount = 0u;
+            fullDetailTriangleCount = 0u;
+            for (uint32_t i = 0; i < visibleCount; ++i)
+            {
+                const uint32_t modelIndex = frame.m_vVisibleObjects[i];
+                const Model& model = sceneResources.m_vModels[modelIndex];
+                const ModelPrototype& prototype = *model.m_pPrototype;
+
+                modelLods[modelIndex] = Lod::select(Lod::getScreenSize(sceneResources.m_m4ViewProjection, model.m_WorldBounds), model.m_uLod, prototype.getLodCount());
+
+                triangleCount += prototype.getTriangleCount(modelLods[modelIndex]);
+                fullDetailTriangleCount += prototype.getTriangleCount(0u);
+            }
+
+            ClusterCuller& clusterCuller = sceneResources.clusterCuller;
+            clusterCuller.begin(sceneResources.m_m4ViewProjection);
+
+            if (renderMode != RenderMode::RETAINED)
+            {
+                for (uint32_t i = 0; i < visibleCount; ++i)
+                {
+                    Model& model = sceneResources.m_vModels[frame.m_vVisibleObjects[i]];
+                    model.m_uLod = modelLods[frame.m_vVisibleObjects[i]];
+                    const ModelPrototype& prototype = *model.m_pPrototype;
+
+                    if (model.m_uLod != 0u)
+                    {
+                        for (const Renderable& renderable : prototype.getRenderables(model.m_uLod))
+                            sceneResources.renderer.addRenderable(SortBinType::OPAQUE, PIPELINE_DEFAULT, 0u, renderable, model.m_m4DrawTransform);
+                        continue;
+                    }
+
+                    // Full detail draws only the meshlets that can be seen, primitives that are seen whole stay one draw
+                    for (uint32_t r = 0; r < prototype.m_Renderables.size(); ++r)
+                    {
+                        const Meshlet* meshlets = prototype.getMeshlets(r);
+                        const uint32_t meshletCount = prototype.getMeshletCount(r);
+                        const uint32_t visibleMeshletCount = clusterCuller.cull(meshlets, meshletCount, model.m_m4Transform, visibleMeshlets.data());
+
+                        if (visibleMeshletCount == meshletCount)
+                        {
+                            sceneResources.renderer.addRenderable(SortBinType::OPAQUE, PIPELINE_DEFAULT, 0u, prototype.m_Renderables[r], model.m_m4DrawTransform);
+                            continue;
+                        }
+
+                        for (uint32_t m = 0; m < visibleMeshletCount; ++m)
+                        {
+                            const Renderable renderable = prototype.getMeshletRenderable(r, meshlets[visibleMeshlets[m]]);
+                            sceneResources.renderer.addRenderable(SortBinType::OPAQUE, PIPELINE_DEFAULT, 0u, renderable, model.m_m4DrawTransform);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                // Retained draws stay registered, only models whose visibility or LOD flipped are touched. The cost
+                // scales with last frame's and this frame's visible lists, which are diffed, not with the scene.
+                for (uint32_t i = 0; i < visibleCount; ++i)
+                    modelVisibility[frame.m_vVisibleObjects[i]] = 1u;
+
+                for (const uint32_t modelIndex : shownModels)
+                {
+                    Model& model = sceneResources.m_vModels[modelIndex];
+                    if (modelVisibility[modelIndex] == 0u)
+                    {
+                        hideModel(sceneResources.renderer, model);
+                        model.m_bVisible = false;
+                    }
+                }
+
+                for (uint32_t i = 0; i < visibleCount; ++i)
+                {
+                    const uint32_t modelIndex = frame.m_vVisibleObjects[i];
+                    Model& model = sceneResources.m_vModels[modelIndex];
+                    modelVisibility[modelIndex] = 0u;
+
+                    const uint32_t lod = modelLods[modelIndex];
+                    if (model.m_bVisible && lod == model.m_uLod)
+                        continue;
+
+                    if (model.m_bVisible)
+                        hideModel(sceneResources.renderer, model);
+
+                    const uint32_t renderableCount = static_cast<uint32_t>(model.m_pPrototype->m_Renderables.size());
+                    for (uint32_t r = 0; r < renderableCount; ++r)
+                        sceneResources.renderer.setVisible(model.m_vDrawHandles[lod * renderableCount + r], true);
+
+                    model.m_bVisible = true;
+                    model.m_uLod = lod;
+                }
+
+                // Within the capacity reserved up front
+                shownModels.assign(frame.m_vVisibleObjects.begin(), frame.m_vVisibleObjects.begin() + visibleCount);
+
+                // Models that stay at full detail keep their meshlet draws, only the ones that flipped are touched
+                for (uint32_t i = 0; i < visibleCount; ++i)
+                {
+                    Model& model = sceneResources.m_vModels[frame.m_vVisibleObjects[i]];
+                    if (model.m_uLod == 0u)
+                        updateFullDetail(sceneResources.renderer, clusterCuller, model, visibleMeshlets.data());
+                }
+            }
+
+            const ClusterCuller::Stats& clusterStats = clusterCuller.getStats();
+            clusterCulledTriangleCount = clusterStats.m_uTriangles - clusterStats.m_uVisibleTriangles;
+
+            // Commits the retained changes, a no-op when nothing changed
+            sceneResources.renderer.sort();
         }
 
         // Render
-        VkCommandBuffer commandBuffer = frame.render(sceneResources.renderer);
+        VkCommandBuffer commandBuffer = appResources.m_bParallelRecording ? frame.render(sceneResources.renderer, appResources.m_ThreadPool)
+                                                                          : frame.render(sceneResources.renderer);
 
-        sceneResources.renderer.reset();
+        {
+            AllocationCounter::ScopedCheck allocationCheck { checkAllocations };
+            sceneResources.renderer.endFrame();
+        }
+
+        ++frameCount;
+
+        if (RECORD_STATS_INTERVAL != 0u && (frameCount % RECORD_STATS_INTERVAL) == 0u)
+        {
+            std::cout << "Draws: " << frame.m_RecordStats.m_uDraws
+                      << " | Binds issued: " << frame.m_RecordStats.m_uIssuedBinds
+                      << " | Binds elided: " << frame.m_RecordStats.m_uElidedBinds
+                      << " | Indirect commands: " << frame.m_RecordStats.m_uIndirectCommands
+                      << " | Triangles: " << triangleCount - clusterCulledTriangleCount << " of " << fullDetailTriangleCount << " at full detail"
+                      << " (" << clusterCulledTriangleCount << " culled per meshlet)" << '\n';
+        }
 
         const VkSemaphoreSubmitInfoKHR acquireCompleteSemaphoreSubmitInfo{
             .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR,
@@ -142,6 +515,9 @@ void cleanup(AppResources &appResources, VulkanResources &vulkanResources)
     for (VkFrame &frame : appResources.m_Frames)
         frame.cleanup();
 
+    // The models of run() are gone, and with them every prototype's allocation and texture
+    GeometryPool::destroy();
+    TexturePool::destroy();
     vulkanDestroy(vulkanResources);
 
     glfwDestroyWindow(appResources.m_Window);
@@ -1,14 +1,9 @@
 #version 450
 
 layout(location=0) in vec3 inPosition;
-
-layout(set=0 binding=0) uniform FrameUBO
-{
-   mat4 u_projectionMatrix;
-   mat4 u_viewMatrix;
-}
+layout(location=1) in mat4 inModelMatrix; // per instance, locations 1-4
 
 void main()
 {
-    gl_Position = u_projectionMatrix * u_viewMatrix * vec4(inPosition, 1.0f);
+    gl_Position = inModelMatrix * vec4(inPosition, 1.0f);
 }
\ No newline at end of file